@@ -0,0 +1,182 @@
+#pragma once
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+#if defined(__GLIBC__)
+#include <execinfo.h>
+#include <unistd.h>
+#define SNAKE_ALLOC_STACKS 1
+#endif
+
+// Heap allocation tracking per frame. Build with -DSNAKE_TRACK_ALLOCS and this header
+// replaces the global operator new/delete with counting versions, so it must end up in
+// exactly one translation unit (every variant is a single file, so including it is enough).
+// Without the define the hooks aren't compiled and every count reads zero.
+//
+// Frames are bracketed with beginFrame()/endFrame(steady). A steady frame is one of normal
+// gameplay after warm-up, where nothing should need the heap; the steady policy decides
+// whether an allocating steady frame is ignored, logged or aborts the process. With stack
+// capture on (glibc only) the call sites of a frame's first allocations are printed too.
+
+class AllocTracker {
+public:
+    enum SteadyPolicy { SteadyIgnore, SteadyLog, SteadyAbort };
+
+    static const int maxStacks = 8;    // Call sites kept per frame
+    static const int stackDepth = 24;
+    static const int historyFrames = 120;
+
+    struct FrameAllocs {
+        long allocations = 0;
+        long frees = 0;
+        long bytes = 0;
+    };
+
+    static AllocTracker& instance() {
+        static AllocTracker tracker;
+        return tracker;
+    }
+
+    static constexpr bool compiledIn() {
+#ifdef SNAKE_TRACK_ALLOCS
+        return true;
+#else
+        return false;
+#endif
+    }
+
+    void setSteadyPolicy(SteadyPolicy p) { policy = p; }
+
+    void setCaptureStacks(bool on) {
+#ifdef SNAKE_ALLOC_STACKS
+        // glibc loads the unwinder (and allocates) on the first backtrace; get that out of the way
+        void* warmup[1];
+        if (on) backtrace(warmup, 1);
+        captureStacks.store(on, std::memory_order_relaxed);
+#else
+        (void)on;
+#endif
+    }
+
+    void beginFrame() {
+        frameStart.allocations = allocations.load(std::memory_order_relaxed);
+        frameStart.frees = frees.load(std::memory_order_relaxed);
+        frameStart.bytes = bytes.load(std::memory_order_relaxed);
+        stackCount.store(0, std::memory_order_relaxed);
+        inFrame.store(true, std::memory_order_release);
+    }
+
+    void endFrame(bool steady) {
+        inFrame.store(false, std::memory_order_release);
+        last.allocations = allocations.load(std::memory_order_relaxed) - frameStart.allocations;
+        last.frees = frees.load(std::memory_order_relaxed) - frameStart.frees;
+        last.bytes = bytes.load(std::memory_order_relaxed) - frameStart.bytes;
+        history[head] = last.allocations;
+        head = (head + 1) % historyFrames;
+        frameNumber++;
+        framesSinceReport++;
+
+        if (steady && last.allocations > 0 && policy != SteadyIgnore) {
+            // Logging is rate limited; an abort always reports
+            if (policy == SteadyAbort || framesSinceReport >= 60) {
+                report(stderr);
+                framesSinceReport = 0;
+            }
+            if (policy == SteadyAbort) {
+                fprintf(stderr, "alloc: steady-state frame allocated, aborting\n");
+                abort();
+            }
+        }
+    }
+
+    const FrameAllocs& lastFrame() const { return last; }
+
+    // Most allocations of any frame in the recent window
+    long recentMax() const {
+        long m = 0;
+        for (long a : history) m = a > m ? a : m;
+        return m;
+    }
+
+    // Last frame's counts and, if captured, where its first allocations came from
+    void report(FILE* out) {
+        fprintf(out, "alloc: frame %ld made %ld allocations (%ld bytes), %ld frees\n", frameNumber, last.allocations,
+                last.bytes, last.frees);
+#ifdef SNAKE_ALLOC_STACKS
+        int count = stackCount.load(std::memory_order_relaxed);
+        if (count > maxStacks) count = maxStacks;
+        fflush(out);
+        for (int i = 0; i < count; ++i) {
+            fprintf(out, "  allocation %d, %zu bytes:\n", i + 1, stackSizes[i]);
+            fflush(out);
+            backtrace_symbols_fd(stacks[i] + 1, stackDepths[i] - 1, fileno(out));  // Skip recordAlloc itself
+        }
+        if (!captureStacks.load(std::memory_order_relaxed)) fprintf(out, "  (enable stack capture for call sites)\n");
+#endif
+    }
+
+    // Called from the replaced operator new/delete on any thread; must not allocate
+    void recordAlloc(size_t size) {
+        allocations.fetch_add(1, std::memory_order_relaxed);
+        bytes.fetch_add((long)size, std::memory_order_relaxed);
+#ifdef SNAKE_ALLOC_STACKS
+        if (!captureStacks.load(std::memory_order_relaxed) || !inFrame.load(std::memory_order_acquire)) return;
+        thread_local bool capturing = false;
+        if (capturing) return;
+        int slot = stackCount.fetch_add(1, std::memory_order_relaxed);
+        if (slot >= maxStacks) return;
+        capturing = true;
+        stackSizes[slot] = size;
+        stackDepths[slot] = backtrace(stacks[slot], stackDepth);
+        capturing = false;
+#endif
+    }
+
+    void recordFree() { frees.fetch_add(1, std::memory_order_relaxed); }
+
+private:
+    std::atomic<long> allocations{ 0 };
+    std::atomic<long> frees{ 0 };
+    std::atomic<long> bytes{ 0 };
+    std::atomic<bool> inFrame{ false };
+    std::atomic<bool> captureStacks{ false };
+    std::atomic<int> stackCount{ 0 };
+    void* stacks[maxStacks][stackDepth];
+    int stackDepths[maxStacks] = {};
+    size_t stackSizes[maxStacks] = {};
+
+    SteadyPolicy policy = SteadyIgnore;
+    FrameAllocs frameStart;
+    FrameAllocs last;
+    long history[historyFrames] = {};
+    int head = 0;
+    long frameNumber = 0;
+    long framesSinceReport = 60;
+};
+
+#ifdef SNAKE_TRACK_ALLOCS
+
+void* operator new(size_t size) {
+    AllocTracker::instance().recordAlloc(size);
+    if (void* p = malloc(size ? size : 1)) return p;
+    throw std::bad_alloc();
+}
+void* operator new[](size_t size) { return operator new(size); }
+void* operator new(size_t size, const std::nothrow_t&) noexcept {
+    AllocTracker::instance().recordAlloc(size);
+    return malloc(size ? size : 1);
+}
+void* operator new[](size_t size, const std::nothrow_t& tag) noexcept { return operator new(size, tag); }
+
+void operator delete(void* p) noexcept {
+    if (p) AllocTracker::instance().recordFree();
+    free(p);
+}
+void operator delete[](void* p) noexcept { operator delete(p); }
+void operator delete(void* p, size_t) noexcept { operator delete(p); }
+void operator delete[](void* p, size_t) noexcept { operator delete(p); }
+void operator delete(void* p, const std::nothrow_t&) noexcept { operator delete(p); }
+void operator delete[](void* p, const std::nothrow_t&) noexcept { operator delete(p); }
+
+#endif
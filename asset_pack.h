@@ -0,0 +1,225 @@
+#pragma once
+#include <SDL2/SDL.h>
+#include <vector>
+#include <string>
+#include <cstdio>
+#include <cstring>
+#include "png_codec.h"
+
+// Asset packs: only the files a build declares, each deflated, behind an index. The game
+// reads the index when it opens the pack and inflates an asset only when it's asked for,
+// so nothing it doesn't use gets decompressed. Written by pack_assets.cpp.
+//
+// Layout, all integers little-endian:
+//   "SNKP" version:u32 count:u32 indexBytes:u32
+//   count x { nameLength:u16 name offset:u32 packedSize:u32 size:u32 adler32:u32 method:u8 }
+//   asset data, each at its offset from the start of the file
+// Method 0 stores the bytes as they are, method 1 is a zlib stream. The checksum is of
+// the unpacked bytes.
+
+struct AssetPackEntry {
+    std::string name;
+    Uint32 offset;
+    Uint32 packedSize;
+    Uint32 size;
+    Uint32 adler;
+    Uint8 method;
+};
+
+enum AssetPackMethod { AssetStored = 0, AssetDeflated = 1 };
+
+inline Uint32 assetAdler32(const Uint8* data, size_t size) {
+    Uint32 a = 1, b = 0;
+    while (size) {
+        size_t block = size < 5552 ? size : 5552;  // Largest run before the sums can overflow
+        size -= block;
+        while (block--) {
+            a += *data++;
+            b += a;
+        }
+        a %= 65521;
+        b %= 65521;
+    }
+    return (b << 16) | a;
+}
+
+class AssetPack {
+public:
+    static const Uint32 version = 1;
+    static const size_t readChunk = 64 * 1024;
+    static const Uint32 maxIndexBytes = 16 * 1024 * 1024;
+
+    ~AssetPack() { close(); }
+
+    // Reads the header and index; asset data stays on disk until load()
+    bool open(const char* path) {
+        close();
+        file = fopen(path, "rb");
+        if (!file) return false;
+        Uint8 header[16];
+        if (fread(header, 1, 16, file) != 16 || memcmp(header, "SNKP", 4) != 0 || get32(header + 4) != version) {
+            fprintf(stderr, "assets: %s is not a version %u asset pack\n", path, version);
+            close();
+            return false;
+        }
+        Uint32 count = get32(header + 8);
+        Uint32 indexBytes = get32(header + 12);
+        // The header is untrusted: the index has to fit in the file before it's allocated
+        long length = fseek(file, 0, SEEK_END) == 0 ? ftell(file) : -1;
+        if (length < 16 || indexBytes > maxIndexBytes || indexBytes > (Uint64)length - 16 ||
+            fseek(file, 16, SEEK_SET) != 0) {
+            fprintf(stderr, "assets: %s has a bad index size\n", path);
+            close();
+            return false;
+        }
+        std::vector<Uint8> index(indexBytes);
+        if (fread(index.data(), 1, index.size(), file) != index.size()) {
+            close();
+            return false;
+        }
+        size_t pos = 0;
+        for (Uint32 i = 0; i < count; ++i) {
+            if (pos + 2 > index.size()) break;
+            size_t nameLength = index[pos] | (index[pos + 1] << 8);
+            pos += 2;
+            if (pos + nameLength + 17 > index.size()) break;
+            AssetPackEntry e;
+            e.name.assign((const char*)&index[pos], nameLength);
+            pos += nameLength;
+            e.offset = get32(&index[pos]);
+            e.packedSize = get32(&index[pos + 4]);
+            e.size = get32(&index[pos + 8]);
+            e.adler = get32(&index[pos + 12]);
+            e.method = index[pos + 16];
+            pos += 17;
+            entries.push_back(e);
+        }
+        if (entries.size() != count) {
+            fprintf(stderr, "assets: %s has a truncated index\n", path);
+            close();
+            return false;
+        }
+        return true;
+    }
+
+    void close() {
+        if (file) fclose(file);
+        file = nullptr;
+        entries.clear();
+    }
+
+    bool isOpen() const { return file != nullptr; }
+    const std::vector<AssetPackEntry>& list() const { return entries; }
+
+    const AssetPackEntry* find(const std::string& name) const {
+        for (const AssetPackEntry& e : entries) {
+            if (e.name == name) return &e;
+        }
+        return nullptr;
+    }
+
+    // Reads and unpacks one asset; false if it's missing or fails its checksum
+    bool load(const std::string& name, std::vector<Uint8>& data) {
+        const AssetPackEntry* e = find(name);
+        if (!e || !file) return false;
+        packed.resize(e->packedSize);
+        if (fseek(file, (long)e->offset, SEEK_SET) != 0) return false;
+        for (size_t done = 0; done < packed.size();) {
+            size_t want = packed.size() - done < readChunk ? packed.size() - done : readChunk;
+            size_t got = fread(packed.data() + done, 1, want, file);
+            if (!got) return false;
+            done += got;
+        }
+        if (e->method == AssetDeflated) {
+            PngDecoder inflater;
+            if (!inflater.decompress(packed.data(), packed.size(), data, e->size)) return false;
+        } else {
+            data.swap(packed);
+        }
+        if (data.size() != e->size || assetAdler32(data.data(), data.size()) != e->adler) {
+            fprintf(stderr, "assets: %s is corrupt\n", name.c_str());
+            return false;
+        }
+        return true;
+    }
+
+private:
+    FILE* file = nullptr;
+    std::vector<AssetPackEntry> entries;
+    std::vector<Uint8> packed;
+
+    static Uint32 get32(const Uint8* p) { return p[0] | (p[1] << 8) | (p[2] << 16) | ((Uint32)p[3] << 24); }
+};
+
+// Builds a pack in memory; pack_assets.cpp is the command-line front end
+class AssetPackWriter {
+public:
+    // Deflates the asset unless that doesn't save anything
+    void add(const std::string& name, const std::vector<Uint8>& data, bool compress = true) {
+        Asset a;
+        a.entry.name = name;
+        a.entry.size = (Uint32)data.size();
+        a.entry.adler = assetAdler32(data.data(), data.size());
+        a.entry.method = AssetStored;
+        if (compress && !data.empty()) {
+            PngEncoder deflater;
+            deflater.compress(data.data(), data.size(), a.bytes);
+            if (a.bytes.size() < data.size()) a.entry.method = AssetDeflated;
+        }
+        if (a.entry.method == AssetStored) a.bytes = data;
+        a.entry.packedSize = (Uint32)a.bytes.size();
+        assets.push_back(a);
+    }
+
+    std::vector<AssetPackEntry> list() const {
+        std::vector<AssetPackEntry> result;
+        for (const Asset& a : assets) result.push_back(a.entry);
+        return result;
+    }
+
+    bool write(const char* path) {
+        std::vector<Uint8> index;
+        for (const Asset& a : assets) index.insert(index.end(), 19 + a.entry.name.size(), 0);
+        Uint32 offset = 16 + (Uint32)index.size();
+        size_t pos = 0;
+        for (Asset& a : assets) {
+            a.entry.offset = offset;
+            offset += a.entry.packedSize;
+            index[pos] = (Uint8)a.entry.name.size();
+            index[pos + 1] = (Uint8)(a.entry.name.size() >> 8);
+            memcpy(&index[pos + 2], a.entry.name.data(), a.entry.name.size());
+            pos += 2 + a.entry.name.size();
+            put32(&index[pos], a.entry.offset);
+            put32(&index[pos + 4], a.entry.packedSize);
+            put32(&index[pos + 8], a.entry.size);
+            put32(&index[pos + 12], a.entry.adler);
+            index[pos + 16] = a.entry.method;
+            pos += 17;
+        }
+
+        FILE* f = fopen(path, "wb");
+        if (!f) return false;
+        Uint8 header[16];
+        memcpy(header, "SNKP", 4);
+        put32(header + 4, AssetPack::version);
+        put32(header + 8, (Uint32)assets.size());
+        put32(header + 12, (Uint32)index.size());
+        fwrite(header, 1, 16, f);
+        fwrite(index.data(), 1, index.size(), f);
+        for (const Asset& a : assets) fwrite(a.bytes.data(), 1, a.bytes.size(), f);
+        bool ok = ferror(f) == 0;
+        fclose(f);
+        return ok;
+    }
+
+private:
+    struct Asset {
+        AssetPackEntry entry;
+        std::vector<Uint8> bytes;
+    };
+    std::vector<Asset> assets;
+
+    static void put32(Uint8* p, Uint32 v) {
+        p[0] = (Uint8)v; p[1] = (Uint8)(v >> 8); p[2] = (Uint8)(v >> 16); p[3] = (Uint8)(v >> 24);
+    }
+};
@@ -0,0 +1,282 @@
+#pragma once
+#include <SDL2/SDL.h>
+#include <vector>
+#include <atomic>
+#include <mutex>
+#include <thread>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <algorithm>
+#ifdef __linux__
+#include <unistd.h>
+#endif
+
+// Long-session soak testing. Autopilot is a bot that steers a snake on a grid, wrap-around or walled:
+// breadth-first search to the nearest apple, taken only if the snake still fits in the space
+// left afterwards, otherwise the move into the largest open region; a snake that has gone
+// too long without eating takes the path regardless, so games can't stall into endless
+// circling. StressMonitor times
+// ticks and rendered frames and logs throughput, frame and tick times and memory growth
+// every few seconds; natively a watchdog thread aborts if no tick completes for a while, so
+// a hang late in a long game shows up as a report instead of a frozen window.
+
+class Autopilot {
+public:
+    enum Move { MoveUp, MoveDown, MoveLeft, MoveRight };  // Same order as the games' direction enums
+
+    Autopilot(int columns, int gridRows, int cellSize, bool wrapEdges = true)
+        : cols(columns), rows(gridRows), cell(cellSize), wrap(wrapEdges), blocked(columns * gridRows, 0), targets(columns * gridRows, 0),
+          firstMove(columns * gridRows, -1), visited(columns * gridRows, 0), stamp(0), lastLength(0), hungryMoves(0) {
+        queue.reserve(columns * gridRows);
+    }
+
+    // Start describing a new board
+    void clear() {
+        std::fill(blocked.begin(), blocked.end(), 0);
+        std::fill(targets.begin(), targets.end(), 0);
+    }
+
+    void block(float x, float y) { blocked[cellAt(x, y)] = 1; }
+    void target(float x, float y) { targets[cellAt(x, y)] = 1; }
+
+    // Next move for a snake of the given length whose head is at (x, y), or -1 when every
+    // neighbouring cell is blocked. The caller blocks the body but not the tail, which moves
+    // away on the next tick.
+    int choose(float x, float y, int length) {
+        int head = cellAt(x, y);
+        int toTarget = -1;
+        hungryMoves = length > lastLength ? 0 : hungryMoves + 1;
+        lastLength = length;
+
+        // Breadth-first search, remembering which first move led to each cell
+        stamp++;
+        queue.clear();
+        visited[head] = stamp;
+        for (int m = 0; m < 4; ++m) {
+            int n = neighbour(head, m);
+            if (n < 0 || blocked[n] || visited[n] == stamp) continue;
+            visited[n] = stamp;
+            firstMove[n] = m;
+            queue.push_back(n);
+        }
+        for (size_t i = 0; i < queue.size() && toTarget < 0; ++i) {
+            int c = queue[i];
+            if (targets[c]) {
+                toTarget = firstMove[c];
+                break;
+            }
+            for (int m = 0; m < 4; ++m) {
+                int n = neighbour(c, m);
+                if (n < 0 || blocked[n] || visited[n] == stamp) continue;
+                visited[n] = stamp;
+                firstMove[n] = firstMove[c];
+                queue.push_back(n);
+            }
+        }
+
+        if (toTarget >= 0 && (hungryMoves > 2 * cols * rows || regionSize(neighbour(head, toTarget), head, length) >= length)) {
+            return toTarget;
+        }
+
+        // No safe path to food: survive by heading into the most room
+        int best = -1, bestSize = -1;
+        for (int m = 0; m < 4; ++m) {
+            int n = neighbour(head, m);
+            if (n < 0 || blocked[n]) continue;
+            int size = regionSize(n, head, length);
+            if (size > bestSize) {
+                best = m;
+                bestSize = size;
+            }
+        }
+        return best;
+    }
+
+private:
+    int cols, rows, cell;
+    bool wrap;
+    std::vector<Uint8> blocked;
+    std::vector<Uint8> targets;
+    std::vector<int> firstMove;
+    std::vector<Uint32> visited;
+    std::vector<int> queue;
+    Uint32 stamp;
+    int lastLength;
+    int hungryMoves;  // Moves since the snake last grew
+
+    int cellAt(float x, float y) const {
+        int cx = ((int)x / cell % cols + cols) % cols;
+        int cy = ((int)y / cell % rows + rows) % rows;
+        return cy * cols + cx;
+    }
+
+    // -1 past a wall
+    int neighbour(int c, int move) const {
+        int x = c % cols, y = c / cols;
+        if (!wrap && ((move == MoveUp && y == 0) || (move == MoveDown && y == rows - 1) || (move == MoveLeft && x == 0) ||
+                      (move == MoveRight && x == cols - 1))) {
+            return -1;
+        }
+        switch (move) {
+            case MoveUp: y = (y + rows - 1) % rows; break;
+            case MoveDown: y = (y + 1) % rows; break;
+            case MoveLeft: x = (x + cols - 1) % cols; break;
+            default: x = (x + 1) % cols; break;
+        }
+        return y * cols + x;
+    }
+
+    // Open cells reachable from start without passing the head, counted up to limit
+    int regionSize(int start, int head, int limit) {
+        stamp++;
+        queue.clear();
+        visited[head] = stamp;
+        visited[start] = stamp;
+        queue.push_back(start);
+        for (size_t i = 0; i < queue.size() && (int)queue.size() < limit; ++i) {
+            for (int m = 0; m < 4; ++m) {
+                int n = neighbour(queue[i], m);
+                if (n < 0 || blocked[n] || visited[n] == stamp) continue;
+                visited[n] = stamp;
+                queue.push_back(n);
+            }
+        }
+        return (int)queue.size();
+    }
+};
+
+class StressMonitor {
+public:
+    ~StressMonitor() { stop(); }
+
+    // Run for the given number of seconds (0 = until stopped), logging every logSeconds
+    void start(double seconds, double logSeconds) {
+        durationSeconds = seconds;
+        logInterval = logSeconds > 0.0 ? logSeconds : 10.0;
+        startTicks = lastLog = SDL_GetPerformanceCounter();
+        startMemory = peakMemory = memoryBytes();
+        running = true;
+        printf("stress: started, %s, logging every %.0f s\n", seconds > 0.0 ? "timed" : "until stopped", logInterval);
+#ifndef __EMSCRIPTEN__
+        watchdog = std::thread([this] { watch(); });
+#endif
+    }
+
+    void stop() {
+        running = false;
+        if (watchdog.joinable()) watchdog.join();
+    }
+
+    bool active() const { return running; }
+
+    bool finished() const {
+        return durationSeconds > 0.0 && secondsSince(startTicks) >= durationSeconds;
+    }
+
+    void beginTick() { tickStart = SDL_GetPerformanceCounter(); }
+
+    void endTick() {
+        double us = toMs(SDL_GetPerformanceCounter() - tickStart) * 1000.0;
+        tickTotalUs += us;
+        tickMaxUs = std::max(tickMaxUs, us);
+        periodTicks++;
+        ticks.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    void frameRendered(double ms) {
+        frameTotalMs += ms;
+        frameMaxMs = std::max(frameMaxMs, ms);
+        periodFrames++;
+    }
+
+    void gameEnded(int length) {
+        games++;
+        bestLength = std::max(bestLength, length);
+    }
+
+    bool logDue() const { return secondsSince(lastLog) >= logInterval; }
+
+    // One log line; gameState carries the variant's own counters (length, obstacles, ...)
+    void log(const char* gameState) {
+        double period = secondsSince(lastLog);
+        long memory = memoryBytes();
+        peakMemory = std::max(peakMemory, memory);
+        long elapsed = (long)secondsSince(startTicks);
+        char line[512];
+        snprintf(line, sizeof(line),
+                 "stress t=%02ld:%02ld:%02ld ticks=%ld tick/s=%.0f tick_us=%.1f/%.1f frames=%ld frame_ms=%.2f/%.2f "
+                 "mem_mb=%.1f growth_mb=%+.1f peak_mb=%.1f games=%ld best=%d %s",
+                 elapsed / 3600, elapsed / 60 % 60, elapsed % 60, ticks.load(std::memory_order_relaxed),
+                 period > 0.0 ? periodTicks / period : 0.0, periodTicks ? tickTotalUs / periodTicks : 0.0, tickMaxUs,
+                 periodFrames, periodFrames ? frameTotalMs / periodFrames : 0.0, frameMaxMs, memory / 1048576.0,
+                 (memory - startMemory) / 1048576.0, peakMemory / 1048576.0, games, bestLength, gameState);
+        puts(line);
+        fflush(stdout);
+        {
+            std::lock_guard<std::mutex> lock(lastLineMutex);
+            snprintf(lastLine, sizeof(lastLine), "%s", line);
+        }
+        lastLog = SDL_GetPerformanceCounter();
+        periodTicks = periodFrames = 0;
+        tickTotalUs = tickMaxUs = frameTotalMs = frameMaxMs = 0.0;
+    }
+
+    // Resident memory natively, the wasm heap size in the browser
+    static long memoryBytes() {
+#if defined(__EMSCRIPTEN__)
+        return (long)__builtin_wasm_memory_size(0) * 65536;
+#elif defined(__linux__)
+        long pages = 0, resident = 0;
+        FILE* f = fopen("/proc/self/statm", "r");
+        if (!f) return 0;
+        if (fscanf(f, "%ld %ld", &pages, &resident) != 2) resident = 0;
+        fclose(f);
+        return resident * sysconf(_SC_PAGESIZE);
+#else
+        return 0;
+#endif
+    }
+
+private:
+    static const int stallSeconds = 10;
+
+    std::atomic<bool> running{ false };
+    std::atomic<long> ticks{ 0 };
+    double durationSeconds = 0.0;
+    double logInterval = 10.0;
+    Uint64 startTicks = 0;
+    Uint64 lastLog = 0;
+    Uint64 tickStart = 0;
+    long startMemory = 0;
+    long peakMemory = 0;
+    long periodTicks = 0;
+    long periodFrames = 0;
+    double tickTotalUs = 0.0, tickMaxUs = 0.0;
+    double frameTotalMs = 0.0, frameMaxMs = 0.0;
+    long games = 0;
+    int bestLength = 0;
+    std::thread watchdog;
+    std::mutex lastLineMutex;
+    char lastLine[512] = "";
+
+    static double toMs(Uint64 ticks) { return ticks * 1000.0 / (double)SDL_GetPerformanceFrequency(); }
+    static double secondsSince(Uint64 start) { return toMs(SDL_GetPerformanceCounter() - start) / 1000.0; }
+
+    void watch() {
+        long lastTicks = -1;
+        int stalled = 0;
+        while (running) {
+            std::this_thread::sleep_for(std::chrono::seconds(1));
+            long now = ticks.load(std::memory_order_relaxed);
+            stalled = now == lastTicks ? stalled + 1 : 0;
+            lastTicks = now;
+            if (stalled >= stallSeconds) {
+                std::lock_guard<std::mutex> lock(lastLineMutex);
+                fprintf(stderr, "stress: no tick finished in %d s, stuck after tick %ld\nstress: last report: %s\n",
+                        stallSeconds, now, lastLine);
+                abort();
+            }
+        }
+    }
+};
@@ -0,0 +1,304 @@
+#pragma once
+#include <SDL2/SDL.h>
+#include <vector>
+#include <string>
+#include <cstring>
+#include <cstdlib>
+#include <algorithm>
+
+// Pre-rasterized font: the printable ASCII glyphs at a few pixel sizes, baked offline from
+// arial.ttf by font_baker.cpp into one alpha atlas plus metrics. Drawing a string is one
+// SDL_RenderGeometry call of textured quads, so there's nothing to rasterize at runtime and
+// no SDL_ttf or FreeType in the build. Layout matches TTF_RenderText_Blended's, kerning
+// included, to within a pixel.
+//
+// File layout, all integers little-endian:
+//   "SNKF" version:u32 atlasWidth:u16 atlasHeight:u16 faceCount:u16
+//   faceCount x { pixelSize:u16 height:i16 ascent:i16 glyphCount:u16 kernCount:u16 spread:u8
+//                 glyphCount x { code:u8 x:u16 y:u16 w:u8 h:u8 left:i8 top:i8 advance:u8 }
+//                 kernCount x { first:u8 second:u8 amount:i8 } }
+//   atlasWidth * atlasHeight alpha bytes
+// left/top place the glyph's bitmap relative to the pen position and the line's top edge.
+// A face with a non-zero spread holds signed distances instead of coverage (drawn by
+// sdf_text.h, never by queue/draw here); version 1 files predate spread and have none.
+
+class BitmapFont {
+public:
+    static const Uint32 version = 2;
+    static const int firstChar = 32;
+    static const int lastChar = 126;
+
+    struct Glyph {
+        Uint8 code = 0;
+        Uint16 x = 0, y = 0;
+        Uint8 w = 0, h = 0;
+        Sint8 left = 0, top = 0;
+        Uint8 advance = 0;
+    };
+
+    struct Kerning {
+        Uint8 first, second;
+        Sint8 amount;
+    };
+
+    struct Face {
+        int pixelSize = 0;
+        int height = 0;
+        int ascent = 0;
+        int spread = 0;  // Distance field range in pixels, 0 for a coverage face
+        std::vector<Glyph> glyphs;
+        std::vector<Kerning> kerning;
+        Sint16 glyphIndex[128];  // Character to glyph, -1 if not baked
+        std::vector<Sint8> kernTable;  // Pair lookup built from kerning, 128 x 128
+
+        const Glyph* glyph(char c) const {
+            int i = (unsigned char)c < 128 ? glyphIndex[(unsigned char)c] : -1;
+            if (i < 0) i = glyphIndex['?'];
+            return i >= 0 ? &glyphs[i] : nullptr;
+        }
+
+        int kern(char a, char b) const {
+            return kernTable.empty() ? 0 : kernTable[((Uint8)a & 127) * 128 + ((Uint8)b & 127)];
+        }
+    };
+
+    int atlasWidth = 0, atlasHeight = 0;
+    std::vector<Uint8> atlas;  // One alpha byte per pixel
+    std::vector<Face> faces;
+
+    ~BitmapFont() { release(); }
+
+    // On failure the font is left empty rather than half-read
+    bool parse(const std::vector<Uint8>& data) {
+        faces.clear();
+        const Uint8* p = data.data();
+        const Uint8* end = p + data.size();
+        if (data.size() < 14 || memcmp(p, "SNKF", 4) != 0) return fail();
+        Uint32 fileVersion = get32(p + 4);
+        if (fileVersion < 1 || fileVersion > version) return fail();
+        int faceHeader = fileVersion >= 2 ? 11 : 10;
+        atlasWidth = get16(p + 8);
+        atlasHeight = get16(p + 10);
+        int faceCount = get16(p + 12);
+        p += 14;
+        for (int f = 0; f < faceCount; ++f) {
+            if (end - p < faceHeader) return fail();
+            Face face;
+            face.pixelSize = get16(p);
+            face.height = (Sint16)get16(p + 2);
+            face.ascent = (Sint16)get16(p + 4);
+            int glyphCount = get16(p + 6);
+            int kernCount = get16(p + 8);
+            face.spread = fileVersion >= 2 ? p[10] : 0;
+            p += faceHeader;
+            if (end - p < glyphCount * 10 + kernCount * 3) return fail();
+            for (int g = 0; g < glyphCount; ++g, p += 10) {
+                Glyph glyph;
+                glyph.code = p[0];
+                glyph.x = get16(p + 1);
+                glyph.y = get16(p + 3);
+                glyph.w = p[5];
+                glyph.h = p[6];
+                glyph.left = (Sint8)p[7];
+                glyph.top = (Sint8)p[8];
+                glyph.advance = p[9];
+                // rasterize() and the texture coordinates index the atlas with these, so they must fit
+                if (glyph.x + glyph.w > atlasWidth || glyph.y + glyph.h > atlasHeight) return fail();
+                face.glyphs.push_back(glyph);
+            }
+            for (int k = 0; k < kernCount; ++k, p += 3) face.kerning.push_back({ p[0], p[1], (Sint8)p[2] });
+            index(face);
+            faces.push_back(face);
+        }
+        if ((size_t)(end - p) != (size_t)atlasWidth * atlasHeight) return fail();
+        atlas.assign(p, p + (size_t)atlasWidth * atlasHeight);
+        return !faces.empty();
+    }
+
+    std::vector<Uint8> serialize() const {
+        std::vector<Uint8> out = { 'S', 'N', 'K', 'F' };
+        put32(out, version);
+        put16(out, (Uint16)atlasWidth);
+        put16(out, (Uint16)atlasHeight);
+        put16(out, (Uint16)faces.size());
+        for (const Face& face : faces) {
+            put16(out, (Uint16)face.pixelSize);
+            put16(out, (Uint16)face.height);
+            put16(out, (Uint16)face.ascent);
+            put16(out, (Uint16)face.glyphs.size());
+            put16(out, (Uint16)face.kerning.size());
+            out.push_back((Uint8)face.spread);
+            for (const Glyph& g : face.glyphs) {
+                out.push_back(g.code);
+                put16(out, g.x);
+                put16(out, g.y);
+                out.push_back(g.w);
+                out.push_back(g.h);
+                out.push_back((Uint8)g.left);
+                out.push_back((Uint8)g.top);
+                out.push_back(g.advance);
+            }
+            for (const Kerning& k : face.kerning) {
+                out.push_back(k.first);
+                out.push_back(k.second);
+                out.push_back((Uint8)k.amount);
+            }
+        }
+        out.insert(out.end(), atlas.begin(), atlas.end());
+        return out;
+    }
+
+    static void index(Face& face) {
+        for (Sint16& i : face.glyphIndex) i = -1;
+        for (size_t g = 0; g < face.glyphs.size(); ++g) face.glyphIndex[face.glyphs[g].code & 127] = (Sint16)g;
+        face.kernTable.assign(128 * 128, 0);
+        for (const Kerning& k : face.kerning) face.kernTable[(k.first & 127) * 128 + (k.second & 127)] = k.amount;
+    }
+
+    // The coverage face closest to the requested pixel size
+    const Face* face(int pixelSize) const {
+        const Face* best = nullptr;
+        for (const Face& f : faces) {
+            if (f.spread) continue;
+            if (!best || abs(f.pixelSize - pixelSize) < abs(best->pixelSize - pixelSize)) best = &f;
+        }
+        return best;
+    }
+
+    // The distance field face, if one was baked
+    const Face* sdfFace() const {
+        for (const Face& f : faces) {
+            if (f.spread) return &f;
+        }
+        return nullptr;
+    }
+
+    // Same box TTF_SizeText would report: pen advance by kerning-adjusted width, line height
+    void measure(const Face& f, const char* text, int& w, int& h) const {
+        int pen = 0, right = 0;
+        for (const char* c = text; *c; ++c) {
+            const Glyph* g = f.glyph(*c);
+            if (!g) continue;
+            if (c != text) pen += f.kern(c[-1], *c);
+            right = std::max(right, pen + g->left + g->w - f.spread);  // A distance field's padding isn't ink
+            pen += g->advance;
+        }
+        w = std::max(pen, right);
+        h = f.height;
+    }
+
+    // White-with-alpha copy of the atlas for drawing; colour comes from the vertices
+    bool upload(SDL_Renderer* renderer) {
+        release();
+        texture = SDL_CreateTexture(renderer, SDL_PIXELFORMAT_RGBA32, SDL_TEXTUREACCESS_STATIC, atlasWidth, atlasHeight);
+        if (!texture) return false;
+        std::vector<Uint8> rgba((size_t)atlasWidth * atlasHeight * 4, 255);
+        for (size_t i = 0; i < atlas.size(); ++i) rgba[i * 4 + 3] = atlas[i];
+        SDL_UpdateTexture(texture, nullptr, rgba.data(), atlasWidth * 4);
+        SDL_SetTextureBlendMode(texture, SDL_BLENDMODE_BLEND);
+        return true;
+    }
+
+    void release() {
+        if (texture) SDL_DestroyTexture(texture);
+        texture = nullptr;
+    }
+
+    // Callers pass {r, g, b} colours, whose alpha is 0; like SDL_ttf, take that as opaque
+    static SDL_Color opaqueIfUnset(SDL_Color c) {
+        if (c.a == 0) c.a = 255;
+        return c;
+    }
+
+    // Queue a string's quads with its top-left corner at (x, y); draw() submits everything queued
+    void queue(const Face& f, const char* text, int x, int y, SDL_Color color) {
+        color = opaqueIfUnset(color);
+        float u = 1.0f / atlasWidth, v = 1.0f / atlasHeight;
+        int pen = x;
+        for (const char* c = text; *c; ++c) {
+            const Glyph* g = f.glyph(*c);
+            if (!g) continue;
+            if (c != text) pen += f.kern(c[-1], *c);
+            if (g->w && g->h) {
+                float x0 = (float)(pen + g->left), y0 = (float)(y + g->top);
+                float x1 = x0 + g->w, y1 = y0 + g->h;
+                float s0 = g->x * u, t0 = g->y * v, s1 = (g->x + g->w) * u, t1 = (g->y + g->h) * v;
+                int base = (int)vertices.size();
+                vertices.push_back({ { x0, y0 }, color, { s0, t0 } });
+                vertices.push_back({ { x1, y0 }, color, { s1, t0 } });
+                vertices.push_back({ { x1, y1 }, color, { s1, t1 } });
+                vertices.push_back({ { x0, y1 }, color, { s0, t1 } });
+                const int quad[6] = { 0, 1, 2, 0, 2, 3 };
+                for (int i : quad) indices.push_back(base + i);
+            }
+            pen += g->advance;
+        }
+    }
+
+    // One draw call for everything queued since the last one
+    int draw(SDL_Renderer* renderer) {
+        if (indices.empty() || !texture) return 0;
+        SDL_RenderGeometry(renderer, texture, vertices.data(), (int)vertices.size(), indices.data(), (int)indices.size());
+        vertices.clear();
+        indices.clear();
+        return 1;
+    }
+
+    // CPU rendering, for the software rasterizer: an RGBA32 surface like TTF_RenderText_Blended's
+    SDL_Surface* rasterize(const Face& f, const char* text, SDL_Color color) const {
+        color = opaqueIfUnset(color);
+        int w, h;
+        measure(f, text, w, h);
+        SDL_Surface* surface = SDL_CreateRGBSurfaceWithFormat(0, std::max(w, 1), std::max(h, 1), 32, SDL_PIXELFORMAT_RGBA32);
+        if (!surface) return nullptr;
+        memset(surface->pixels, 0, (size_t)surface->pitch * surface->h);
+        int pen = 0;
+        for (const char* c = text; *c; ++c) {
+            const Glyph* g = f.glyph(*c);
+            if (!g) continue;
+            if (c != text) pen += f.kern(c[-1], *c);
+            for (int gy = 0; gy < g->h; ++gy) {
+                int sy = g->top + gy;
+                if (sy < 0 || sy >= surface->h) continue;
+                Uint8* row = (Uint8*)surface->pixels + (size_t)sy * surface->pitch;
+                const Uint8* src = &atlas[(size_t)(g->y + gy) * atlasWidth + g->x];
+                for (int gx = 0; gx < g->w; ++gx) {
+                    int sx = pen + g->left + gx;
+                    if (sx < 0 || sx >= surface->w || !src[gx]) continue;
+                    Uint8* px = row + sx * 4;
+                    Uint8 a = (Uint8)(src[gx] * color.a / 255);
+                    if (a <= px[3]) continue;  // Overlapping glyph edges keep the stronger coverage
+                    px[0] = color.r;
+                    px[1] = color.g;
+                    px[2] = color.b;
+                    px[3] = a;
+                }
+            }
+            pen += g->advance;
+        }
+        return surface;
+    }
+
+private:
+    SDL_Texture* texture = nullptr;
+    std::vector<SDL_Vertex> vertices;
+    std::vector<int> indices;
+
+    bool fail() {
+        faces.clear();
+        atlas.clear();
+        atlasWidth = atlasHeight = 0;
+        return false;
+    }
+
+    static Uint16 get16(const Uint8* p) { return (Uint16)(p[0] | (p[1] << 8)); }
+    static Uint32 get32(const Uint8* p) { return p[0] | (p[1] << 8) | (p[2] << 16) | ((Uint32)p[3] << 24); }
+    static void put16(std::vector<Uint8>& out, Uint16 v) {
+        out.push_back((Uint8)v);
+        out.push_back((Uint8)(v >> 8));
+    }
+    static void put32(std::vector<Uint8>& out, Uint32 v) {
+        put16(out, (Uint16)v);
+        put16(out, (Uint16)(v >> 16));
+    }
+};
@@ -0,0 +1,34 @@
+#pragma once
+#include <string>
+#include <cstdio>
+#ifdef __EMSCRIPTEN__
+#include <emscripten/emscripten.h>
+#endif
+
+// Writes a diagnostics file (traces, stats). Natively this is a plain file; in the browser,
+// where the filesystem is in memory, the data is offered as a download instead.
+inline bool exportFile(const char* fileName, const std::string& data, const char* mimeType = "application/octet-stream") {
+#ifdef __EMSCRIPTEN__
+    EM_ASM({
+        var blob = new Blob([UTF8ToString($0, $1)], { type: UTF8ToString($3) });
+        var link = document.createElement('a');
+        link.href = URL.createObjectURL(blob);
+        link.download = UTF8ToString($2);
+        document.body.appendChild(link);
+        link.click();
+        document.body.removeChild(link);
+        setTimeout(function() { URL.revokeObjectURL(link.href); }, 1000);
+    }, data.c_str(), (int)data.size(), fileName, mimeType);
+    return true;
+#else
+    (void)mimeType;
+    FILE* f = fopen(fileName, "wb");
+    if (!f) {
+        fprintf(stderr, "Failed to write %s\n", fileName);
+        return false;
+    }
+    fwrite(data.data(), 1, data.size(), f);
+    fclose(f);
+    return true;
+#endif
+}
@@ -0,0 +1,249 @@
+#include <SDL2/SDL.h>
+#include <SDL2/SDL_ttf.h>
+#include <vector>
+#include <string>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <algorithm>
+#include <cmath>
+#include "bitmap_font.h"
+
+// Offline font baker: rasterizes the glyphs the game can show (printable ASCII by default)
+// at the sizes it uses into one alpha atlas plus metrics and kerning, read back at runtime
+// by bitmap_font.h. Glyphs come from TTF_RenderText_Blended one character at a time, so the
+// atlas holds exactly the pixels SDL_ttf would have drawn.
+//
+//   font_baker [--font arial.ttf] [--sizes 20,24] [--sdf SIZE [--spread 6]] [--chars STRING]
+//              [-o font.atlas] [--ppm atlas.ppm]
+//
+// --sdf adds a signed distance field face rendered at SIZE for sdf_text.h, each glyph padded by
+// the spread; --sizes "" leaves the coverage faces out. --ppm also writes the atlas as an image
+// for a quick look.
+
+struct BakedGlyph {
+    BitmapFont::Glyph glyph;
+    std::vector<Uint8> alpha;  // glyph.w * glyph.h
+    int face;
+};
+
+// Crops one rendered character to its inked pixels
+bool bakeGlyph(TTF_Font* font, char c, BakedGlyph& out) {
+    int minx, maxx, miny, maxy, advance;
+    if (TTF_GlyphMetrics(font, (Uint16)(unsigned char)c, &minx, &maxx, &miny, &maxy, &advance) != 0) return false;
+    out.glyph.code = (Uint8)c;
+    out.glyph.advance = (Uint8)std::max(0, advance);
+    out.glyph.w = out.glyph.h = 0;
+    out.alpha.clear();
+
+    char text[2] = { c, 0 };
+    SDL_Surface* raw = TTF_RenderText_Blended(font, text, { 255, 255, 255, 255 });
+    if (!raw) return c == ' ';  // Blank glyphs may render nothing
+    SDL_Surface* surface = SDL_ConvertSurfaceFormat(raw, SDL_PIXELFORMAT_RGBA32, 0);
+    SDL_FreeSurface(raw);
+    if (!surface) return false;
+
+    int x0 = surface->w, y0 = surface->h, x1 = -1, y1 = -1;
+    for (int y = 0; y < surface->h; ++y) {
+        const Uint8* row = (const Uint8*)surface->pixels + (size_t)y * surface->pitch;
+        for (int x = 0; x < surface->w; ++x) {
+            if (!row[x * 4 + 3]) continue;
+            x0 = std::min(x0, x);
+            x1 = std::max(x1, x);
+            y0 = std::min(y0, y);
+            y1 = std::max(y1, y);
+        }
+    }
+    if (x1 >= 0) {
+        // SDL_ttf shifts a string right by the first glyph's negative bearing
+        out.glyph.left = (Sint8)(x0 + std::min(0, minx));
+        out.glyph.top = (Sint8)y0;
+        out.glyph.w = (Uint8)(x1 - x0 + 1);
+        out.glyph.h = (Uint8)(y1 - y0 + 1);
+        for (int y = y0; y <= y1; ++y) {
+            const Uint8* row = (const Uint8*)surface->pixels + (size_t)y * surface->pitch;
+            for (int x = x0; x <= x1; ++x) out.alpha.push_back(row[x * 4 + 3]);
+        }
+    }
+    SDL_FreeSurface(surface);
+    return true;
+}
+
+// Replaces a cropped glyph's coverage with its signed distance field, padded by spread on every
+// side: 128 on the outline, brighter inside, and spread pixels away saturates at 255 or 0.
+// Brute force over the spread window; it runs once per glyph offline.
+bool toDistanceField(BakedGlyph& g, int spread) {
+    int w = g.glyph.w, h = g.glyph.h;
+    if (!w || !h) return true;
+    int fw = w + 2 * spread, fh = h + 2 * spread;
+    if (fw > 255 || fh > 255) return false;
+    auto inside = [&](int x, int y) {
+        x -= spread;
+        y -= spread;
+        return x >= 0 && y >= 0 && x < w && y < h && g.alpha[(size_t)y * w + x] >= 128;
+    };
+    std::vector<Uint8> field((size_t)fw * fh);
+    for (int y = 0; y < fh; ++y) {
+        for (int x = 0; x < fw; ++x) {
+            bool in = inside(x, y);
+            int nearest = (spread + 1) * (spread + 1);
+            for (int dy = -spread; dy <= spread; ++dy) {
+                for (int dx = -spread; dx <= spread; ++dx) {
+                    int d2 = dx * dx + dy * dy;
+                    if (d2 < nearest && inside(x + dx, y + dy) != in) nearest = d2;
+                }
+            }
+            // The edge lies halfway between the two pixel centres
+            float d = std::min((float)spread, sqrtf((float)nearest) - 0.5f);
+            if (!in) d = -d;
+            field[(size_t)y * fw + x] = (Uint8)std::max(0, std::min(255, (int)lroundf(128.0f + d * 127.0f / spread)));
+        }
+    }
+    g.alpha.swap(field);
+    g.glyph.w = (Uint8)fw;
+    g.glyph.h = (Uint8)fh;
+    g.glyph.left = (Sint8)(g.glyph.left - spread);
+    g.glyph.top = (Sint8)(g.glyph.top - spread);
+    return true;
+}
+
+// Shelf packing, tallest glyphs first, one pixel apart so filtering never bleeds
+void packAtlas(std::vector<BakedGlyph>& glyphs, BitmapFont& font) {
+    const int width = 256;
+    std::vector<BakedGlyph*> order;
+    for (BakedGlyph& g : glyphs) order.push_back(&g);
+    std::stable_sort(order.begin(), order.end(), [](const BakedGlyph* a, const BakedGlyph* b) { return a->glyph.h > b->glyph.h; });
+    int x = 1, y = 1, shelf = 0;
+    for (BakedGlyph* g : order) {
+        if (!g->glyph.w) continue;
+        if (x + g->glyph.w + 1 > width) {
+            x = 1;
+            y += shelf + 1;
+            shelf = 0;
+        }
+        g->glyph.x = (Uint16)x;
+        g->glyph.y = (Uint16)y;
+        x += g->glyph.w + 1;
+        shelf = std::max(shelf, (int)g->glyph.h);
+    }
+    font.atlasWidth = width;
+    font.atlasHeight = (y + shelf + 1 + 3) & ~3;
+    font.atlas.assign((size_t)font.atlasWidth * font.atlasHeight, 0);
+    for (const BakedGlyph& g : glyphs) {
+        for (int row = 0; row < g.glyph.h; ++row) {
+            std::copy(g.alpha.begin() + row * g.glyph.w, g.alpha.begin() + (row + 1) * g.glyph.w,
+                      font.atlas.begin() + (size_t)(g.glyph.y + row) * font.atlasWidth + g.glyph.x);
+        }
+        font.faces[g.face].glyphs.push_back(g.glyph);
+    }
+}
+
+void writePpm(const char* path, const BitmapFont& font) {
+    FILE* f = fopen(path, "wb");
+    if (!f) return;
+    fprintf(f, "P6\n%d %d\n255\n", font.atlasWidth, font.atlasHeight);
+    for (Uint8 a : font.atlas) {
+        Uint8 rgb[3] = { a, a, a };
+        fwrite(rgb, 1, 3, f);
+    }
+    fclose(f);
+}
+
+int main(int argc, char* argv[]) {
+    std::string fontPath = "arial.ttf";
+    std::string output = "font.atlas";
+    std::string ppmPath;
+    std::vector<int> sizes = { 20, 24 };
+    int sdfSize = 0;
+    int spread = 6;
+    std::string chars;
+    for (int c = BitmapFont::firstChar; c <= BitmapFont::lastChar; ++c) chars += (char)c;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--font" && i + 1 < argc) fontPath = argv[++i];
+        else if (arg == "-o" && i + 1 < argc) output = argv[++i];
+        else if (arg == "--ppm" && i + 1 < argc) ppmPath = argv[++i];
+        else if (arg == "--chars" && i + 1 < argc) chars = argv[++i];
+        else if (arg == "--sdf" && i + 1 < argc) sdfSize = atoi(argv[++i]);
+        else if (arg == "--spread" && i + 1 < argc) spread = std::max(1, std::min(32, atoi(argv[++i])));
+        else if (arg == "--sizes" && i + 1 < argc) {
+            sizes.clear();
+            for (const char* p = argv[++i]; *p;) {
+                if (atoi(p) > 0) sizes.push_back(atoi(p));
+                while (*p && *p != ',') p++;
+                if (*p) p++;
+            }
+        } else {
+            std::cerr << "usage: font_baker [--font TTF] [--sizes 20,24] [--sdf SIZE [--spread PX]] [--chars STRING] [-o ATLAS] [--ppm IMAGE]\n";
+            return EXIT_FAILURE;
+        }
+    }
+    if (chars.find('?') == std::string::npos) chars += '?';  // Stand-in for anything not baked
+
+    if (TTF_Init() != 0) {
+        std::cerr << "TTF_Init failed: " << TTF_GetError() << "\n";
+        return EXIT_FAILURE;
+    }
+    BitmapFont baked;
+    std::vector<BakedGlyph> glyphs;
+    if (sdfSize > 0) sizes.push_back(sdfSize);  // Last, so it's the only face with a spread
+    if (sizes.empty()) {
+        std::cerr << "Nothing to bake\n";
+        return EXIT_FAILURE;
+    }
+    for (size_t s = 0; s < sizes.size(); ++s) {
+        int size = sizes[s];
+        bool sdf = sdfSize > 0 && s + 1 == sizes.size();
+        TTF_Font* font = TTF_OpenFont(fontPath.c_str(), size);
+        if (!font) {
+            std::cerr << "Can't open " << fontPath << " at " << size << " px: " << TTF_GetError() << "\n";
+            return EXIT_FAILURE;
+        }
+        BitmapFont::Face face;
+        face.pixelSize = size;
+        face.height = TTF_FontHeight(font);
+        face.ascent = TTF_FontAscent(font);
+        face.spread = sdf ? spread : 0;
+        for (char c : chars) {
+            BakedGlyph g;
+            g.face = (int)baked.faces.size();
+            if (!bakeGlyph(font, c, g)) {
+                std::cerr << "No glyph for '" << c << "' at " << size << " px\n";
+                continue;
+            }
+            if (sdf && !toDistanceField(g, spread)) {
+                std::cerr << "'" << c << "' at " << size << " px is too big for a distance field\n";
+                continue;
+            }
+            glyphs.push_back(g);
+        }
+        for (char a : chars) {
+            for (char b : chars) {
+                int k = TTF_GetFontKerningSizeGlyphs(font, (Uint16)(unsigned char)a, (Uint16)(unsigned char)b);
+                if (k) face.kerning.push_back({ (Uint8)a, (Uint8)b, (Sint8)std::max(-128, std::min(127, k)) });
+            }
+        }
+        baked.faces.push_back(face);
+        TTF_CloseFont(font);
+    }
+    TTF_Quit();
+
+    packAtlas(glyphs, baked);
+    for (BitmapFont::Face& face : baked.faces) BitmapFont::index(face);
+    std::vector<Uint8> data = baked.serialize();
+    FILE* f = fopen(output.c_str(), "wb");
+    if (!f || fwrite(data.data(), 1, data.size(), f) != data.size()) {
+        std::cerr << "Can't write " << output << "\n";
+        if (f) fclose(f);
+        return EXIT_FAILURE;
+    }
+    fclose(f);
+    if (!ppmPath.empty()) writePpm(ppmPath.c_str(), baked);
+
+    for (const BitmapFont::Face& face : baked.faces) {
+        printf("%3d px%s: %zu glyphs, %zu kerning pairs, line height %d\n", face.pixelSize, face.spread ? " sdf" : "",
+               face.glyphs.size(), face.kerning.size(), face.height);
+    }
+    printf("%s: %dx%d atlas, %zu bytes\n", output.c_str(), baked.atlasWidth, baked.atlasHeight, data.size());
+    return EXIT_SUCCESS;
+}
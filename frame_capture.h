@@ -0,0 +1,145 @@
+#pragma once
+#include <SDL2/SDL.h>
+#include <vector>
+#include <string>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <cstdio>
+#include <cstring>
+#include "png_codec.h"
+#include "trace_events.h"
+
+// Offscreen frame capture. Frames are read back into one of two staging slots and handed
+// to a background thread that encodes them as numbered PNGs or appends them to a raw RGBA
+// stream, so the game thread only pays for the readback itself. The raw stream plays back with
+//
+//   ffmpeg -f rawvideo -pix_fmt rgba -s 800x600 -r 60 -i capture.rgba capture.mp4
+
+enum CaptureFormat { CapturePNG, CaptureRaw };
+
+class FrameCapture {
+public:
+    FrameCapture() : width(0), height(0), format(CapturePNG), rawStream(nullptr), frameIndex(0),
+                     writeSlot(0), stopping(false), active(false) {}
+    ~FrameCapture() { close(); }
+
+    bool open(const std::string& outputPrefix, CaptureFormat fmt, int w, int h) {
+        close();
+        prefix = outputPrefix;
+        format = fmt;
+        width = w;
+        height = h;
+        frameIndex = 0;
+        writeSlot = 0;
+        stopping = false;
+        for (int i = 0; i < 2; ++i) {
+            slots[i].pixels.resize((size_t)w * h * 4);
+            slots[i].full = false;
+        }
+        if (format == CaptureRaw) {
+            rawStream = fopen((prefix + ".rgba").c_str(), "wb");
+            if (!rawStream) return false;
+        }
+        active = true;
+        encoder = std::thread([this] { encodeLoop(); });
+        return true;
+    }
+
+    bool isOpen() const { return active; }
+    int framesCaptured() const { return frameIndex; }
+
+    // Read the current render target back into the next free slot. Call before SDL_RenderPresent.
+    void capture(SDL_Renderer* renderer) {
+        Slot& slot = acquireSlot();
+        SDL_RenderReadPixels(renderer, nullptr, SDL_PIXELFORMAT_RGBA32, slot.pixels.data(), width * 4);
+        submitSlot();
+    }
+
+    // Capture from a CPU framebuffer (RGBA32 pixels, e.g. SoftFramebuffer::pixels)
+    void capture(const Uint32* pixels) {
+        Slot& slot = acquireSlot();
+        memcpy(slot.pixels.data(), pixels, slot.pixels.size());
+        submitSlot();
+    }
+
+    // Wait for queued frames to be written and stop the encoder thread
+    void close() {
+        if (!active) return;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stopping = true;
+        }
+        changed.notify_all();
+        encoder.join();
+        if (rawStream) fclose(rawStream);
+        rawStream = nullptr;
+        active = false;
+    }
+
+private:
+    struct Slot {
+        std::vector<Uint8> pixels;
+        int index = 0;
+        bool full = false;
+    };
+
+    int width, height;
+    CaptureFormat format;
+    std::string prefix;
+    FILE* rawStream;
+    int frameIndex;
+
+    Slot slots[2];
+    int writeSlot;
+    std::thread encoder;
+    std::mutex mutex;
+    std::condition_variable changed;
+    bool stopping;
+    bool active;
+
+    // Blocks only if the encoder is still busy with the frame from two captures ago
+    Slot& acquireSlot() {
+        std::unique_lock<std::mutex> lock(mutex);
+        changed.wait(lock, [this] { return !slots[writeSlot].full; });
+        return slots[writeSlot];
+    }
+
+    void submitSlot() {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            slots[writeSlot].index = frameIndex++;
+            slots[writeSlot].full = true;
+            writeSlot ^= 1;
+        }
+        changed.notify_all();
+    }
+
+    void encodeLoop() {
+        TraceRecorder::instance().setThreadName("capture encoder");
+        PngEncoder png;
+        int readSlot = 0;
+        char path[512];
+        for (;;) {
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                changed.wait(lock, [&] { return slots[readSlot].full || stopping; });
+                if (!slots[readSlot].full) return;  // Stopping with nothing left to write
+            }
+            Slot& slot = slots[readSlot];
+            TraceScope trace("encode frame");
+            if (format == CaptureRaw) {
+                fwrite(slot.pixels.data(), 1, slot.pixels.size(), rawStream);
+            } else {
+                snprintf(path, sizeof(path), "%s_%06d.png", prefix.c_str(), slot.index);
+                if (!png.write(path, slot.pixels.data(), width, height)) fprintf(stderr, "Failed to write %s\n", path);
+            }
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                slot.full = false;
+            }
+            changed.notify_all();
+            readSlot ^= 1;
+        }
+    }
+};
@@ -0,0 +1,213 @@
+#include <SDL2/SDL.h>
+#include <vector>
+#include <string>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <algorithm>
+#include <filesystem>
+#include "png_codec.h"
+
+// Golden-image regression harness. Builds every variant natively with the hooks from
+// native/harness_hooks.h, renders each scene in golden/scenes.txt headlessly at fixed
+// simulated times and compares the frames against golden/<variant>/<scene>_<ms>.png.
+// The render time of every captured frame is reported next to the diff, so a render
+// path speedup and its visual check come out of the same run.
+//
+//   golden_harness [--update] [--tolerance N] [--max-diff PCT] [--repeat N]
+//                  [--scenes golden/scenes.txt] [--cxx g++] [variant.cpp...]
+//
+// Run from the repository root (the variants load arial.ttf relative to it). --update
+// rewrites the goldens from the current output; review the PNGs before committing them.
+
+namespace fs = std::filesystem;
+
+const char* defaultVariants[] = {
+    "snake-game.cpp", "snake_fixed.cpp", "snake_fixedv3.cpp", "snake_game_v3_final.cpp", "snake_v5.cpp",
+    "snake_mini.cpp", "snakev11.cpp", "snake_gamev4.cpp", "snake_game_beta.cpp", "snake_game-v3.cpp",
+};
+
+struct Scene {
+    std::string name;
+    unsigned seed;
+    std::vector<unsigned> times;
+};
+
+struct Options {
+    bool update = false;
+    int tolerance = 8;         // Per-channel difference still counted as equal
+    double maxDiffPct = 0.1;   // Share of differing pixels allowed before a scene fails
+    int repeat = 3;            // Runs per scene; the median frame time is reported
+    std::string scenesPath = "golden/scenes.txt";
+    std::string cxx = "g++";
+    std::string outDir = "_golden_out";
+};
+
+bool loadScenes(const std::string& path, std::vector<Scene>& scenes) {
+    std::ifstream file(path);
+    if (!file) return false;
+    std::string line;
+    while (std::getline(file, line)) {
+        if (line.empty() || line[0] == '#') continue;
+        std::istringstream in(line);
+        Scene scene;
+        std::string times;
+        if (!(in >> scene.name >> scene.seed >> times)) continue;
+        std::istringstream list(times);
+        std::string t;
+        while (std::getline(list, t, ',')) scene.times.push_back((unsigned)strtoul(t.c_str(), nullptr, 10));
+        std::sort(scene.times.begin(), scene.times.end());
+        if (!scene.times.empty()) scenes.push_back(scene);
+    }
+    return true;
+}
+
+std::string stem(const std::string& source) {
+    return fs::path(source).stem().string();
+}
+
+bool buildVariant(const Options& opt, const std::string& source, const std::string& binary) {
+    std::string cmd = opt.cxx + " -O2 -std=c++17 -w -Inative -include native/harness_hooks.h " + source +
+                      " -o " + binary + " -lSDL2 -lSDL2_ttf -pthread > " + binary + ".log 2>&1";
+    return system(cmd.c_str()) == 0;
+}
+
+// Runs one scene and returns the frame time of each capture (empty on failure)
+std::vector<double> runScene(const std::string& binary, const Scene& scene, const std::string& prefix) {
+    std::string times;
+    for (unsigned t : scene.times) times += (times.empty() ? "" : ",") + std::to_string(t);
+    unsigned maxFrames = scene.times.back() / 16 + 120;  // Guard against a variant that never reaches the last time
+    std::string cmd = "SDL_VIDEODRIVER=dummy SDL_AUDIODRIVER=dummy SNAKE_HARNESS_SEED=" + std::to_string(scene.seed) +
+                      " SNAKE_HARNESS_TIMES=" + times + " SNAKE_HARNESS_OUT=" + prefix +
+                      " SNAKE_MAX_FRAMES=" + std::to_string(maxFrames) + " ./" + binary + " > " + prefix + ".log 2>&1";
+    std::vector<double> frameMs;
+    fs::remove(prefix + ".timing");
+    if (system(cmd.c_str()) != 0) return frameMs;
+    std::ifstream timing(prefix + ".timing");
+    unsigned t;
+    double ms;
+    while (timing >> t >> ms) frameMs.push_back(ms);
+    if (frameMs.size() != scene.times.size()) frameMs.clear();
+    return frameMs;
+}
+
+// Share of pixels (in percent) whose largest channel difference exceeds the tolerance,
+// or a negative value if the images can't be compared. Differing pixels are marked in red.
+double compareImages(const std::vector<Uint8>& a, const std::vector<Uint8>& b, int tolerance, std::vector<Uint8>& diff) {
+    if (a.size() != b.size() || a.empty()) return -1.0;
+    diff.resize(a.size());
+    size_t differing = 0;
+    for (size_t i = 0; i < a.size(); i += 4) {
+        int d = 0;
+        for (int c = 0; c < 3; ++c) d = std::max(d, abs((int)a[i + c] - (int)b[i + c]));
+        bool bad = d > tolerance;
+        differing += bad;
+        // Faded copy of the golden with mismatches highlighted
+        diff[i + 0] = bad ? 255 : (Uint8)(b[i + 0] / 4);
+        diff[i + 1] = bad ? 0 : (Uint8)(b[i + 1] / 4);
+        diff[i + 2] = bad ? 0 : (Uint8)(b[i + 2] / 4);
+        diff[i + 3] = 255;
+    }
+    return 100.0 * differing / (a.size() / 4);
+}
+
+int main(int argc, char* argv[]) {
+    Options opt;
+    std::vector<std::string> variants;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--update") opt.update = true;
+        else if (arg == "--tolerance" && i + 1 < argc) opt.tolerance = atoi(argv[++i]);
+        else if (arg == "--max-diff" && i + 1 < argc) opt.maxDiffPct = atof(argv[++i]);
+        else if (arg == "--repeat" && i + 1 < argc) opt.repeat = std::max(1, atoi(argv[++i]));
+        else if (arg == "--scenes" && i + 1 < argc) opt.scenesPath = argv[++i];
+        else if (arg == "--cxx" && i + 1 < argc) opt.cxx = argv[++i];
+        else if (arg[0] == '-') {
+            std::cerr << "usage: golden_harness [--update] [--tolerance N] [--max-diff PCT] [--repeat N]\n"
+                         "                      [--scenes FILE] [--cxx COMPILER] [variant.cpp...]\n";
+            return EXIT_FAILURE;
+        } else variants.push_back(arg);
+    }
+    if (variants.empty()) variants.assign(std::begin(defaultVariants), std::end(defaultVariants));
+
+    std::vector<Scene> scenes;
+    if (!loadScenes(opt.scenesPath, scenes) || scenes.empty()) {
+        std::cerr << "No scenes in " << opt.scenesPath << "\n";
+        return EXIT_FAILURE;
+    }
+    fs::create_directories(opt.outDir + "/bin");
+
+    int failures = 0;
+    printf("%-24s %-12s %8s %-8s %10s %10s\n", "variant", "scene", "time", "result", "diff %", "frame ms");
+    for (const std::string& source : variants) {
+        std::string name = stem(source);
+        std::string binary = opt.outDir + "/bin/" + name;
+        if (!buildVariant(opt, source, binary)) {
+            printf("%-24s %-12s %8s %-8s   (see %s.log)\n", name.c_str(), "-", "-", "NOBUILD", binary.c_str());
+            failures++;
+            continue;
+        }
+        fs::create_directories(opt.outDir + "/" + name);
+        if (opt.update) fs::create_directories("golden/" + name);  // Comparing never writes to golden/
+
+        for (const Scene& scene : scenes) {
+            std::string prefix = opt.outDir + "/" + name + "/" + scene.name;
+            std::vector<std::vector<double>> runs;
+            for (int r = 0; r < opt.repeat; ++r) {
+                std::vector<double> frameMs = runScene(binary, scene, prefix);
+                if (frameMs.empty()) break;
+                runs.push_back(frameMs);
+            }
+            if ((int)runs.size() < opt.repeat) {
+                printf("%-24s %-12s %8s %-8s   (see %s.log)\n", name.c_str(), scene.name.c_str(), "-", "NORUN", prefix.c_str());
+                failures++;
+                continue;
+            }
+
+            for (size_t k = 0; k < scene.times.size(); ++k) {
+                std::vector<double> samples;
+                for (const std::vector<double>& run : runs) samples.push_back(run[k]);
+                std::sort(samples.begin(), samples.end());
+                double median = samples[samples.size() / 2];
+
+                std::string file = scene.name + "_" + std::to_string(scene.times[k]) + ".png";
+                std::string output = opt.outDir + "/" + name + "/" + file;
+                std::string golden = "golden/" + name + "/" + file;
+                const char* result;
+                double diffPct = 0.0;
+                if (opt.update) {
+                    fs::copy_file(output, golden, fs::copy_options::overwrite_existing);
+                    result = "UPDATED";
+                } else {
+                    PngDecoder png;
+                    std::vector<Uint8> actual, expected, diff;
+                    int aw, ah, ew, eh;
+                    if (!png.read(golden.c_str(), expected, ew, eh)) {
+                        result = "NOGOLDEN";
+                        failures++;
+                    } else if (!png.read(output.c_str(), actual, aw, ah) || aw != ew || ah != eh) {
+                        result = "SIZE";
+                        failures++;
+                    } else {
+                        diffPct = compareImages(actual, expected, opt.tolerance, diff);
+                        if (diffPct > opt.maxDiffPct) {
+                            result = "FAIL";
+                            failures++;
+                            std::string diffPath = output.substr(0, output.size() - 4) + "_diff.png";
+                            PngEncoder().write(diffPath.c_str(), diff.data(), aw, ah);
+                        } else {
+                            result = "ok";
+                        }
+                    }
+                }
+                printf("%-24s %-12s %8u %-8s %10.3f %10.3f\n", name.c_str(), scene.name.c_str(), scene.times[k], result,
+                       diffPct, median);
+            }
+        }
+    }
+
+    if (failures) printf("\n%d failure(s); diff images are next to the output in %s/\n", failures, opt.outDir.c_str());
+    return failures ? EXIT_FAILURE : EXIT_SUCCESS;
+}
@@ -0,0 +1,227 @@
+#pragma once
+#include <SDL2/SDL.h>
+#include <vector>
+#include <string>
+#include <algorithm>
+#include <cstdio>
+#include "trace_events.h"
+#include "render_commands.h"
+#include "io_service.h"
+
+// Input-to-photon latency. Each turn key press is followed through the game loop:
+//
+//   key event -> turn queued -> tick that applies it -> first present after it
+//
+// and the three stage times plus the total are kept for the last few hundred turns. Presses
+// that change nothing (same or reversed direction) are counted as ignored, presses that found
+// the turn queue full as dropped, and the deepest the queue got is kept too. While the
+// TraceRecorder is recording, every turn becomes an async "turn latency" span. The total
+// ends when SDL_RenderPresent returns, so the compositor's and display's share isn't in it.
+
+class InputLatency {
+public:
+    static const int historySize = 512;
+    static const int maxPending = 8;
+
+    enum Stage { StageEvent, StageQueue, StageDisplay, StageTotal, StageCount };
+
+    struct Percentiles {
+        float p50, p95, p99, max;
+    };
+
+    InputLatency() : head(0), filled(0), pendingCount(0), ignored(0), droppedTurns(0), maxDepth(0), turns(0), recording(false) {
+        scratch.reserve(historySize);
+        for (int s = 0; s < StageCount; ++s) history[s].assign(historySize, 0.0f);
+    }
+
+    // A turn key went down. SDL stamps events in milliseconds when the OS delivered them;
+    // that age is added so time spent in the event queue counts too.
+    void keyDown(Uint32 eventTimestampMs) {
+        Uint64 now = SDL_GetPerformanceCounter();
+        Uint32 ageMs = SDL_GetTicks() - eventTimestampMs;
+        if (ageMs > 1000) ageMs = 0;  // Synthetic events carry no usable timestamp
+        pressTime = now - (Uint64)ageMs * SDL_GetPerformanceFrequency() / 1000;
+        pressPending = true;
+    }
+
+    // The press was checked against the turn queue: queued at the given depth, or ignored
+    void queued(bool accepted, int depth) {
+        if (!pressPending) return;
+        pressPending = false;
+        if (!accepted) {
+            ignored++;
+            return;
+        }
+        maxDepth = std::max(maxDepth, depth);
+        if (pendingCount == maxPending) return;
+        Pending& p = pending[pendingCount++];
+        p.pressed = pressTime;
+        p.queued = SDL_GetPerformanceCounter();
+        p.ticked = 0;
+        p.depth = depth;
+    }
+
+    // The press found the turn queue full
+    void dropped() {
+        pressPending = false;
+        droppedTurns++;
+    }
+
+    // A tick applied the oldest queued turn
+    void tick() {
+        for (int i = 0; i < pendingCount; ++i) {
+            if (!pending[i].ticked) {
+                pending[i].ticked = SDL_GetPerformanceCounter();
+                return;
+            }
+        }
+    }
+
+    // The queue was emptied (new game); its turns will never be applied
+    void clearPending() {
+        pendingCount = 0;
+        pressPending = false;
+    }
+
+    // A frame was presented: every consumed turn is now on screen
+    void presented() {
+        if (!pendingCount) return;
+        Uint64 now = SDL_GetPerformanceCounter();
+        int kept = 0;
+        for (int i = 0; i < pendingCount; ++i) {
+            Pending& p = pending[i];
+            if (!p.ticked) {
+                pending[kept++] = p;
+                continue;
+            }
+            record(p, now);
+        }
+        pendingCount = kept;
+    }
+
+    int sampleCount() const { return filled; }
+    long ignoredPresses() const { return ignored; }
+    long droppedPresses() const { return droppedTurns; }
+    int deepestQueue() const { return maxDepth; }
+
+    Percentiles percentiles(Stage stage) {
+        Percentiles r = { 0.0f, 0.0f, 0.0f, 0.0f };
+        if (!filled) return r;
+        scratch.assign(history[stage].begin(), history[stage].begin() + filled);
+        std::sort(scratch.begin(), scratch.end());
+        r.p50 = scratch[(size_t)(0.50f * (filled - 1) + 0.5f)];
+        r.p95 = scratch[(size_t)(0.95f * (filled - 1) + 0.5f)];
+        r.p99 = scratch[(size_t)(0.99f * (filled - 1) + 0.5f)];
+        r.max = scratch.back();
+        return r;
+    }
+
+    // Collect one CSV row per turn, written out by flushCsv()
+    void recordCsv(const std::string& path) {
+        csvPath = path;
+        csv = "turn,event_ms,queue_ms,display_ms,total_ms,depth\n";
+        recording = true;
+    }
+
+    void flushCsv() {
+        if (recording) exportFileAsync(csvPath.c_str(), csv, "text/csv");
+    }
+
+    // Percentile lines and a histogram of total latency, for the profiler overlay
+    static const int panelWidth = 370;
+    static const int panelHeight = 3 * 26 + 40 + 48;
+
+    void draw(RenderCommandBuffer& cmd, int x, int y) {
+        const int lineHeight = 26;
+        const int barHeight = 40;
+        if (--framesUntilRefresh <= 0) {
+            refresh();
+            framesUntilRefresh = 15;
+        }
+        cmd.setLayer(LayerOverlay);
+        cmd.fillRect({ x, y, panelWidth, panelHeight }, { 10, 10, 20, 255 });
+        cmd.rect({ x, y, panelWidth, panelHeight }, { 0, 255, 255, 255 });
+        for (int i = 0; i < 3; ++i) {
+            SDL_Color c = i == 0 ? SDL_Color{ 255, 255, 255, 255 } : i == 1 ? SDL_Color{ 180, 180, 180, 255 } : SDL_Color{ 255, 180, 0, 255 };
+            cmd.text(lines[i], x + 8, y + 8 + i * lineHeight, c, 0);
+        }
+
+        int baseY = y + 16 + 3 * lineHeight + barHeight;
+        int barWidth = (panelWidth - 16) / buckets;
+        for (int b = 0; b < buckets; ++b) {
+            int h = bucketCounts[b] * barHeight / std::max(1, mostInBucket);
+            SDL_Color c = b * bucketMs < 50 ? SDL_Color{ 0, 200, 0, 255 } : b * bucketMs < 100 ? SDL_Color{ 220, 200, 0, 255 } : SDL_Color{ 255, 40, 40, 255 };
+            if (h) cmd.fillRect({ x + 8 + b * barWidth, baseY - h, barWidth - 2, h }, c);
+        }
+        cmd.text(lines[3], x + 8, baseY + 2, { 120, 120, 120, 255 }, 0);
+    }
+
+private:
+    struct Pending {
+        Uint64 pressed;
+        Uint64 queued;
+        Uint64 ticked;
+        int depth;  // Queue depth including this turn
+    };
+
+    std::vector<float> history[StageCount];
+    std::vector<float> scratch;
+    int head;
+    int filled;
+    Pending pending[maxPending];
+    int pendingCount;
+    Uint64 pressTime = 0;
+    bool pressPending = false;
+    long ignored;
+    long droppedTurns;
+    int maxDepth;
+    long turns;
+    bool recording;
+    std::string csvPath;
+    std::string csv;
+
+    static const int bucketMs = 10;
+    static const int buckets = 12;  // 0-120 ms, the last bucket holds everything slower
+    int bucketCounts[buckets] = {};
+    int mostInBucket = 0;
+    std::string lines[4];
+    int framesUntilRefresh = 0;
+
+    void refresh() {
+        char buf[128];
+        Percentiles total = percentiles(StageTotal);
+        snprintf(buf, sizeof(buf), "input %.1f/%.1f/%.1f ms", total.p50, total.p95, total.p99);
+        lines[0] = buf;
+        Percentiles event = percentiles(StageEvent), queue = percentiles(StageQueue), display = percentiles(StageDisplay);
+        snprintf(buf, sizeof(buf), "event %.1f queue %.1f show %.1f", event.p50, queue.p50, display.p50);
+        lines[1] = buf;
+        snprintf(buf, sizeof(buf), "turns %ld drop %ld ign %ld depth %d", turns, droppedTurns, ignored, maxDepth);
+        lines[2] = buf;
+        snprintf(buf, sizeof(buf), "0 .. %d+ ms", bucketMs * (buckets - 1));
+        lines[3] = buf;
+
+        std::fill(bucketCounts, bucketCounts + buckets, 0);
+        mostInBucket = 0;
+        for (int i = 0; i < filled; ++i) {
+            int b = std::min(buckets - 1, (int)(history[StageTotal][i] / bucketMs));
+            mostInBucket = std::max(mostInBucket, ++bucketCounts[b]);
+        }
+    }
+
+    static float toMs(Uint64 ticks) { return (float)(ticks * 1000.0 / (double)SDL_GetPerformanceFrequency()); }
+
+    void record(const Pending& p, Uint64 shown) {
+        float stages[StageCount] = { toMs(p.queued - p.pressed), toMs(p.ticked - p.queued), toMs(shown - p.ticked),
+                                     toMs(shown - p.pressed) };
+        for (int s = 0; s < StageCount; ++s) history[s][head] = stages[s];
+        head = (head + 1) % historySize;
+        if (filled < historySize) filled++;
+        turns++;
+        TraceRecorder::instance().async("turn latency", (Uint32)turns, p.pressed, shown);
+        if (recording) {
+            char row[112];
+            snprintf(row, sizeof(row), "%ld,%.3f,%.3f,%.3f,%.3f,%d\n", turns, stages[0], stages[1], stages[2], stages[3], p.depth);
+            csv += row;
+        }
+    }
+};
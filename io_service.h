@@ -0,0 +1,213 @@
+#pragma once
+#include <SDL2/SDL.h>
+#include <atomic>
+#include <deque>
+#include <functional>
+#include <string>
+#include <cstdio>
+#if !defined(__EMSCRIPTEN__) || defined(__EMSCRIPTEN_PTHREADS__)
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#define SNAKE_IO_THREAD 1
+#endif
+#include "trace_events.h"
+#include "file_export.h"
+
+// Background I/O. Anything that touches storage (score saves, render-command dumps, trace and
+// stats exports) is submitted as a job and runs on one worker thread in submission order; its
+// completion callback runs later on the game thread, from poll(). Submitting is a lock-free
+// push, so the game thread never waits on the disk or on the worker.
+//
+// Emscripten builds without pthreads have no worker: poll() runs queued jobs itself, stopping
+// once its per-frame time slice is used up (a single job is never split), so storage work is
+// spread over frames instead of landing on one.
+//
+//   IoService::instance().submit("save", [data] { return write(data); }, [](bool ok) { ... });
+//   ...
+//   IoService::instance().poll();  // once per frame
+
+typedef std::function<bool()> IoWork;
+typedef std::function<void(bool ok)> IoDone;
+
+class IoService {
+public:
+    static IoService& instance() {
+        static IoService service;
+        return service;
+    }
+
+    // Queues work; done (optional) gets its result on the game thread
+    void submit(const char* name, IoWork work, IoDone done = nullptr) {
+        Job* job = new Job{ name, std::move(work), std::move(done), false, nullptr };
+        outstanding.fetch_add(1);
+        push(submitted, job);
+#ifdef SNAKE_IO_THREAD
+        // Pairs with workLoop(): the seq_cst push and the seq_cst stores and loads of sleeping
+        // mean either we see the worker asleep or its wait predicate sees this job
+        if (sleeping.load(std::memory_order_seq_cst)) {
+            std::lock_guard<std::mutex> lock(sleepMutex);
+            wake.notify_one();
+        }
+#endif
+    }
+
+    // Plain file write on the I/O thread
+    void writeFile(const std::string& path, std::string data, IoDone done = nullptr) {
+        submit("write file", [path, data = std::move(data)] {
+            FILE* f = fopen(path.c_str(), "wb");
+            if (!f) {
+                fprintf(stderr, "io: can't write %s\n", path.c_str());
+                return false;
+            }
+            bool ok = fwrite(data.data(), 1, data.size(), f) == data.size();
+            return fclose(f) == 0 && ok;
+        }, std::move(done));
+    }
+
+    // Game thread, once per frame: runs completion callbacks (and, without a worker, the jobs)
+    void poll(float sliceMs = 2.0f) {
+#ifndef SNAKE_IO_THREAD
+        for (Job* job = takeAll(submitted); job; job = job->next) backlog.push_back(job);
+        Uint64 start = SDL_GetPerformanceCounter();
+        Uint64 slice = (Uint64)(sliceMs * SDL_GetPerformanceFrequency() / 1000.0f);
+        while (!backlog.empty()) {
+            Job* job = backlog.front();
+            backlog.pop_front();
+            execute(job);
+            if (SDL_GetPerformanceCounter() - start >= slice) break;
+        }
+#else
+        (void)sliceMs;
+#endif
+        for (Job* job = takeAll(completed); job;) {
+            Job* next = job->next;
+            if (job->done) job->done(job->ok);
+            delete job;
+            outstanding.fetch_sub(1);
+            job = next;
+        }
+    }
+
+    // Jobs submitted and not yet reported back through poll()
+    int pending() const { return outstanding.load(); }
+
+    // Blocks until everything queued so far has run and been reported (exit paths, tools)
+    void flush() {
+        while (pending() > 0) {
+            poll(1000.0f);
+            if (pending() > 0) SDL_Delay(1);
+        }
+    }
+
+    ~IoService() {
+#ifdef SNAKE_IO_THREAD
+        {
+            std::lock_guard<std::mutex> lock(sleepMutex);
+            stopping.store(true);
+        }
+        wake.notify_one();
+        if (worker.joinable()) worker.join();
+#else
+        for (Job* job = takeAll(submitted); job; job = job->next) backlog.push_back(job);
+        for (Job* job : backlog) execute(job);
+#endif
+        // Callbacks of jobs that finish during shutdown are dropped; the game is gone by now
+        for (Job* job = takeAll(completed); job;) {
+            Job* next = job->next;
+            delete job;
+            job = next;
+        }
+    }
+
+private:
+    struct Job {
+        const char* name;
+        IoWork work;
+        IoDone done;
+        bool ok;
+        Job* next;
+    };
+
+    // Both queues are intrusive stacks: producers push with a CAS, the one consumer takes the
+    // whole stack with an exchange and reverses it back into submission order
+    std::atomic<Job*> submitted{ nullptr };
+    std::atomic<Job*> completed{ nullptr };
+    std::atomic<int> outstanding{ 0 };
+    std::deque<Job*> backlog;  // Cooperative mode: taken but not yet run
+
+#ifdef SNAKE_IO_THREAD
+    std::thread worker;
+    std::mutex sleepMutex;
+    std::condition_variable wake;
+    std::atomic<bool> sleeping{ false };
+    std::atomic<bool> stopping{ false };
+
+    IoService() {
+        TraceRecorder::instance();  // Constructed first so it outlives the worker's last job
+        worker = std::thread([this] { workLoop(); });
+    }
+
+    void workLoop() {
+        TraceRecorder::instance().setThreadName("io");
+        for (;;) {
+            Job* batch = takeAll(submitted);
+            if (!batch) {
+                std::unique_lock<std::mutex> lock(sleepMutex);
+                if (stopping.load() && !submitted.load()) return;
+                sleeping.store(true, std::memory_order_seq_cst);
+                wake.wait(lock, [this] { return submitted.load() != nullptr || stopping.load(); });
+                sleeping.store(false, std::memory_order_seq_cst);
+                continue;
+            }
+            while (batch) {
+                Job* next = batch->next;
+                execute(batch);
+                batch = next;
+            }
+        }
+    }
+#else
+    IoService() { TraceRecorder::instance(); }
+#endif
+
+    void execute(Job* job) {
+        Uint64 start = SDL_GetPerformanceCounter();
+        job->ok = job->work();
+        TraceRecorder::instance().complete(job->name, start, SDL_GetPerformanceCounter());
+        push(completed, job);
+    }
+
+    // seq_cst rather than release so the push can't be ordered after submit()'s sleeping check
+    static void push(std::atomic<Job*>& stack, Job* job) {
+        Job* head = stack.load(std::memory_order_relaxed);
+        do {
+            job->next = head;
+        } while (!stack.compare_exchange_weak(head, job, std::memory_order_seq_cst, std::memory_order_relaxed));
+    }
+
+    static Job* takeAll(std::atomic<Job*>& stack) {
+        Job* job = stack.exchange(nullptr, std::memory_order_acquire);
+        Job* ordered = nullptr;
+        while (job) {
+            Job* next = job->next;
+            job->next = ordered;
+            ordered = job;
+            job = next;
+        }
+        return ordered;
+    }
+};
+
+// exportFile() without the wait: natively the write goes to the I/O thread; in the browser the
+// download is handed to the page right away, since only the main thread can reach the DOM
+inline void exportFileAsync(const char* fileName, std::string data, const char* mimeType = "application/octet-stream",
+                            IoDone done = nullptr) {
+#ifdef __EMSCRIPTEN__
+    bool ok = exportFile(fileName, data, mimeType);
+    if (done) done(ok);
+#else
+    (void)mimeType;
+    IoService::instance().writeFile(fileName, std::move(data), std::move(done));
+#endif
+}
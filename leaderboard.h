@@ -0,0 +1,369 @@
+#pragma once
+#include <SDL2/SDL.h>
+#include <vector>
+#include <map>
+#include <memory>
+#include <algorithm>
+#include <ctime>
+
+// Leaderboard engine for the hosted score service: millions of players per board, each with
+// their best score, and every query the game needs in O(log n): rank of a player, the top K,
+// the window around a player, the entry at any rank.
+//
+// Entries live in a B+ tree ordered by score (ties go to whoever got there first). Inner nodes
+// keep the entry count of each child, so a rank is the sum of the counts left of the path
+// down to it, and the entry at a rank is found by walking those counts. Leaves are linked for
+// range reads. A player's current key is kept in an open-addressing hash beside the tree, so
+// replacing a score is one erase and one insert. Nodes are only removed once they empty out,
+// which keeps erase simple; scores mostly go up, so leaves refill quickly.
+//
+// Leaderboard partitions boards by game mode and by day; every score also goes to the mode's
+// all-time board. Player ids are the caller's (0xFFFFFFFF is reserved).
+
+struct LeaderboardEntry {
+    Uint32 player;
+    int score;
+    Uint32 rank;  // 0 for the top entry
+};
+
+class RankedScores {
+public:
+    static const int fanout = 64;
+
+    RankedScores() : root(new Leaf()), entries(0), sequence(0), slotsUsed(0) { resizeSlots(1024); }
+    ~RankedScores() { destroy(root); }
+    RankedScores(const RankedScores&) = delete;
+    RankedScores& operator=(const RankedScores&) = delete;
+
+    // Records a score; only a player's best counts. True if their entry changed.
+    bool submit(Uint32 player, int score) {
+        Uint64* current = lookup(player);
+        if (current && scoreOf(*current) >= score) return false;
+        Uint64 key = makeKey(score, sequence++);
+        if (current) {
+            erase(*current);
+            *current = key;
+        } else {
+            insertSlot(player, key);
+            entries++;
+        }
+        insert(key, player);
+        return true;
+    }
+
+    size_t size() const { return entries; }
+
+    bool find(Uint32 player, LeaderboardEntry& entry) const {
+        const Uint64* key = lookup(player);
+        if (!key) return false;
+        entry.player = player;
+        entry.score = scoreOf(*key);
+        entry.rank = (Uint32)rankOf(*key);
+        return true;
+    }
+
+    // 0-based rank, -1 if the player has no score here
+    long rank(Uint32 player) const {
+        const Uint64* key = lookup(player);
+        return key ? (long)rankOf(*key) : -1;
+    }
+
+    // Entries ranked first .. first + count - 1, best first
+    void range(size_t first, size_t count, std::vector<LeaderboardEntry>& out) const {
+        out.clear();
+        if (first >= entries) return;
+        const Node* n = root;
+        size_t skip = first;
+        while (!n->leaf) {
+            const Inner* in = (const Inner*)n;
+            int i = 0;
+            while (i < in->count - 1 && skip >= in->sizes[i]) skip -= in->sizes[i++];
+            n = in->children[i];
+        }
+        const Leaf* leaf = (const Leaf*)n;
+        int i = (int)skip;
+        for (size_t rank = first; leaf && out.size() < count; leaf = leaf->next, i = 0) {
+            for (; i < leaf->count && out.size() < count; ++i) out.push_back({ leaf->players[i], scoreOf(leaf->keys[i]), (Uint32)rank++ });
+        }
+    }
+
+    void top(size_t k, std::vector<LeaderboardEntry>& out) const { range(0, k, out); }
+
+    // The player's entry with up to `above` entries before it and `below` after it
+    void around(Uint32 player, size_t above, size_t below, std::vector<LeaderboardEntry>& out) const {
+        long r = rank(player);
+        if (r < 0) {
+            out.clear();
+            return;
+        }
+        size_t first = (size_t)r > above ? (size_t)r - above : 0;
+        range(first, (size_t)r - first + 1 + below, out);
+    }
+
+    // Heap held by the tree and the player index
+    size_t memoryBytes() const {
+        return nodeBytes(root) + slotPlayers.capacity() * sizeof(Uint32) + slotKeys.capacity() * sizeof(Uint64);
+    }
+
+private:
+    // Arrays hold one spare slot so a node can overflow before it's split
+    struct Node {
+        bool leaf;
+        int count;
+        Uint64 keys[fanout + 1];  // Leaf: entry keys; inner: smallest key under each child
+    };
+    struct Leaf : Node {
+        Uint32 players[fanout + 1];
+        Leaf* prev;
+        Leaf* next;
+        Leaf() : prev(nullptr), next(nullptr) { leaf = true; count = 0; }
+    };
+    struct Inner : Node {
+        Uint32 sizes[fanout + 1];  // Entries under each child
+        Node* children[fanout + 1];
+        Inner() { leaf = false; count = 0; }
+    };
+
+    static constexpr Uint32 emptySlot = 0xFFFFFFFFu;
+
+    Node* root;
+    size_t entries;
+    Uint32 sequence;  // Tie-break: earlier submissions rank higher among equal scores
+    std::vector<Uint32> slotPlayers;
+    std::vector<Uint64> slotKeys;
+    size_t slotsUsed;
+
+    // Higher scores sort first, then lower sequence numbers
+    static Uint64 makeKey(int score, Uint32 seq) { return ((Uint64)~((Uint32)score ^ 0x80000000u) << 32) | seq; }
+    static int scoreOf(Uint64 key) { return (int)(~(Uint32)(key >> 32) ^ 0x80000000u); }
+
+    static size_t subtreeSize(const Node* n) {
+        if (n->leaf) return n->count;
+        const Inner* in = (const Inner*)n;
+        size_t total = 0;
+        for (int i = 0; i < in->count; ++i) total += in->sizes[i];
+        return total;
+    }
+
+    static int childFor(const Inner* in, Uint64 key) {
+        int i = (int)(std::upper_bound(in->keys, in->keys + in->count, key) - in->keys) - 1;
+        return i < 0 ? 0 : i;
+    }
+
+    size_t rankOf(Uint64 key) const {
+        size_t rank = 0;
+        const Node* n = root;
+        while (!n->leaf) {
+            const Inner* in = (const Inner*)n;
+            int i = childFor(in, key);
+            for (int c = 0; c < i; ++c) rank += in->sizes[c];
+            n = in->children[i];
+        }
+        return rank + (size_t)(std::lower_bound(n->keys, n->keys + n->count, key) - n->keys);
+    }
+
+    void insert(Uint64 key, Uint32 player) {
+        Node* sibling = insertInto(root, key, player);
+        if (!sibling) return;
+        Inner* top = new Inner();
+        top->count = 2;
+        top->children[0] = root;
+        top->children[1] = sibling;
+        top->keys[0] = root->keys[0];
+        top->keys[1] = sibling->keys[0];
+        top->sizes[0] = (Uint32)subtreeSize(root);
+        top->sizes[1] = (Uint32)subtreeSize(sibling);
+        root = top;
+    }
+
+    // Returns the new right half if n had to split
+    Node* insertInto(Node* n, Uint64 key, Uint32 player) {
+        if (n->leaf) {
+            Leaf* leaf = (Leaf*)n;
+            int i = (int)(std::lower_bound(leaf->keys, leaf->keys + leaf->count, key) - leaf->keys);
+            std::copy_backward(leaf->keys + i, leaf->keys + leaf->count, leaf->keys + leaf->count + 1);
+            std::copy_backward(leaf->players + i, leaf->players + leaf->count, leaf->players + leaf->count + 1);
+            leaf->keys[i] = key;
+            leaf->players[i] = player;
+            if (++leaf->count <= fanout) return nullptr;
+            Leaf* right = new Leaf();
+            int half = leaf->count / 2;
+            right->count = leaf->count - half;
+            std::copy(leaf->keys + half, leaf->keys + leaf->count, right->keys);
+            std::copy(leaf->players + half, leaf->players + leaf->count, right->players);
+            leaf->count = half;
+            right->next = leaf->next;
+            right->prev = leaf;
+            if (leaf->next) leaf->next->prev = right;
+            leaf->next = right;
+            return right;
+        }
+
+        Inner* in = (Inner*)n;
+        int i = childFor(in, key);
+        Node* split = insertInto(in->children[i], key, player);
+        in->keys[i] = in->children[i]->keys[0];
+        if (!split) {
+            in->sizes[i]++;
+            return nullptr;
+        }
+        in->sizes[i] = (Uint32)subtreeSize(in->children[i]);
+        std::copy_backward(in->keys + i + 1, in->keys + in->count, in->keys + in->count + 1);
+        std::copy_backward(in->sizes + i + 1, in->sizes + in->count, in->sizes + in->count + 1);
+        std::copy_backward(in->children + i + 1, in->children + in->count, in->children + in->count + 1);
+        in->keys[i + 1] = split->keys[0];
+        in->sizes[i + 1] = (Uint32)subtreeSize(split);
+        in->children[i + 1] = split;
+        if (++in->count <= fanout) return nullptr;
+        Inner* right = new Inner();
+        int half = in->count / 2;
+        right->count = in->count - half;
+        std::copy(in->keys + half, in->keys + in->count, right->keys);
+        std::copy(in->sizes + half, in->sizes + in->count, right->sizes);
+        std::copy(in->children + half, in->children + in->count, right->children);
+        in->count = half;
+        return right;
+    }
+
+    void erase(Uint64 key) {
+        eraseFrom(root, key);
+        while (!root->leaf && root->count == 1) {
+            Inner* old = (Inner*)root;
+            root = old->children[0];
+            delete old;
+        }
+        if (!root->leaf && root->count == 0) {
+            delete (Inner*)root;
+            root = new Leaf();
+        }
+    }
+
+    void eraseFrom(Node* n, Uint64 key) {
+        if (n->leaf) {
+            Leaf* leaf = (Leaf*)n;
+            int i = (int)(std::lower_bound(leaf->keys, leaf->keys + leaf->count, key) - leaf->keys);
+            std::copy(leaf->keys + i + 1, leaf->keys + leaf->count, leaf->keys + i);
+            std::copy(leaf->players + i + 1, leaf->players + leaf->count, leaf->players + i);
+            leaf->count--;
+            return;
+        }
+        Inner* in = (Inner*)n;
+        int i = childFor(in, key);
+        Node* child = in->children[i];
+        eraseFrom(child, key);
+        if (child->count) {
+            in->sizes[i]--;
+            in->keys[i] = child->keys[0];
+            return;
+        }
+        // Empty child: unlink it (and, for a leaf, take it out of the leaf chain)
+        if (child->leaf) {
+            Leaf* leaf = (Leaf*)child;
+            if (leaf->prev) leaf->prev->next = leaf->next;
+            if (leaf->next) leaf->next->prev = leaf->prev;
+            delete leaf;
+        } else {
+            delete (Inner*)child;
+        }
+        std::copy(in->keys + i + 1, in->keys + in->count, in->keys + i);
+        std::copy(in->sizes + i + 1, in->sizes + in->count, in->sizes + i);
+        std::copy(in->children + i + 1, in->children + in->count, in->children + i);
+        in->count--;
+    }
+
+    static void destroy(Node* n) {
+        if (n->leaf) {
+            delete (Leaf*)n;
+            return;
+        }
+        Inner* in = (Inner*)n;
+        for (int i = 0; i < in->count; ++i) destroy(in->children[i]);
+        delete in;
+    }
+
+    static size_t nodeBytes(const Node* n) {
+        if (n->leaf) return sizeof(Leaf);
+        const Inner* in = (const Inner*)n;
+        size_t total = sizeof(Inner);
+        for (int i = 0; i < in->count; ++i) total += nodeBytes(in->children[i]);
+        return total;
+    }
+
+    // Player index: linear probing over a power-of-two table, never more than 70% full
+    size_t slotFor(Uint32 player) const { return (size_t)((player * 0x9E3779B1u) ^ (player >> 15)) & (slotPlayers.size() - 1); }
+
+    const Uint64* lookup(Uint32 player) const {
+        for (size_t s = slotFor(player);; s = (s + 1) & (slotPlayers.size() - 1)) {
+            if (slotPlayers[s] == player) return &slotKeys[s];
+            if (slotPlayers[s] == emptySlot) return nullptr;
+        }
+    }
+    Uint64* lookup(Uint32 player) { return const_cast<Uint64*>(static_cast<const RankedScores*>(this)->lookup(player)); }
+
+    void insertSlot(Uint32 player, Uint64 key) {
+        if ((slotsUsed + 1) * 10 > slotPlayers.size() * 7) resizeSlots(slotPlayers.size() * 2);
+        size_t s = slotFor(player);
+        while (slotPlayers[s] != emptySlot) s = (s + 1) & (slotPlayers.size() - 1);
+        slotPlayers[s] = player;
+        slotKeys[s] = key;
+        slotsUsed++;
+    }
+
+    void resizeSlots(size_t capacity) {
+        std::vector<Uint32> oldPlayers(capacity, emptySlot);
+        std::vector<Uint64> oldKeys(capacity);
+        oldPlayers.swap(slotPlayers);
+        oldKeys.swap(slotKeys);
+        slotsUsed = 0;
+        for (size_t i = 0; i < oldPlayers.size(); ++i) {
+            if (oldPlayers[i] == emptySlot) continue;
+            size_t s = slotFor(oldPlayers[i]);
+            while (slotPlayers[s] != emptySlot) s = (s + 1) & (slotPlayers.size() - 1);
+            slotPlayers[s] = oldPlayers[i];
+            slotKeys[s] = oldKeys[i];
+            slotsUsed++;
+        }
+    }
+};
+
+// Boards per game mode and day, plus an all-time board per mode
+class Leaderboard {
+public:
+    static constexpr Uint32 allTime = 0xFFFFFFFFu;
+
+    static Uint32 dayOf(time_t t) { return (Uint32)(t / 86400); }
+
+    // Counts for the day's board and the mode's all-time board
+    void submit(Uint16 mode, Uint32 day, Uint32 player, int score) {
+        board(mode, day).submit(player, score);
+        board(mode, allTime).submit(player, score);
+    }
+
+    RankedScores& board(Uint16 mode, Uint32 day) {
+        std::unique_ptr<RankedScores>& b = partitions[partitionKey(mode, day)];
+        if (!b) b.reset(new RankedScores());
+        return *b;
+    }
+
+    // nullptr if nothing was submitted to that partition
+    const RankedScores* find(Uint16 mode, Uint32 day) const {
+        auto it = partitions.find(partitionKey(mode, day));
+        return it == partitions.end() ? nullptr : it->second.get();
+    }
+
+    // Drops every daily board older than day; all-time boards stay
+    void dropDaysBefore(Uint32 day) {
+        for (auto it = partitions.begin(); it != partitions.end();) {
+            Uint32 d = (Uint32)it->first;
+            if (d != allTime && d < day) it = partitions.erase(it);
+            else ++it;
+        }
+    }
+
+    size_t partitionCount() const { return partitions.size(); }
+
+private:
+    std::map<Uint64, std::unique_ptr<RankedScores>> partitions;
+
+    static Uint64 partitionKey(Uint16 mode, Uint32 day) { return ((Uint64)mode << 32) | day; }
+};
@@ -0,0 +1,113 @@
+// Leaderboard engine benchmark (leaderboard.h): fills one board with N players at random scores,
+// then times the queries the score service answers, reporting ns/op and the board's memory.
+// Improves replace a random player's score with a better one, so the board keeps its size.
+//
+//   g++ -O2 -std=c++17 leaderboard_bench.cpp -o leaderboard_bench
+//   ./leaderboard_bench [--entries N] [--ops N] [--seed N] [--csv]
+//
+// The default is 10,000,000 entries, about 400 MB.
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+#include <string>
+#include <random>
+#include <functional>
+#include <algorithm>
+#ifdef __linux__
+#include <sys/resource.h>
+#endif
+#include "leaderboard.h"
+
+static double nowMs() {
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+// Peak resident set of the process in MB, -1 where unknown
+static double peakRssMb() {
+#ifdef __linux__
+    rusage usage;
+    if (getrusage(RUSAGE_SELF, &usage) == 0) return usage.ru_maxrss / 1024.0;
+#endif
+    return -1.0;
+}
+
+struct Result {
+    const char* op;
+    long ops;
+    double nsPerOp;
+};
+
+static Result timeOps(const char* op, long ops, const std::function<void(long)>& body) {
+    double start = nowMs();
+    for (long i = 0; i < ops; ++i) body(i);
+    return { op, ops, (nowMs() - start) * 1e6 / ops };
+}
+
+int main(int argc, char* argv[]) {
+    long entries = 10000000;
+    long ops = 1000000;
+    unsigned seed = 1;
+    bool csv = false;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--entries" && i + 1 < argc) entries = atol(argv[++i]);
+        else if (arg == "--ops" && i + 1 < argc) ops = atol(argv[++i]);
+        else if (arg == "--seed" && i + 1 < argc) seed = (unsigned)atol(argv[++i]);
+        else if (arg == "--csv") csv = true;
+        else {
+            fprintf(stderr, "usage: %s [--entries N] [--ops N] [--seed N] [--csv]\n", argv[0]);
+            return EXIT_FAILURE;
+        }
+    }
+    if (entries < 1 || ops < 1) {
+        fprintf(stderr, "leaderboard_bench: --entries and --ops must be positive\n");
+        return EXIT_FAILURE;
+    }
+
+    std::mt19937 rng(seed);
+    std::uniform_int_distribution<Uint32> anyPlayer(0, (Uint32)entries - 1);
+    std::uniform_int_distribution<int> anyScore(0, 1 << 24);
+    std::vector<Result> results;
+    RankedScores board;
+    long sink = 0;  // Keeps the query results alive
+
+    results.push_back(timeOps("insert", entries, [&](long i) { board.submit((Uint32)i, anyScore(rng)); }));
+    results.push_back(timeOps("improve", ops, [&](long) {
+        Uint32 player = anyPlayer(rng);
+        LeaderboardEntry e = {};
+        board.find(player, e);
+        board.submit(player, e.score + 1 + (int)(rng() % 1024));
+    }));
+    results.push_back(timeOps("rank", ops, [&](long) { sink += board.rank(anyPlayer(rng)); }));
+    std::vector<LeaderboardEntry> window;
+    results.push_back(timeOps("top10", ops, [&](long) {
+        board.top(10, window);
+        sink += window.back().score;
+    }));
+    results.push_back(timeOps("top100", std::max(1L, ops / 10), [&](long) {
+        board.top(100, window);
+        sink += window.back().score;
+    }));
+    results.push_back(timeOps("around+-5", ops, [&](long) {
+        board.around(anyPlayer(rng), 5, 5, window);
+        sink += window.size();
+    }));
+    results.push_back(timeOps("at-rank", ops, [&](long) {
+        board.range(anyPlayer(rng), 1, window);
+        sink += window[0].player;
+    }));
+
+    double boardMb = board.memoryBytes() / (1024.0 * 1024.0);
+    if (csv) {
+        printf("op,entries,ops,ns_per_op\n");
+        for (const Result& r : results) printf("%s,%ld,%ld,%.1f\n", r.op, entries, r.ops, r.nsPerOp);
+    } else {
+        printf("%-10s %10s %10s %10s\n", "op", "entries", "ops", "ns/op");
+        for (const Result& r : results) printf("%-10s %10ld %10ld %10.1f\n", r.op, entries, r.ops, r.nsPerOp);
+        printf("board %.1f MB (%.1f bytes/entry), peak RSS %.1f MB\n", boardMb, board.memoryBytes() / (double)entries,
+               peakRssMb());
+    }
+    return sink == 42 ? EXIT_FAILURE : EXIT_SUCCESS;
+}
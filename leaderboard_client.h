@@ -0,0 +1,256 @@
+#pragma once
+#include <SDL2/SDL.h>
+#include <string>
+#include <vector>
+#include <memory>
+#include <cstdio>
+#include <cstdlib>
+#include "snake_replay.h"
+#include "score_store.h"
+#include "io_service.h"
+#ifdef __EMSCRIPTEN__
+#include <emscripten/emscripten.h>
+#elif !defined(_WIN32)
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <netdb.h>
+#include <unistd.h>
+#endif
+
+// Client side of leaderboard_server. Finished rounds are sent as replays (snake_replay.h) and
+// the server decides the score; the table shown in the game is the server's top list. One
+// request is out at a time: rounds finished meanwhile are queued and go together in the next
+// POST, and a request that fails is retried a few seconds later with whatever has queued since.
+// Only failures that may pass are retried (no answer, or a 5xx); a 4xx means the server will
+// never take that request, so it's dropped rather than blocking every round queued behind it.
+//
+// Natively the HTTP exchange runs on the I/O thread (io_service.h); in the browser it's a
+// fetch(), so the page needs to reach the server (it answers CORS preflights). Nothing here
+// blocks the frame: poll() just starts requests and picks up finished ones.
+
+class LeaderboardClient {
+public:
+    static const Uint32 retryMs = 5000;
+
+    // "http://host:port"; false (and left disabled) if the URL can't be used
+    bool setServer(const std::string& url) {
+        const std::string scheme = "http://";
+        if (url.compare(0, scheme.size(), scheme) != 0) {
+            fprintf(stderr, "leaderboard: only http:// servers are supported, not %s\n", url.c_str());
+            return false;
+        }
+        std::string rest = url.substr(scheme.size());
+        rest = rest.substr(0, rest.find('/'));
+        size_t colon = rest.rfind(':');
+        port = colon == std::string::npos ? 80 : atoi(rest.c_str() + colon + 1);
+        host = rest.substr(0, colon);
+#if defined(_WIN32) && !defined(__EMSCRIPTEN__)
+        fprintf(stderr, "leaderboard: no network client on this platform\n");
+        host.clear();
+        return false;
+#else
+        baseUrl = scheme + rest;
+        return !host.empty() && port > 0;
+#endif
+    }
+
+    bool enabled() const { return !host.empty(); }
+
+    // Queues a finished round
+    void submit(const SnakeReplay& replay) {
+        replay.encode(outgoing);
+        queuedRounds++;
+    }
+
+    // Asks for the all-time top list; it's fetched again after every submission
+    void requestTop(int count) {
+        topCount = count;
+        topWanted = true;
+    }
+
+    // Game thread, once per frame
+    void poll() {
+        if (!enabled()) return;
+#ifdef __EMSCRIPTEN__
+        if (inFlight != None) {
+            int status = EM_ASM_INT({ return Module.leaderboardStatus | 0; });
+            if (status == 0) return;
+            int length = EM_ASM_INT({ return lengthBytesUTF8(Module.leaderboardReply || ""); });
+            std::string reply((size_t)length + 1, '\0');
+            EM_ASM({ stringToUTF8(Module.leaderboardReply || "", $0, $1); }, &reply[0], length + 1);
+            reply.resize((size_t)length);
+            finished(status, reply);
+        }
+#endif
+        if (inFlight != None || SDL_GetTicks() < retryAt) return;
+        if (queuedRounds) {
+            sentBody.swap(outgoing);
+            outgoing.clear();
+            sentRounds = queuedRounds;
+            queuedRounds = 0;
+            topWanted = topCount > 0;
+            send(Submit, "POST", "/submit");
+        } else if (topWanted) {
+            topWanted = false;
+            sentBody.clear();
+            send(Top, "GET", "/top?format=text&k=" + std::to_string(topCount));
+        }
+    }
+
+    // True once for every new top list from the server
+    bool takeTop(std::vector<ScoreRecord>& records) {
+        if (!topChanged) return false;
+        records = top;
+        topChanged = false;
+        return true;
+    }
+
+private:
+    enum Request { None, Submit, Top };
+
+    std::string host;
+    int port = 0;
+    std::string baseUrl;
+    std::string outgoing;  // Encoded replays waiting for the next submission
+    int queuedRounds = 0;
+    std::string sentBody;
+    int sentRounds = 0;
+    int topCount = 0;
+    bool topWanted = false;
+    Request inFlight = None;
+    Uint32 retryAt = 0;
+    std::vector<ScoreRecord> top;
+    bool topChanged = false;
+    bool reportedDown = false;
+
+    void send(Request kind, const char* method, const std::string& path) {
+        inFlight = kind;
+#ifdef __EMSCRIPTEN__
+        EM_ASM({
+            Module.leaderboardStatus = 0;
+            var init = { method: UTF8ToString($1) };
+            if ($3 > 0) init.body = HEAPU8.slice($2, $2 + $3);
+            fetch(UTF8ToString($0), init).then(function(r) {
+                return r.text().then(function(text) {
+                    Module.leaderboardReply = text;
+                    Module.leaderboardStatus = r.status;
+                });
+            }).catch(function(e) {
+                Module.leaderboardReply = String(e);
+                Module.leaderboardStatus = -1;
+            });
+        }, (baseUrl + path).c_str(), method, sentBody.data(), (int)sentBody.size());
+#else
+        std::shared_ptr<std::string> reply = std::make_shared<std::string>();
+        std::shared_ptr<int> status = std::make_shared<int>(0);
+        std::string h = host, m = method, body = sentBody;
+        int p = port;
+        IoService::instance().submit("leaderboard",
+                                     [h, p, m, path, body, reply, status] {
+                                         *status = httpRequest(h, p, m, path, body, *reply);
+                                         return *status == 200;
+                                     },
+                                     [this, reply, status](bool) { finished(*status, *reply); });
+#endif
+    }
+
+    // status is the HTTP status, or 0 or less when no answer came
+    void finished(int status, const std::string& reply) {
+        Request kind = inFlight;
+        inFlight = None;
+        if (status >= 400 && status < 500) {
+            reportedDown = false;
+            std::string why = reply.substr(0, reply.find('\n'));
+            if (kind == Submit) fprintf(stderr, "leaderboard: server refused %d rounds, dropping them (%d %s)\n", sentRounds, status, why.c_str());
+            else fprintf(stderr, "leaderboard: server refused the top list request (%d %s)\n", status, why.c_str());
+            return;
+        }
+        if (status != 200) {
+            if (!reportedDown) fprintf(stderr, "leaderboard: %s unreachable or failing, retrying every %u s\n", baseUrl.c_str(), retryMs / 1000);
+            reportedDown = true;
+            retryAt = SDL_GetTicks() + retryMs;
+            if (kind == Submit) {
+                outgoing.insert(0, sentBody);  // Back in front of anything queued meanwhile
+                queuedRounds += sentRounds;
+            } else {
+                topWanted = true;
+            }
+            return;
+        }
+        reportedDown = false;
+        if (kind == Submit) {
+            // One "verdict score rank" line per round; the server has the final word on the score
+            size_t start = 0;
+            while (start < reply.size()) {
+                size_t end = reply.find('\n', start);
+                if (end == std::string::npos) end = reply.size();
+                std::string line = reply.substr(start, end - start);
+                if (line.compare(0, 5, "valid") != 0) fprintf(stderr, "leaderboard: round rejected (%s)\n", line.c_str());
+                start = end + 1;
+            }
+        } else if (kind == Top) {
+            // "score name" per line, best first
+            top.clear();
+            size_t start = 0;
+            while (start < reply.size()) {
+                size_t end = reply.find('\n', start);
+                if (end == std::string::npos) end = reply.size();
+                size_t space = reply.find(' ', start);
+                if (space != std::string::npos && space < end) {
+                    top.push_back({ reply.substr(space + 1, end - space - 1), atoi(reply.c_str() + start) });
+                }
+                start = end + 1;
+            }
+            topChanged = true;
+        }
+    }
+
+#if !defined(__EMSCRIPTEN__) && !defined(_WIN32)
+    // One blocking request on a fresh connection; the answer's status (0 if none came), its body in reply
+    static int httpRequest(const std::string& host, int port, const std::string& method, const std::string& path,
+                            const std::string& body, std::string& reply) {
+        addrinfo hints = {};
+        hints.ai_family = AF_UNSPEC;
+        hints.ai_socktype = SOCK_STREAM;
+        addrinfo* addresses = nullptr;
+        if (getaddrinfo(host.c_str(), std::to_string(port).c_str(), &hints, &addresses) != 0) return 0;
+        int fd = -1;
+        for (addrinfo* a = addresses; a && fd < 0; a = a->ai_next) {
+            fd = socket(a->ai_family, a->ai_socktype, a->ai_protocol);
+            if (fd >= 0 && ::connect(fd, a->ai_addr, a->ai_addrlen) != 0) {
+                close(fd);
+                fd = -1;
+            }
+        }
+        freeaddrinfo(addresses);
+        if (fd < 0) return 0;
+        timeval timeout = { 5, 0 };
+        setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+        setsockopt(fd, SOL_SOCKET, SO_SNDTIMEO, &timeout, sizeof(timeout));
+
+        std::string request = method + " " + path + " HTTP/1.1\r\nHost: " + host + "\r\nConnection: close\r\n";
+        request += "Content-Type: application/octet-stream\r\nContent-Length: " + std::to_string(body.size()) + "\r\n\r\n";
+        request += body;
+        bool ok = true;
+        for (size_t sent = 0; ok && sent < request.size();) {
+            ssize_t n = ::send(fd, request.data() + sent, request.size() - sent, 0);
+            ok = n > 0;
+            sent += ok ? (size_t)n : 0;
+        }
+        std::string response;
+        char buffer[4096];
+        for (ssize_t n; ok && (n = recv(fd, buffer, sizeof(buffer), 0)) > 0;) response.append(buffer, (size_t)n);
+        close(fd);
+
+        size_t bodyStart = response.find("\r\n\r\n");
+        if (!ok || bodyStart == std::string::npos || response.compare(0, 5, "HTTP/") != 0) return 0;
+        size_t space = response.find(' ');
+        reply = response.substr(bodyStart + 4);
+        return space != std::string::npos && space < bodyStart ? atoi(response.c_str() + space + 1) : 0;
+    }
+#elif !defined(__EMSCRIPTEN__)
+    static int httpRequest(const std::string&, int, const std::string&, const std::string&, const std::string&, std::string&) {
+        return 0;
+    }
+#endif
+};
@@ -0,0 +1,697 @@
+// Leaderboard service for snakev11, also the local stand-in during development. Games POST
+// their finished rounds as replays (snake_replay.h); nothing a client claims is trusted: every
+// round is played back under the game's rules and only the score the replay really reaches
+// counts. Boards come from leaderboard.h: an all-time and a daily board per game mode.
+//
+// Connection threads only parse requests. Submitted rounds go into one queue that a pool of
+// verifier threads drains in batches; each batch is verified without locks, then applied to the
+// boards under a single writer lock, which also publishes a fresh top-K snapshot. /top is served
+// from that snapshot without taking any lock, so readers never wait on submissions.
+// Accepted scores are appended to a journal and replayed from it on startup; with --archive the
+// accepted replays themselves go to a replay archive (replay_archive.h) for later analysis.
+//
+//   g++ -O2 -std=c++17 -pthread leaderboard_server.cpp -o leaderboard_server
+//   ./leaderboard_server [--port 8765] [--bind 127.0.0.1] [--workers N] [--batch N] [--top K]
+//                        [--journal leaderboard_journal.txt] [--archive NAME]
+//   ./leaderboard_server --load SECONDS [--port 8765] [--clients N] [--rounds-per-post N] [--rounds N]
+//
+// --load is the load generator: it plays --rounds games with the autopilot, then --clients
+// keep-alive connections post them (renamed) as fast as the server answers, and reports
+// rounds/s and request latency.
+//
+// HTTP API (every answer allows any origin, so the web build can call it from another port):
+//   POST /submit[?mode=M]     body: replays back to back; one line per replay in the answer,
+//                             "valid SCORE RANK" (all-time rank, 1 = best) or the reason it was rejected
+//   GET  /top[?mode=M][&day=today|N][&k=K][&format=text]
+//   GET  /rank?name=NAME[&mode=M][&day=today|N]   the player's entry and five either side
+//   GET  /stats
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <stdexcept>
+#include <ctime>
+#include <string>
+#include <vector>
+#include <deque>
+#include <set>
+#include <map>
+#include <unordered_map>
+#include <thread>
+#include <mutex>
+#include <shared_mutex>
+#include <condition_variable>
+#include <atomic>
+#include <chrono>
+#include <algorithm>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <arpa/inet.h>
+#include <unistd.h>
+#include <signal.h>
+#include "leaderboard.h"
+#include "snake_replay.h"
+#include "replay_archive.h"
+
+static const size_t maxBodyBytes = 16 << 20;
+
+static double nowMs() {
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+// --- HTTP ---------------------------------------------------------------------------------
+
+struct HttpMessage {
+    std::string startLine;
+    std::map<std::string, std::string> headers;  // Names lower-cased
+    std::string body;
+
+    std::string header(const char* name) const {
+        auto it = headers.find(name);
+        return it == headers.end() ? std::string() : it->second;
+    }
+};
+
+// Reads one message; buffer keeps whatever arrived after it for the next call (keep-alive)
+static bool readMessage(int fd, std::string& buffer, HttpMessage& m) {
+    char chunk[16384];
+    size_t headEnd;
+    while ((headEnd = buffer.find("\r\n\r\n")) == std::string::npos) {
+        if (buffer.size() > 65536) return false;
+        ssize_t n = recv(fd, chunk, sizeof(chunk), 0);
+        if (n <= 0) return false;
+        buffer.append(chunk, (size_t)n);
+    }
+    m.headers.clear();
+    size_t lineEnd = buffer.find("\r\n");
+    m.startLine = buffer.substr(0, lineEnd);
+    for (size_t start = lineEnd + 2; start < headEnd;) {
+        size_t end = buffer.find("\r\n", start);
+        size_t colon = buffer.find(':', start);
+        if (colon != std::string::npos && colon < end) {
+            std::string name = buffer.substr(start, colon - start);
+            std::transform(name.begin(), name.end(), name.begin(), ::tolower);
+            size_t value = buffer.find_first_not_of(' ', colon + 1);
+            m.headers[name] = buffer.substr(value, end - value);
+        }
+        start = end + 2;
+    }
+    size_t length = strtoul(m.header("content-length").c_str(), nullptr, 10);
+    if (length > maxBodyBytes) return false;
+    while (buffer.size() < headEnd + 4 + length) {
+        ssize_t n = recv(fd, chunk, sizeof(chunk), 0);
+        if (n <= 0) return false;
+        buffer.append(chunk, (size_t)n);
+    }
+    m.body = buffer.substr(headEnd + 4, length);
+    buffer.erase(0, headEnd + 4 + length);
+    return true;
+}
+
+static bool writeAll(int fd, const std::string& data) {
+    for (size_t sent = 0; sent < data.size();) {
+        ssize_t n = send(fd, data.data() + sent, data.size() - sent, 0);
+        if (n <= 0) return false;
+        sent += (size_t)n;
+    }
+    return true;
+}
+
+static std::string httpResponse(int status, const char* type, const std::string& body, bool keepAlive) {
+    const char* reason = status == 200 ? "OK" : status == 204 ? "No Content" : status == 400 ? "Bad Request" : "Not Found";
+    std::string r = "HTTP/1.1 " + std::to_string(status) + " " + reason + "\r\n";
+    r += "Access-Control-Allow-Origin: *\r\n";
+    if (status == 204) r += "Access-Control-Allow-Methods: GET, POST, OPTIONS\r\nAccess-Control-Allow-Headers: Content-Type\r\n";
+    r += std::string("Content-Type: ") + type + "\r\nContent-Length: " + std::to_string(body.size()) + "\r\n";
+    r += keepAlive ? "Connection: keep-alive\r\n\r\n" : "Connection: close\r\n\r\n";
+    return r + body;
+}
+
+// Query parameter, %XX and + decoded; fallback if absent
+static std::string queryParam(const std::string& query, const char* name, const char* fallback = "") {
+    std::string key = std::string(name) + "=";
+    for (size_t start = 0; start < query.size();) {
+        size_t end = query.find('&', start);
+        if (end == std::string::npos) end = query.size();
+        if (query.compare(start, key.size(), key) == 0) {
+            std::string value;
+            for (size_t i = start + key.size(); i < end; ++i) {
+                if (query[i] == '+') value.push_back(' ');
+                else if (query[i] == '%' && i + 2 < end) {
+                    value.push_back((char)strtol(query.substr(i + 1, 2).c_str(), nullptr, 16));
+                    i += 2;
+                } else value.push_back(query[i]);
+            }
+            return value;
+        }
+        start = end + 1;
+    }
+    return fallback;
+}
+
+static void appendJsonString(std::string& out, const std::string& s) {
+    out.push_back('"');
+    for (char c : s) {
+        if (c == '"' || c == '\\') out.push_back('\\');
+        if ((Uint8)c < 32) continue;
+        out.push_back(c);
+    }
+    out.push_back('"');
+}
+
+// --- Server -------------------------------------------------------------------------------
+
+struct TopList {
+    Uint16 mode;
+    Uint32 day;
+    size_t size;  // Entries on the whole board
+    std::vector<std::pair<std::string, int>> entries;
+};
+
+// Read-only top lists, rebuilt after every batch. Readers pin the current one with a counter;
+// the writer only ever rewrites a buffer that is neither current nor pinned, so neither side
+// takes a lock and no allocation is freed under a reader.
+struct TopSnapshot {
+    std::atomic<int> readers{ 0 };
+    Uint64 version = 0;
+    Uint32 day = 0;
+    std::vector<TopList> lists;
+
+    const TopList* find(Uint16 mode, Uint32 d) const {
+        for (const TopList& l : lists) {
+            if (l.mode == mode && l.day == d) return &l;
+        }
+        return nullptr;
+    }
+};
+
+class LeaderboardServer {
+public:
+    LeaderboardServer(int workerCount, size_t batch, size_t topK, const std::string& journalPath, const std::string& archivePath)
+        : batchSize(batch), topSize(topK) {
+        current.store(&snapshots[0]);
+        if (!journalPath.empty()) {
+            replayJournal(journalPath);
+            journal = fopen(journalPath.c_str(), "a");
+            if (!journal) fprintf(stderr, "leaderboard: can't append to %s, scores won't survive a restart\n", journalPath.c_str());
+        }
+        archiving = !archivePath.empty() && archive.open(archivePath);
+        {
+            std::unique_lock<std::shared_mutex> lock(boardMutex);
+            publish(Leaderboard::dayOf(time(nullptr)));
+        }
+        for (int i = 0; i < workerCount; ++i) workers.emplace_back([this] { verifyLoop(); });
+    }
+
+    ~LeaderboardServer() {
+        {
+            std::lock_guard<std::mutex> lock(queueMutex);
+            stopping = true;
+        }
+        queueReady.notify_all();
+        for (std::thread& t : workers) t.join();
+        if (journal) fclose(journal);
+    }
+
+    std::string handle(const HttpMessage& request, bool keepAlive) {
+        // "METHOD TARGET VERSION"
+        size_t methodEnd = request.startLine.find(' ');
+        size_t targetEnd = methodEnd == std::string::npos ? std::string::npos : request.startLine.find(' ', methodEnd + 1);
+        if (methodEnd == 0 || targetEnd == std::string::npos || targetEnd == methodEnd + 1) {
+            return httpResponse(400, "text/plain", "malformed request line\n", keepAlive);
+        }
+        std::string method = request.startLine.substr(0, methodEnd);
+        std::string target = request.startLine.substr(methodEnd + 1, targetEnd - methodEnd - 1);
+        std::string path = target.substr(0, target.find('?'));
+        std::string query = target.size() > path.size() ? target.substr(path.size() + 1) : "";
+
+        if (method == "OPTIONS") return httpResponse(204, "text/plain", "", keepAlive);
+        if (method == "POST" && path == "/submit") return submit(request.body, query, keepAlive);
+        if (method == "GET" && path == "/top") return top(query, keepAlive);
+        if (method == "GET" && path == "/rank") return rank(query, keepAlive);
+        if (method == "GET" && path == "/stats") return stats(keepAlive);
+        return httpResponse(404, "text/plain", "not found\n", keepAlive);
+    }
+
+private:
+    struct PendingRequest {
+        std::mutex mutex;
+        std::condition_variable done;
+        size_t remaining;
+    };
+
+    struct Submission {
+        SnakeReplay replay;
+        Uint16 mode;
+        SnakeSim::Verdict verdict;
+        long rank;
+        PendingRequest* owner;
+    };
+
+    size_t batchSize;
+    size_t topSize;
+    static const Uint32 keepDays = 7;  // Daily boards older than this are dropped
+
+    // Verification queue
+    std::mutex queueMutex;
+    std::condition_variable queueReady;
+    std::deque<Submission*> queue;
+    bool stopping = false;
+    std::vector<std::thread> workers;
+
+    // Boards and player names; written by one batch at a time, read by /rank
+    std::shared_mutex boardMutex;
+    Leaderboard boards;
+    std::set<Uint16> modes;
+    std::unordered_map<std::string, Uint32> playerIds;
+    std::vector<std::string> playerNames;
+    Uint32 boardDay = 0;
+    FILE* journal = nullptr;
+    ReplayArchiveWriter archive;  // Indexed offline with replay_archive index
+    bool archiving = false;
+    std::vector<LeaderboardEntry> scratch;
+
+    TopSnapshot snapshots[3];
+    std::atomic<TopSnapshot*> current{ nullptr };
+
+    // Stats
+    std::atomic<long> submitted{ 0 };
+    std::atomic<long> verdicts[8] = {};
+    std::atomic<long> batches{ 0 };
+    std::atomic<long> verifyMicros{ 0 };
+
+    std::string submit(const std::string& body, const std::string& query, bool keepAlive) {
+        std::vector<Submission> items;
+        Uint16 mode = (Uint16)atoi(queryParam(query, "mode", "0").c_str());
+        for (size_t pos = 0; pos < body.size();) {
+            items.emplace_back();
+            if (!items.back().replay.decode((const Uint8*)body.data(), body.size(), pos)) {
+                return httpResponse(400, "text/plain", "malformed replay at byte " + std::to_string(pos) + "\n", keepAlive);
+            }
+        }
+        if (items.empty()) return httpResponse(400, "text/plain", "no replays\n", keepAlive);
+
+        PendingRequest pending;
+        pending.remaining = items.size();
+        {
+            std::lock_guard<std::mutex> lock(queueMutex);
+            for (Submission& s : items) {
+                s.mode = mode;
+                s.owner = &pending;
+                queue.push_back(&s);
+            }
+        }
+        queueReady.notify_all();
+        submitted += (long)items.size();
+        {
+            std::unique_lock<std::mutex> lock(pending.mutex);
+            pending.done.wait(lock, [&] { return pending.remaining == 0; });
+        }
+
+        std::string answer;
+        for (const Submission& s : items) {
+            if (s.verdict == SnakeSim::Valid) answer += "valid " + std::to_string(s.replay.score) + " " + std::to_string(s.rank + 1) + "\n";
+            else answer += std::string(SnakeSim::verdictName(s.verdict)) + "\n";
+        }
+        return httpResponse(200, "text/plain", answer, keepAlive);
+    }
+
+    void verifyLoop() {
+        SnakeSim sim;
+        std::vector<Submission*> batch;
+        for (;;) {
+            {
+                std::unique_lock<std::mutex> lock(queueMutex);
+                queueReady.wait(lock, [this] { return !queue.empty() || stopping; });
+                if (queue.empty()) return;
+                while (!queue.empty() && batch.size() < batchSize) {
+                    batch.push_back(queue.front());
+                    queue.pop_front();
+                }
+            }
+            auto start = std::chrono::steady_clock::now();
+            for (Submission* s : batch) s->verdict = sim.verify(s->replay);
+            verifyMicros += (long)std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count();
+            apply(batch);
+            batches++;
+            for (Submission* s : batch) {
+                verdicts[s->verdict]++;
+                PendingRequest* owner = s->owner;
+                std::lock_guard<std::mutex> lock(owner->mutex);
+                if (--owner->remaining == 0) owner->done.notify_all();
+            }
+            batch.clear();
+        }
+    }
+
+    // The whole batch under one writer lock, then one snapshot for it
+    void apply(std::vector<Submission*>& batch) {
+        std::unique_lock<std::shared_mutex> lock(boardMutex);
+        Uint32 today = Leaderboard::dayOf(time(nullptr));
+        for (Submission* s : batch) {
+            if (s->verdict != SnakeSim::Valid) continue;
+            Uint32 player = playerId(s->replay.name);
+            boards.submit(s->mode, today, player, s->replay.score);
+            modes.insert(s->mode);
+            s->rank = boards.board(s->mode, Leaderboard::allTime).rank(player);
+            if (journal) fprintf(journal, "%u %u %d %s\n", s->mode, today, s->replay.score, s->replay.name.c_str());
+            if (archiving) archive.append(s->replay, today, VariantSnakeV11);
+        }
+        if (journal) fflush(journal);
+        if (archiving) archive.flush();
+        publish(today);
+    }
+
+    Uint32 playerId(const std::string& name) {
+        auto it = playerIds.find(name);
+        if (it != playerIds.end()) return it->second;
+        Uint32 id = (Uint32)playerNames.size();
+        playerIds.emplace(name, id);
+        playerNames.push_back(name);
+        return id;
+    }
+
+    // Called with boardMutex held exclusively, so there's only ever one writer
+    void publish(Uint32 today) {
+        if (today != boardDay) {
+            boardDay = today;
+            if (today > keepDays) boards.dropDaysBefore(today - keepDays);
+        }
+        TopSnapshot* next = nullptr;
+        while (!next) {
+            for (TopSnapshot& s : snapshots) {
+                if (&s != current.load() && s.readers.load() == 0) {
+                    next = &s;
+                    break;
+                }
+            }
+            if (!next) std::this_thread::yield();
+        }
+        next->version = current.load()->version + 1;
+        next->day = today;
+        size_t count = 0;
+        for (Uint16 mode : modes) {
+            for (Uint32 day : { Leaderboard::allTime, today }) {
+                const RankedScores* board = boards.find(mode, day);
+                if (!board) continue;
+                if (next->lists.size() <= count) next->lists.emplace_back();
+                TopList& list = next->lists[count++];
+                list.mode = mode;
+                list.day = day;
+                list.size = board->size();
+                board->top(topSize, scratch);
+                list.entries.resize(scratch.size());
+                for (size_t i = 0; i < scratch.size(); ++i) {
+                    list.entries[i].first = playerNames[scratch[i].player];
+                    list.entries[i].second = scratch[i].score;
+                }
+            }
+        }
+        next->lists.resize(count);
+        current.store(next);
+    }
+
+    TopSnapshot* acquireSnapshot() {
+        for (;;) {
+            TopSnapshot* s = current.load();
+            s->readers.fetch_add(1);
+            if (current.load() == s) return s;
+            s->readers.fetch_sub(1);
+        }
+    }
+
+    static Uint32 parseDay(const std::string& value, Uint32 today) {
+        if (value.empty() || value == "all") return Leaderboard::allTime;
+        if (value == "today") return today;
+        return (Uint32)strtoul(value.c_str(), nullptr, 10);
+    }
+
+    std::string top(const std::string& query, bool keepAlive) {
+        Uint16 mode = (Uint16)atoi(queryParam(query, "mode", "0").c_str());
+        size_t k = strtoul(queryParam(query, "k", "10").c_str(), nullptr, 10);
+        bool text = queryParam(query, "format") == "text";
+        Uint32 today = Leaderboard::dayOf(time(nullptr));
+        Uint32 day = parseDay(queryParam(query, "day"), today);
+
+        std::vector<std::pair<std::string, int>> older;
+        const std::vector<std::pair<std::string, int>>* entries = &older;
+        size_t size = 0;
+        TopSnapshot* snapshot = acquireSnapshot();
+        const TopList* list = snapshot->find(mode, day);
+        if (list && k <= topSize) {
+            entries = &list->entries;
+            size = list->size;
+        } else if (!list && (day == Leaderboard::allTime || day == snapshot->day)) {
+            // Nothing submitted there yet
+        } else {
+            // Past days and deep lists aren't in the snapshot: read the board itself
+            std::shared_lock<std::shared_mutex> lock(boardMutex);
+            if (const RankedScores* board = boards.find(mode, day)) {
+                std::vector<LeaderboardEntry> found;
+                board->top(k, found);
+                for (const LeaderboardEntry& e : found) older.push_back({ playerNames[e.player], e.score });
+                size = board->size();
+            }
+        }
+
+        std::string body;
+        size_t n = std::min(k, entries->size());
+        if (text) {
+            for (size_t i = 0; i < n; ++i) body += std::to_string((*entries)[i].second) + " " + (*entries)[i].first + "\n";
+        } else {
+            body = "{\"mode\":" + std::to_string(mode) + ",\"day\":" + (day == Leaderboard::allTime ? std::string("\"all\"") : std::to_string(day));
+            body += ",\"players\":" + std::to_string(size) + ",\"entries\":[";
+            for (size_t i = 0; i < n; ++i) {
+                body += i ? ",{\"rank\":" : "{\"rank\":";
+                body += std::to_string(i + 1) + ",\"name\":";
+                appendJsonString(body, (*entries)[i].first);
+                body += ",\"score\":" + std::to_string((*entries)[i].second) + "}";
+            }
+            body += "]}\n";
+        }
+        snapshot->readers.fetch_sub(1);
+        return httpResponse(200, text ? "text/plain" : "application/json", body, keepAlive);
+    }
+
+    std::string rank(const std::string& query, bool keepAlive) {
+        Uint16 mode = (Uint16)atoi(queryParam(query, "mode", "0").c_str());
+        std::string name = queryParam(query, "name");
+        Uint32 day = parseDay(queryParam(query, "day"), Leaderboard::dayOf(time(nullptr)));
+        std::shared_lock<std::shared_mutex> lock(boardMutex);
+        auto id = playerIds.find(name);
+        const RankedScores* board = boards.find(mode, day);
+        std::vector<LeaderboardEntry> window;
+        if (id != playerIds.end() && board) board->around(id->second, 5, 5, window);
+        if (window.empty()) return httpResponse(404, "application/json", "{\"error\":\"no score\"}\n", keepAlive);
+        std::string body = "{\"players\":" + std::to_string(board->size()) + ",\"rank\":" + std::to_string(board->rank(id->second) + 1) + ",\"around\":[";
+        for (size_t i = 0; i < window.size(); ++i) {
+            body += i ? ",{\"rank\":" : "{\"rank\":";
+            body += std::to_string(window[i].rank + 1) + ",\"name\":";
+            appendJsonString(body, playerNames[window[i].player]);
+            body += ",\"score\":" + std::to_string(window[i].score) + "}";
+        }
+        return httpResponse(200, "application/json", body + "]}\n", keepAlive);
+    }
+
+    std::string stats(bool keepAlive) {
+        long verified = 0;
+        for (const std::atomic<long>& v : verdicts) verified += v.load();
+        char text[512];
+        snprintf(text, sizeof(text),
+                 "{\"submitted\":%ld,\"verified\":%ld,\"valid\":%ld,\"rejected\":%ld,\"batches\":%ld,\"mean_batch\":%.1f,"
+                 "\"verify_us_per_round\":%.1f,\"snapshot\":%llu}\n",
+                 submitted.load(), verified, verdicts[SnakeSim::Valid].load(), verified - verdicts[SnakeSim::Valid].load(),
+                 batches.load(), batches ? (double)verified / batches : 0.0, verified ? (double)verifyMicros / verified : 0.0,
+                 (unsigned long long)current.load()->version);
+        return httpResponse(200, "application/json", text, keepAlive);
+    }
+
+    // "mode day score name" per accepted round
+    void replayJournal(const std::string& path) {
+        FILE* f = fopen(path.c_str(), "r");
+        if (!f) return;
+        std::unique_lock<std::shared_mutex> lock(boardMutex);
+        char line[256];
+        long rounds = 0;
+        while (fgets(line, sizeof(line), f)) {
+            unsigned mode, day;
+            int score, nameStart = 0;
+            if (sscanf(line, "%u %u %d %n", &mode, &day, &score, &nameStart) < 3 || !nameStart) continue;
+            std::string name = line + nameStart;
+            while (!name.empty() && (name.back() == '\n' || name.back() == '\r')) name.pop_back();
+            Uint32 player = playerId(name);
+            boards.board((Uint16)mode, day).submit(player, score);
+            boards.board((Uint16)mode, Leaderboard::allTime).submit(player, score);
+            modes.insert((Uint16)mode);
+            rounds++;
+        }
+        fclose(f);
+        printf("leaderboard: %ld rounds from %s, %zu players\n", rounds, path.c_str(), playerNames.size());
+    }
+};
+
+static void serveConnection(LeaderboardServer* server, int fd) {
+    std::string buffer;
+    HttpMessage request;
+    // A bug in handling one request costs its connection, not the whole server
+    try {
+        while (readMessage(fd, buffer, request)) {
+            bool keepAlive = request.header("connection") != "close" && request.startLine.find("HTTP/1.0") == std::string::npos;
+            if (!writeAll(fd, server->handle(request, keepAlive)) || !keepAlive) break;
+        }
+    } catch (const std::exception& e) {
+        fprintf(stderr, "leaderboard: dropped a connection: %s\n", e.what());
+    }
+    close(fd);
+}
+
+static int serve(const std::string& bindAddress, int port, int workers, size_t batch, size_t topK, const std::string& journal,
+                 const std::string& archive) {
+    int listener = socket(AF_INET, SOCK_STREAM, 0);
+    int on = 1;
+    setsockopt(listener, SOL_SOCKET, SO_REUSEADDR, &on, sizeof(on));
+    sockaddr_in address = {};
+    address.sin_family = AF_INET;
+    address.sin_port = htons((uint16_t)port);
+    if (inet_pton(AF_INET, bindAddress.c_str(), &address.sin_addr) != 1 || bind(listener, (sockaddr*)&address, sizeof(address)) != 0 ||
+        listen(listener, 256) != 0) {
+        fprintf(stderr, "leaderboard: can't listen on %s:%d\n", bindAddress.c_str(), port);
+        return EXIT_FAILURE;
+    }
+    LeaderboardServer server(workers, batch, topK, journal, archive);
+    printf("leaderboard: listening on http://%s:%d with %d verifier threads\n", bindAddress.c_str(), port, workers);
+    fflush(stdout);
+    for (;;) {
+        int fd = accept(listener, nullptr, nullptr);
+        if (fd < 0) continue;
+        setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &on, sizeof(on));
+        std::thread(serveConnection, &server, fd).detach();
+    }
+}
+
+// --- Load generator -----------------------------------------------------------------------
+
+static int connectTo(int port) {
+    int fd = socket(AF_INET, SOCK_STREAM, 0);
+    sockaddr_in address = {};
+    address.sin_family = AF_INET;
+    address.sin_port = htons((uint16_t)port);
+    inet_pton(AF_INET, "127.0.0.1", &address.sin_addr);
+    if (connect(fd, (sockaddr*)&address, sizeof(address)) != 0) {
+        close(fd);
+        return -1;
+    }
+    int on = 1;
+    setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &on, sizeof(on));
+    return fd;
+}
+
+static int runLoad(int port, double seconds, int clients, int roundsPerPost, int roundCount) {
+    double start = nowMs();
+    std::vector<SnakeReplay> rounds;
+    long ticks = 0, score = 0;
+    for (Uint32 seed = 1; (int)rounds.size() < roundCount; ++seed) {
+        SnakeReplay r;
+        if (!playAutopilotRound(seed * 2654435761u, r)) continue;
+        ticks += r.ticks;
+        score += r.score;
+        rounds.push_back(r);
+    }
+    printf("load: %d autopilot rounds in %.0f ms, %ld ticks and score %ld on average\n", roundCount, nowMs() - start,
+           ticks / roundCount, score / roundCount);
+
+    std::atomic<long> requests{ 0 }, sent{ 0 }, valid{ 0 }, failures{ 0 };
+    std::vector<std::vector<double>> latencies(clients);
+    double deadline = nowMs() + seconds * 1000.0;
+    std::vector<std::thread> threads;
+    for (int c = 0; c < clients; ++c) {
+        threads.emplace_back([&, c] {
+            int fd = connectTo(port);
+            if (fd < 0) {
+                failures++;
+                return;
+            }
+            std::vector<SnakeReplay> mine = rounds;  // Renamed per post
+            std::string buffer, body;
+            HttpMessage response;
+            for (long n = 0; nowMs() < deadline; ++n) {
+                body.clear();
+                for (int i = 0; i < roundsPerPost; ++i) {
+                    SnakeReplay& r = mine[(size_t)(n * roundsPerPost + i + c) % mine.size()];
+                    r.name = "load" + std::to_string(c) + "-" + std::to_string((n * roundsPerPost + i) % 5000);
+                    r.encode(body);
+                }
+                std::string request = "POST /submit HTTP/1.1\r\nHost: localhost\r\nContent-Length: " + std::to_string(body.size()) + "\r\n\r\n" + body;
+                double t0 = nowMs();
+                if (!writeAll(fd, request) || !readMessage(fd, buffer, response)) {
+                    failures++;
+                    break;
+                }
+                latencies[c].push_back(nowMs() - t0);
+                requests++;
+                sent += roundsPerPost;
+                for (size_t p = response.body.find("valid"); p != std::string::npos; p = response.body.find("valid", p + 5)) valid++;
+            }
+            close(fd);
+        });
+    }
+    for (std::thread& t : threads) t.join();
+
+    std::vector<double> all;
+    for (const std::vector<double>& l : latencies) all.insert(all.end(), l.begin(), l.end());
+    std::sort(all.begin(), all.end());
+    if (all.empty()) {
+        fprintf(stderr, "load: no request completed (is leaderboard_server running on port %d?)\n", port);
+        return EXIT_FAILURE;
+    }
+    printf("load: %d clients x %d rounds per post for %.0f s\n", clients, roundsPerPost, seconds);
+    printf("load: %ld requests, %ld rounds (%.0f rounds/s), %ld valid, %ld failed connections\n", requests.load(), sent.load(),
+           sent / seconds, valid.load(), failures.load());
+    printf("load: request latency p50 %.2f ms, p99 %.2f ms, max %.2f ms\n", all[all.size() / 2], all[all.size() * 99 / 100], all.back());
+
+    int fd = connectTo(port);
+    std::string buffer;
+    HttpMessage response;
+    if (fd >= 0 && writeAll(fd, "GET /stats HTTP/1.1\r\nHost: localhost\r\n\r\n") && readMessage(fd, buffer, response)) {
+        printf("server: %s", response.body.c_str());
+    }
+    if (fd >= 0) close(fd);
+    return valid == sent ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+int main(int argc, char* argv[]) {
+    int port = 8765;
+    std::string bindAddress = "127.0.0.1";
+    int workers = (int)std::max(1u, std::thread::hardware_concurrency());
+    size_t batch = 64;
+    size_t topK = 100;
+    std::string journal = "leaderboard_journal.txt";
+    std::string archive;
+    double loadSeconds = 0.0;
+    int clients = 8, roundsPerPost = 4, rounds = 32;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--port" && i + 1 < argc) port = atoi(argv[++i]);
+        else if (arg == "--bind" && i + 1 < argc) bindAddress = argv[++i];
+        else if (arg == "--workers" && i + 1 < argc) workers = std::max(1, atoi(argv[++i]));
+        else if (arg == "--batch" && i + 1 < argc) batch = std::max(1, atoi(argv[++i]));
+        else if (arg == "--top" && i + 1 < argc) topK = std::max(1, atoi(argv[++i]));
+        else if (arg == "--journal" && i + 1 < argc) journal = argv[++i];
+        else if (arg == "--archive" && i + 1 < argc) archive = argv[++i];
+        else if (arg == "--load" && i + 1 < argc) loadSeconds = atof(argv[++i]);
+        else if (arg == "--clients" && i + 1 < argc) clients = std::max(1, atoi(argv[++i]));
+        else if (arg == "--rounds-per-post" && i + 1 < argc) roundsPerPost = std::max(1, atoi(argv[++i]));
+        else if (arg == "--rounds" && i + 1 < argc) rounds = std::max(1, atoi(argv[++i]));
+        else {
+            fprintf(stderr,
+                    "usage: %s [--port N] [--bind ADDR] [--workers N] [--batch N] [--top K] [--journal FILE] [--archive NAME]\n"
+                    "       %s --load SECONDS [--port N] [--clients N] [--rounds-per-post N] [--rounds N]\n",
+                    argv[0], argv[0]);
+            return EXIT_FAILURE;
+        }
+    }
+    signal(SIGPIPE, SIG_IGN);
+    if (loadSeconds > 0.0) return runLoad(port, loadSeconds, clients, roundsPerPost, rounds);
+    return serve(bindAddress, port, workers, batch, topK, journal, archive);
+}
@@ -0,0 +1,277 @@
+#pragma once
+#include <SDL2/SDL.h>
+#include <string>
+#include <vector>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include "png_codec.h"
+#include "snake_replay.h"
+
+// Levels: a board, the rules played on it and a fixed obstacle layout, so a new mode is a file
+// instead of a rebuild. Designers write the text form and level_compiler.cpp turns it into the
+// binary one; the game takes either (--level), but the binary needs no parsing: one read and a
+// checksum, and its layout is already the cell list and occupancy bitmap the game uses.
+//
+// Text form, one setting per line ("#" starts a comment outside the layout):
+//   name Walled garden
+//   board 40 30              columns rows
+//   move-ms 100              time per move
+//   length 4                 starting length, along the top row heading right
+//   obstacles 5              random obstacles at the start of a round
+//   obstacle-every 5         one more random obstacle every N points, 0 = never
+//   edges wrap               or "wall": leaving the board ends the round
+//   layout                   last: then exactly `rows` lines of `columns` cells, "#" solid, "." open
+// Anything left out keeps the classic snakev11 value; without a layout no cell is solid.
+//
+// Binary form, integers little-endian:
+//   "SNKL" version:u32 columns:u16 rows:u16 moveMs:u16 length:u16 obstacles:u16 obstacleEvery:u16
+//   flags:u16 (1 = wrap) nameLength:u16 solidCount:u32 name solidCount x cell:u16
+//   occupancy bitmap (columns * rows bits, row-major, LSB first) crc32:u32 of everything before it
+
+class Level {
+public:
+    static const Uint32 version = 1;
+    static const int maxSide = 255;  // Cells are u16
+    static const size_t headerBytes = 28;
+
+    std::string name = "classic";
+    int columns = SnakeRules::columns;
+    int rows = SnakeRules::rows;
+    int moveMs = 100;
+    int initialLength = SnakeRules::initialLength;
+    int initialObstacles = SnakeRules::initialObstacles;
+    int obstacleEvery = SnakeRules::obstacleEvery;
+    bool wrap = true;
+
+    int cells() const { return columns * rows; }
+    bool solid(int cell) const { return (occupancy[cell >> 3] >> (cell & 7)) & 1; }
+    const std::vector<Uint16>& solidCells() const { return layout; }  // Row-major
+
+    // The rules the leaderboard server replays rounds under (snake_replay.h)
+    bool isClassic() const {
+        return columns == SnakeRules::columns && rows == SnakeRules::rows && initialLength == SnakeRules::initialLength &&
+               initialObstacles == SnakeRules::initialObstacles && obstacleEvery == SnakeRules::obstacleEvery && wrap && layout.empty();
+    }
+
+    // Reads the whole file at once, then decodes or parses it
+    bool load(const char* path, std::string& error) {
+        FILE* f = fopen(path, "rb");
+        if (!f) {
+            error = std::string("can't open ") + path;
+            return false;
+        }
+        std::string data;
+        long size = fseek(f, 0, SEEK_END) == 0 ? ftell(f) : -1;
+        if (size >= 0) {
+            data.resize((size_t)size);
+            rewind(f);
+            if (fread(&data[0], 1, data.size(), f) != data.size()) size = -1;
+        }
+        fclose(f);
+        if (size < 0) {
+            error = std::string("can't read ") + path;
+            return false;
+        }
+        return read((const Uint8*)data.data(), data.size(), error);
+    }
+
+    // Either form, told apart by the magic; on failure the level is unchanged
+    bool read(const Uint8* data, size_t size, std::string& error) {
+        Level loaded;
+        bool ok = size >= 4 && memcmp(data, "SNKL", 4) == 0 ? loaded.decode(data, size, error)
+                                                          : loaded.parse(std::string((const char*)data, size), error);
+        if (ok) *this = std::move(loaded);
+        return ok;
+    }
+
+    bool parse(const std::string& text, std::string& error) {
+        std::vector<std::string> grid;
+        bool inLayout = false;
+        int lineNumber = 0;
+        size_t start = 0;
+        while (start < text.size()) {
+            size_t end = text.find('\n', start);
+            if (end == std::string::npos) end = text.size();
+            std::string line = text.substr(start, end - start);
+            start = end + 1;
+            lineNumber++;
+            if (!line.empty() && line.back() == '\r') line.pop_back();
+            if (inLayout) {
+                grid.push_back(line);
+                inLayout = (int)grid.size() < rows;
+                continue;
+            }
+            size_t first = line.find_first_not_of(" \t");
+            if (first == std::string::npos || line[first] == '#') continue;
+            size_t keyEnd = line.find_first_of(" \t", first);
+            std::string key = line.substr(first, keyEnd == std::string::npos ? std::string::npos : keyEnd - first);
+            size_t valueStart = keyEnd == std::string::npos ? std::string::npos : line.find_first_not_of(" \t", keyEnd);
+            std::string value = valueStart == std::string::npos ? "" : line.substr(valueStart);
+            while (!value.empty() && (value.back() == ' ' || value.back() == '\t')) value.pop_back();
+            bool ok = true;
+            if (key == "name") name = value;
+            else if (key == "board") ok = sscanf(value.c_str(), "%d %d", &columns, &rows) == 2;
+            else if (key == "move-ms") ok = number(value, moveMs);
+            else if (key == "length") ok = number(value, initialLength);
+            else if (key == "obstacles") ok = number(value, initialObstacles);
+            else if (key == "obstacle-every") ok = number(value, obstacleEvery);
+            else if (key == "edges") {
+                wrap = value == "wrap";
+                ok = wrap || value == "wall";
+            } else if (key == "layout") inLayout = rows > 0;
+            else ok = false;
+            if (!ok) {
+                error = "line " + std::to_string(lineNumber) + ": can't use \"" + line + "\"";
+                return false;
+            }
+        }
+        if (!checkRules(error)) return false;
+        if (inLayout) {
+            error = "layout has " + std::to_string(grid.size()) + " rows, the board " + std::to_string(rows);
+            return false;
+        }
+        layout.clear();
+        for (int y = 0; y < (int)grid.size(); ++y) {
+            if ((int)grid[y].size() != columns) {
+                error = "layout row " + std::to_string(y + 1) + " has " + std::to_string(grid[y].size()) + " cells, the board " +
+                        std::to_string(columns);
+                return false;
+            }
+            for (int x = 0; x < columns; ++x) {
+                if (grid[y][x] == '#') layout.push_back((Uint16)(y * columns + x));
+                else if (grid[y][x] != '.') {
+                    error = "layout row " + std::to_string(y + 1) + ": '" + grid[y][x] + "' is neither '#' nor '.'";
+                    return false;
+                }
+            }
+        }
+        buildOccupancy();
+        return checkLayout(error);
+    }
+
+    // The text form; parse() gives the same level back
+    std::string source() const {
+        std::string out = "name " + name + "\n";
+        out += "board " + std::to_string(columns) + " " + std::to_string(rows) + "\n";
+        out += "move-ms " + std::to_string(moveMs) + "\n";
+        out += "length " + std::to_string(initialLength) + "\n";
+        out += "obstacles " + std::to_string(initialObstacles) + "\n";
+        out += "obstacle-every " + std::to_string(obstacleEvery) + "\n";
+        out += std::string("edges ") + (wrap ? "wrap" : "wall") + "\n";
+        if (layout.empty()) return out;
+        out += "layout\n";
+        for (int y = 0; y < rows; ++y) {
+            for (int x = 0; x < columns; ++x) out += solid(y * columns + x) ? '#' : '.';
+            out += '\n';
+        }
+        return out;
+    }
+
+    void encode(std::string& out) const {
+        size_t start = out.size();
+        out.append("SNKL", 4);
+        put32(out, version);
+        for (int v : { columns, rows, moveMs, initialLength, initialObstacles, obstacleEvery, wrap ? 1 : 0, (int)name.size() }) {
+            put16(out, (Uint16)v);
+        }
+        put32(out, (Uint32)layout.size());
+        out += name;
+        for (Uint16 c : layout) put16(out, c);
+        out.append((const char*)occupancy.data(), occupancy.size());
+        put32(out, PngEncoder::crc32(0, (const Uint8*)out.data() + start, out.size() - start));
+    }
+
+    bool decode(const Uint8* p, size_t size, std::string& error) {
+        error = "not a version " + std::to_string(version) + " level or damaged";
+        if (size < headerBytes + 4 || memcmp(p, "SNKL", 4) != 0 || get32(p + 4) != version ||
+            PngEncoder::crc32(0, p, size - 4) != get32(p + size - 4)) {
+            return false;
+        }
+        columns = get16(p + 8);
+        rows = get16(p + 10);
+        moveMs = get16(p + 12);
+        initialLength = get16(p + 14);
+        initialObstacles = get16(p + 16);
+        obstacleEvery = get16(p + 18);
+        wrap = get16(p + 20) & 1;
+        size_t nameLength = get16(p + 22);
+        size_t solidCount = get32(p + 24);
+        size_t bitmapBytes = ((size_t)columns * rows + 7) / 8;
+        if (size != headerBytes + nameLength + solidCount * 2 + bitmapBytes + 4 || !checkRules(error)) return false;
+        const Uint8* q = p + headerBytes;
+        name.assign((const char*)q, nameLength);
+        q += nameLength;
+        layout.resize(solidCount);
+        for (Uint16& c : layout) {
+            c = get16(q);
+            q += 2;
+        }
+        occupancy.assign(q, q + bitmapBytes);
+        return checkLayout(error);
+    }
+
+private:
+    std::vector<Uint16> layout;
+    std::vector<Uint8> occupancy = std::vector<Uint8>((SnakeRules::cells + 7) / 8, 0);
+
+    static bool number(const std::string& s, int& v) {
+        char* end;
+        long n = strtol(s.c_str(), &end, 10);
+        v = (int)n;
+        return !s.empty() && *end == '\0' && n >= 0 && n <= 65535;
+    }
+
+    void buildOccupancy() {
+        occupancy.assign(((size_t)cells() + 7) / 8, 0);
+        for (Uint16 c : layout) occupancy[c >> 3] |= (Uint8)(1 << (c & 7));
+    }
+
+    bool checkRules(std::string& error) {
+        if (columns < 4 || rows < 1 || columns > maxSide || rows > maxSide) error = "the board must be 4..255 columns by 1..255 rows";
+        else if (initialLength < 1 || initialLength > columns) error = "the snake must start between 1 and columns cells long";
+        else if (moveMs < 1) error = "move-ms must be at least 1";
+        else return true;
+        return false;
+    }
+
+    // The start row must be open, and there must be room for the snake, the obstacles and an apple
+    bool checkLayout(std::string& error) {
+        for (size_t i = 0; i < layout.size(); ++i) {
+            if (layout[i] >= cells() || (i > 0 && layout[i] <= layout[i - 1]) || !solid(layout[i])) {
+                error = "layout cells out of order or outside the board";
+                return false;
+            }
+        }
+        size_t bits = 0;
+        for (Uint8 b : occupancy) {
+            for (; b; b &= (Uint8)(b - 1)) bits++;
+        }
+        if (bits != layout.size()) {
+            error = "occupancy bitmap doesn't match the layout";
+            return false;
+        }
+        for (int x = 0; x < initialLength; ++x) {
+            if (solid(x)) {
+                error = "the snake's starting cells on the top row must be open";
+                return false;
+            }
+        }
+        if ((int)layout.size() + initialLength + initialObstacles + 1 > cells()) {
+            error = "no room for the snake, the obstacles and an apple";
+            return false;
+        }
+        return true;
+    }
+
+    static Uint16 get16(const Uint8* p) { return (Uint16)(p[0] | (p[1] << 8)); }
+    static Uint32 get32(const Uint8* p) { return p[0] | (p[1] << 8) | (p[2] << 16) | ((Uint32)p[3] << 24); }
+    static void put16(std::string& out, Uint16 v) {
+        out.push_back((char)v);
+        out.push_back((char)(v >> 8));
+    }
+    static void put32(std::string& out, Uint32 v) {
+        char b[4] = { (char)v, (char)(v >> 8), (char)(v >> 16), (char)(v >> 24) };
+        out.append(b, 4);
+    }
+};
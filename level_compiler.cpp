@@ -0,0 +1,54 @@
+// Level compiler (level.h): checks a level's text source and writes its binary form, which the
+// game loads with one read and no parsing.
+//
+//   g++ -O2 -std=c++17 level_compiler.cpp -o level_compiler
+//   ./level_compiler levels/walled.txt [-o levels/walled.level]
+//   ./level_compiler --dump levels/walled.level       prints the text form of either kind
+//
+// Without -o the output goes next to the source with a .level extension.
+
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include "level.h"
+
+int main(int argc, char* argv[]) {
+    std::string input, output;
+    bool dump = false, ok = true;
+    for (int i = 1; i < argc && ok; ++i) {
+        std::string arg = argv[i];
+        if (arg == "-o" && i + 1 < argc) output = argv[++i];
+        else if (arg == "--dump") dump = true;
+        else if (input.empty() && arg.compare(0, 1, "-") != 0) input = arg;
+        else ok = false;
+    }
+    if (!ok || input.empty()) {
+        fprintf(stderr, "usage: %s SOURCE [-o LEVEL] | --dump LEVEL\n", argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    Level level;
+    std::string error;
+    if (!level.load(input.c_str(), error)) {
+        fprintf(stderr, "%s: %s\n", input.c_str(), error.c_str());
+        return EXIT_FAILURE;
+    }
+    if (dump) {
+        fputs(level.source().c_str(), stdout);
+        return EXIT_SUCCESS;
+    }
+
+    if (output.empty()) output = input.substr(0, input.rfind('.')) + ".level";
+    std::string data;
+    level.encode(data);
+    FILE* f = fopen(output.c_str(), "wb");
+    ok = f && fwrite(data.data(), 1, data.size(), f) == data.size();
+    if (f) ok = fclose(f) == 0 && ok;
+    if (!ok) {
+        fprintf(stderr, "level_compiler: can't write %s\n", output.c_str());
+        return EXIT_FAILURE;
+    }
+    printf("%s: \"%s\" %dx%d, %zu solid cells, %s edges, %zu bytes\n", output.c_str(), level.name.c_str(), level.columns, level.rows,
+           level.solidCells().size(), level.wrap ? "wrapping" : "walled", data.size());
+    return EXIT_SUCCESS;
+}
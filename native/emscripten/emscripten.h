@@ -0,0 +1,55 @@
+#pragma once
+#include <SDL2/SDL.h>
+#include <cstdlib>
+
+// Native stand-in for the bits of the Emscripten API the games use, so any variant can be
+// built against desktop SDL2 by putting this directory first on the include path:
+//
+//   g++ -O2 -std=c++17 -Inative snakev11.cpp -o snakev11 -lSDL2 -lSDL2_ttf -pthread
+//
+// Set SDL_VIDEODRIVER=dummy to run without a display, and SNAKE_MAX_FRAMES=N to stop
+// the main loop after N frames.
+
+typedef void (*em_callback_func)(void);
+typedef void (*em_arg_callback_func)(void*);
+
+#define EMSCRIPTEN_KEEPALIVE
+#define EM_ASM(...) ((void)0)
+#define EM_ASM_(...) ((void)0)
+#define EM_ASM_INT(...) 0
+
+inline bool& nativeMainLoopRunning() {
+    static bool running = false;
+    return running;
+}
+
+inline double emscripten_get_now() {
+    return (double)SDL_GetPerformanceCounter() * 1000.0 / (double)SDL_GetPerformanceFrequency();
+}
+
+inline void emscripten_cancel_main_loop() {
+    nativeMainLoopRunning() = false;
+}
+
+inline void emscripten_set_main_loop_arg(em_arg_callback_func func, void* arg, int fps, int simulateInfiniteLoop) {
+    const char* limit = getenv("SNAKE_MAX_FRAMES");
+    long maxFrames = limit ? atol(limit) : 0;
+    double frameMs = fps > 0 ? 1000.0 / fps : 0.0;
+
+    nativeMainLoopRunning() = true;
+    for (long frame = 0; nativeMainLoopRunning() && (maxFrames <= 0 || frame < maxFrames); ++frame) {
+        double start = emscripten_get_now();
+        func(arg);
+        // fps == 0 means "use requestAnimationFrame"; vsync in the renderer paces us natively
+        double elapsed = emscripten_get_now() - start;
+        if (frameMs > elapsed) SDL_Delay((Uint32)(frameMs - elapsed));
+    }
+    nativeMainLoopRunning() = false;
+
+    // In the browser simulate_infinite_loop never returns control to main()
+    if (simulateInfiniteLoop) exit(EXIT_SUCCESS);
+}
+
+inline void emscripten_set_main_loop(em_callback_func func, int fps, int simulateInfiniteLoop) {
+    emscripten_set_main_loop_arg([](void* f) { ((em_callback_func)f)(); }, (void*)func, fps, simulateInfiniteLoop);
+}
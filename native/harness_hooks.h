@@ -0,0 +1,115 @@
+#pragma once
+// Golden-image harness hooks. Force-included ahead of a variant so its clock, seed and
+// presents can be driven from outside without touching the game code:
+//
+//   g++ -O2 -std=c++17 -Inative -include native/harness_hooks.h snake_mini.cpp -o snake_mini ...
+//
+// Environment:
+//   SNAKE_HARNESS_SEED   value every srand() call is replaced with (default 1)
+//   SNAKE_HARNESS_STEP   simulated milliseconds per presented frame (default 16)
+//   SNAKE_HARNESS_TIMES  comma separated simulated times (ms) to capture, ascending
+//   SNAKE_HARNESS_OUT    output prefix; writes <prefix>_<ms>.png and <prefix>.timing
+//
+// The process exits once the last requested time has been captured. Rendering goes through
+// SDL's software renderer so the output doesn't depend on the GPU or driver.
+
+#include <SDL2/SDL.h>
+#include <SDL2/SDL_ttf.h>
+#include <cstdlib>
+#include <stdlib.h>
+#include <ctime>
+#include <cstdio>
+#include <vector>
+#include <string>
+#include "../png_codec.h"
+
+#define SNAKE_HARNESS 1
+
+struct HarnessState {
+    Uint32 nowMs = 0;
+    Uint32 stepMs = 16;
+    unsigned seed = 1;
+    std::vector<Uint32> times;
+    size_t nextTime = 0;
+    std::string prefix = "harness";
+    Uint64 frameStart = 0;
+    std::vector<double> frameMs;  // Render time of each captured frame
+    bool ready = false;
+
+    void init() {
+        if (ready) return;
+        ready = true;
+        if (const char* v = getenv("SNAKE_HARNESS_SEED")) seed = (unsigned)strtoul(v, nullptr, 10);
+        if (const char* v = getenv("SNAKE_HARNESS_STEP")) stepMs = (Uint32)strtoul(v, nullptr, 10);
+        if (const char* v = getenv("SNAKE_HARNESS_OUT")) prefix = v;
+        if (const char* v = getenv("SNAKE_HARNESS_TIMES")) {
+            const char* p = v;
+            while (*p) {
+                char* end;
+                unsigned long t = strtoul(p, &end, 10);
+                if (end == p) break;
+                times.push_back((Uint32)t);
+                p = *end == ',' ? end + 1 : end;
+            }
+        }
+        if (!stepMs) stepMs = 16;
+        frameStart = SDL_GetPerformanceCounter();
+    }
+
+    void writeTiming() {
+        FILE* f = fopen((prefix + ".timing").c_str(), "w");
+        if (!f) return;
+        for (size_t i = 0; i < frameMs.size(); ++i) fprintf(f, "%u %.4f\n", (unsigned)times[i], frameMs[i]);
+        fclose(f);
+    }
+};
+
+inline HarnessState& harnessState() {
+    static HarnessState state;
+    state.init();
+    return state;
+}
+
+inline Uint32 harnessGetTicks() {
+    return harnessState().nowMs;
+}
+
+inline void harnessSrand(unsigned) {
+    srand(harnessState().seed);
+}
+
+inline SDL_Renderer* harnessCreateRenderer(SDL_Window* window, int, Uint32) {
+    return SDL_CreateRenderer(window, -1, SDL_RENDERER_SOFTWARE);
+}
+
+inline void harnessRenderPresent(SDL_Renderer* renderer) {
+    HarnessState& h = harnessState();
+    double elapsed = (double)(SDL_GetPerformanceCounter() - h.frameStart) * 1000.0 / SDL_GetPerformanceFrequency();
+
+    if (h.nextTime < h.times.size() && h.nowMs >= h.times[h.nextTime]) {
+        int w = 0, hgt = 0;
+        SDL_GetRendererOutputSize(renderer, &w, &hgt);
+        std::vector<Uint8> pixels((size_t)w * hgt * 4);
+        SDL_RenderReadPixels(renderer, nullptr, SDL_PIXELFORMAT_RGBA32, pixels.data(), w * 4);
+        char path[512];
+        snprintf(path, sizeof(path), "%s_%u.png", h.prefix.c_str(), (unsigned)h.times[h.nextTime]);
+        PngEncoder png;
+        if (!png.write(path, pixels.data(), w, hgt)) fprintf(stderr, "harness: failed to write %s\n", path);
+        h.frameMs.push_back(elapsed);
+        h.nextTime++;
+        if (h.nextTime == h.times.size()) {
+            h.writeTiming();
+            exit(EXIT_SUCCESS);
+        }
+    }
+
+    SDL_RenderPresent(renderer);
+    h.nowMs += h.stepMs;
+    h.frameStart = SDL_GetPerformanceCounter();
+}
+
+// Everything above uses the real SDL/libc entry points; from here on the variant sees the hooks
+#define SDL_GetTicks harnessGetTicks
+#define SDL_CreateRenderer harnessCreateRenderer
+#define SDL_RenderPresent harnessRenderPresent
+#define srand(seed) harnessSrand(seed)
@@ -0,0 +1,230 @@
+#pragma once
+// Performance matrix hooks. Force-included ahead of a variant so every variant can be run
+// headless with the same scripted input and report the same numbers:
+//
+//   g++ -O2 -std=c++17 -Inative -include native/perf_hooks.h snake_mini.cpp -o snake_mini ...
+//
+// Environment:
+//   SNAKE_PERF_SECONDS  wall-clock seconds to run after the first frame (default 10)
+//   SNAKE_PERF_SCRIPT   input script, see below (default: no input)
+//   SNAKE_PERF_SEED     value every srand() call is replaced with (default 1)
+//   SNAKE_PERF_OUT      output prefix; writes <prefix>.perf on exit
+//
+// The script has one "<ms> <key> [hold ms]" or "<ms> text <string>" entry per line, with
+// times measured from the first presented frame. A key entry pushes a key-down event and
+// reports the key as held in SDL_GetKeyboardState for the hold time (default 100 ms); a
+// text entry pushes a text-input event. "loop <ms>" repeats the script with that period.
+// Rendering goes through SDL's software renderer without vsync, so frame times are the
+// variant's own work rather than the display's refresh.
+
+#include <SDL2/SDL.h>
+#include <SDL2/SDL_ttf.h>
+#include <cstdlib>
+#include <stdlib.h>
+#include <ctime>
+#include <cstdio>
+#include <cstring>
+#include <vector>
+#include <string>
+#include <fstream>
+#include <sstream>
+#include <chrono>
+#include <sys/resource.h>
+#include "../sdl_stats.h"
+
+#define SNAKE_PERF 1
+
+struct PerfScriptEntry {
+    Uint32 atMs;
+    SDL_Keycode key;  // SDLK_UNKNOWN for text entries
+    Uint32 holdMs;
+    std::string text;
+};
+
+struct PerfFrame {
+    float ms;
+    int drawCalls;
+    int totalCalls;
+};
+
+struct PerfState {
+    std::chrono::steady_clock::time_point processStart = std::chrono::steady_clock::now();
+    double startupMs = -1.0;  // Process start to the end of the first present
+    Uint64 firstFrame = 0;
+    Uint64 lastPresent = 0;
+    double seconds = 10.0;
+    unsigned seed = 1;
+    std::string prefix = "perf";
+    std::vector<PerfScriptEntry> script;
+    Uint32 loopMs = 0;
+    Sint64 playedMs = -1;  // Script time up to which events have been pushed
+    Uint8 keyboard[SDL_NUM_SCANCODES];
+    std::vector<PerfFrame> frames;
+    bool ready = false;
+
+    void init() {
+        if (ready) return;
+        ready = true;
+        if (const char* v = getenv("SNAKE_PERF_SECONDS")) seconds = atof(v);
+        if (const char* v = getenv("SNAKE_PERF_SEED")) seed = (unsigned)strtoul(v, nullptr, 10);
+        if (const char* v = getenv("SNAKE_PERF_OUT")) prefix = v;
+        if (const char* v = getenv("SNAKE_PERF_SCRIPT")) loadScript(v);
+        frames.reserve((size_t)(seconds * 2000) + 1024);
+    }
+
+    void loadScript(const char* path) {
+        std::ifstream file(path);
+        if (!file) {
+            fprintf(stderr, "perf: can't open script %s\n", path);
+            return;
+        }
+        std::string line;
+        while (std::getline(file, line)) {
+            if (line.empty() || line[0] == '#') continue;
+            std::istringstream in(line);
+            std::string first, key;
+            in >> first;
+            if (first == "loop") {
+                in >> loopMs;
+                continue;
+            }
+            PerfScriptEntry e;
+            e.atMs = (Uint32)strtoul(first.c_str(), nullptr, 10);
+            e.key = SDLK_UNKNOWN;
+            e.holdMs = 100;
+            if (!(in >> key)) continue;
+            if (key == "text") {
+                in >> e.text;
+            } else {
+                e.key = SDL_GetKeyFromName(key.c_str());
+                if (e.key == SDLK_UNKNOWN) {
+                    fprintf(stderr, "perf: unknown key '%s' in script\n", key.c_str());
+                    continue;
+                }
+                in >> e.holdMs;
+            }
+            script.push_back(e);
+        }
+    }
+
+    Uint32 elapsedMs() const {
+        if (!firstFrame) return 0;
+        return (Uint32)((SDL_GetPerformanceCounter() - firstFrame) * 1000 / SDL_GetPerformanceFrequency());
+    }
+
+    // Pushes the events of every script entry (and loop repetition) that came due since the last call
+    void playScript() {
+        if (!firstFrame || script.empty()) return;
+        Sint64 now = elapsedMs();
+        for (const PerfScriptEntry& e : script) {
+            Sint64 at = e.atMs;
+            if (loopMs && at <= playedMs) at += ((playedMs - at) / loopMs + 1) * loopMs;
+            for (; at > playedMs && at <= now; at += loopMs) {
+                pushEvent(e);
+                if (!loopMs) break;
+            }
+        }
+        playedMs = now;
+    }
+
+    void pushEvent(const PerfScriptEntry& e) {
+        SDL_Event event;
+        memset(&event, 0, sizeof(event));
+        if (e.key == SDLK_UNKNOWN) {
+            event.type = SDL_TEXTINPUT;
+            strncpy(event.text.text, e.text.c_str(), sizeof(event.text.text) - 1);
+        } else {
+            event.type = SDL_KEYDOWN;
+            event.key.state = SDL_PRESSED;
+            event.key.keysym.sym = e.key;
+            event.key.keysym.scancode = SDL_GetScancodeFromKey(e.key);
+        }
+        SDL_PushEvent(&event);
+    }
+
+    // Real keyboard state with the script's held keys pressed on top
+    const Uint8* keyboardState(int* numkeys) {
+        int count = 0;
+        const Uint8* real = SDL_GetKeyboardState(&count);
+        if (count > SDL_NUM_SCANCODES) count = SDL_NUM_SCANCODES;
+        memset(keyboard, 0, sizeof(keyboard));
+        if (real) memcpy(keyboard, real, count);
+        Uint32 now = elapsedMs();
+        Uint32 t = loopMs ? now % loopMs : now;
+        for (const PerfScriptEntry& e : script) {
+            if (e.key != SDLK_UNKNOWN && t >= e.atMs && t < e.atMs + e.holdMs) keyboard[SDL_GetScancodeFromKey(e.key)] = 1;
+        }
+        if (numkeys) *numkeys = SDL_NUM_SCANCODES;
+        return keyboard;
+    }
+
+    void writeResults() {
+        FILE* f = fopen((prefix + ".perf").c_str(), "w");
+        if (!f) return;
+        struct rusage usage;
+        getrusage(RUSAGE_SELF, &usage);
+#ifdef __APPLE__
+        long peakKb = usage.ru_maxrss / 1024;  // Bytes on macOS
+#else
+        long peakKb = usage.ru_maxrss;
+#endif
+        fprintf(f, "startup_ms %.3f\npeak_rss_kb %ld\nframes %zu\n", startupMs, peakKb, frames.size());
+        for (const PerfFrame& frame : frames) fprintf(f, "frame %.4f %d %d\n", frame.ms, frame.drawCalls, frame.totalCalls);
+        fclose(f);
+    }
+};
+
+inline PerfState& perfState() {
+    static PerfState state;
+    state.init();
+    return state;
+}
+
+// Started before main() so startup covers SDL/TTF init, font loading and the first frame
+[[maybe_unused]] static PerfState& perfProcessStart = perfState();
+
+inline void perfSrand(unsigned) {
+    srand(perfState().seed);
+}
+
+inline SDL_Renderer* perfCreateRenderer(SDL_Window* window, int, Uint32) {
+    return SDL_CreateRenderer(window, -1, SDL_RENDERER_SOFTWARE);
+}
+
+inline int perfPollEvent(SDL_Event* event) {
+    perfState().playScript();
+    return SDL_PollEvent(event);
+}
+
+inline const Uint8* perfGetKeyboardState(int* numkeys) {
+    return perfState().keyboardState(numkeys);
+}
+
+inline void perfRenderPresent(SDL_Renderer* renderer) {
+    PerfState& p = perfState();
+    SDL_RenderPresent(renderer);
+    Uint64 now = SDL_GetPerformanceCounter();
+    const SdlCallStats& calls = SdlStats::instance().current;
+    if (!p.firstFrame) {
+        p.firstFrame = now;
+        p.startupMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - p.processStart).count();
+    } else {
+        PerfFrame frame = { (float)((now - p.lastPresent) * 1000.0 / SDL_GetPerformanceFrequency()), calls.drawCalls(), calls.totalCalls() };
+        p.frames.push_back(frame);
+    }
+    p.lastPresent = now;
+    sdlStatsEndFrame();
+    if ((now - p.firstFrame) >= (Uint64)(p.seconds * SDL_GetPerformanceFrequency())) {
+        p.writeResults();
+        exit(EXIT_SUCCESS);
+    }
+}
+
+// Everything above uses the real SDL/libc entry points; from here on the variant sees the hooks.
+// Per-frame SDL call counters are closed here at present, so a variant's own call is dropped.
+#define SDL_CreateRenderer perfCreateRenderer
+#define SDL_PollEvent perfPollEvent
+#define SDL_GetKeyboardState perfGetKeyboardState
+#define SDL_RenderPresent perfRenderPresent
+#define srand(seed) perfSrand(seed)
+#define sdlStatsEndFrame() ((void)0)
@@ -0,0 +1,88 @@
+#include <SDL2/SDL.h>
+#include <vector>
+#include <string>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <fstream>
+#include "asset_pack.h"
+
+// Builds the asset pack for the web build from a manifest of the files the game actually
+// loads (assets.txt), replacing --preload-file ./ and its copy of the whole working tree:
+//
+//   pack_assets [-o snake.pak] [--store] [--list PACK] [manifest]
+//
+// Each file is deflated unless that makes it bigger; --store skips compression. --list
+// prints the index of an existing pack and checks every asset against its checksum.
+
+bool readFile(const std::string& path, std::vector<Uint8>& data) {
+    std::ifstream in(path, std::ios::binary);
+    if (!in) return false;
+    data.assign(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+    return true;
+}
+
+int listPack(const char* path) {
+    AssetPack pack;
+    if (!pack.open(path)) {
+        std::cerr << "Can't open " << path << "\n";
+        return EXIT_FAILURE;
+    }
+    int failures = 0;
+    std::vector<Uint8> data;
+    printf("%-32s %10s %10s %6s  %s\n", "asset", "size", "packed", "ratio", "check");
+    for (const AssetPackEntry& e : pack.list()) {
+        bool ok = pack.load(e.name, data);
+        failures += ok ? 0 : 1;
+        printf("%-32s %10u %10u %5.1f%%  %s\n", e.name.c_str(), e.size, e.packedSize,
+               e.size ? 100.0 * e.packedSize / e.size : 100.0, ok ? "ok" : "FAILED");
+    }
+    return failures ? EXIT_FAILURE : EXIT_SUCCESS;
+}
+
+int main(int argc, char* argv[]) {
+    std::string manifest = "assets.txt";
+    std::string output = "snake.pak";
+    bool compress = true;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "-o" && i + 1 < argc) output = argv[++i];
+        else if (arg == "--store") compress = false;
+        else if (arg == "--list" && i + 1 < argc) return listPack(argv[++i]);
+        else if (arg[0] == '-') {
+            std::cerr << "usage: pack_assets [-o PACK] [--store] [--list PACK] [manifest]\n";
+            return EXIT_FAILURE;
+        } else manifest = arg;
+    }
+
+    std::ifstream in(manifest);
+    if (!in) {
+        std::cerr << "Can't open manifest " << manifest << "\n";
+        return EXIT_FAILURE;
+    }
+    AssetPackWriter writer;
+    std::string line;
+    std::vector<Uint8> data;
+    while (std::getline(in, line)) {
+        while (!line.empty() && (line.back() == '\r' || line.back() == ' ')) line.pop_back();
+        if (line.empty() || line[0] == '#') continue;
+        if (!readFile(line, data)) {
+            std::cerr << "Can't read " << line << " (listed in " << manifest << ")\n";
+            return EXIT_FAILURE;
+        }
+        writer.add(line, data, compress);
+    }
+    if (!writer.write(output.c_str())) {
+        std::cerr << "Can't write " << output << "\n";
+        return EXIT_FAILURE;
+    }
+
+    size_t total = 0, packed = 0;
+    for (const AssetPackEntry& e : writer.list()) {
+        printf("%-32s %10u -> %10u\n", e.name.c_str(), e.size, e.packedSize);
+        total += e.size;
+        packed += e.packedSize;
+    }
+    printf("%s: %zu assets, %zu -> %zu bytes\n", output.c_str(), writer.list().size(), total, packed);
+    return EXIT_SUCCESS;
+}
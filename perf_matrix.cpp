@@ -0,0 +1,198 @@
+#include <vector>
+#include <string>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <algorithm>
+#include <filesystem>
+
+// Cross-variant performance matrix. Builds every variant natively with the hooks from
+// native/perf_hooks.h, runs each one headless for the same number of seconds under the
+// same scripted input (perf/script.txt) and prints one row per variant: frame time
+// percentiles, SDL draw calls per frame, peak resident memory and time to first frame.
+//
+//   perf_matrix [--seconds N] [--script perf/script.txt] [--seed N] [--repeat N]
+//               [--csv] [--cxx g++] [variant.cpp...]
+//
+// Run from the repository root (the variants load arial.ttf relative to it). With --repeat
+// every variant runs several times and each column reports the median run. The software
+// renderer is used throughout, so the numbers rank CPU-side rendering work, not GPU cost.
+
+namespace fs = std::filesystem;
+
+const char* defaultVariants[] = {
+    "snake-game.cpp", "snake_fixed.cpp", "snake_fixedv3.cpp", "snake_game_v3_final.cpp", "snake_v5.cpp",
+    "snake_mini.cpp", "snakev11.cpp", "snake_gamev4.cpp", "snake_game_beta.cpp", "snake_game-v3.cpp",
+};
+
+struct Options {
+    double seconds = 10.0;
+    int repeat = 1;
+    unsigned seed = 42;
+    bool csv = false;
+    std::string scriptPath = "perf/script.txt";
+    std::string cxx = "g++";
+    std::string outDir = "_perf_out";
+};
+
+struct RunResult {
+    double startupMs = 0.0;
+    long peakRssKb = 0;
+    double fps = 0.0;
+    double p50 = 0.0, p95 = 0.0, p99 = 0.0, maxMs = 0.0;
+    double drawCalls = 0.0;   // Average per frame
+    double totalCalls = 0.0;  // Average per frame, including state changes and texture churn
+    size_t frames = 0;
+};
+
+std::string stem(const std::string& source) {
+    return fs::path(source).stem().string();
+}
+
+bool buildVariant(const Options& opt, const std::string& source, const std::string& binary) {
+    std::string cmd = opt.cxx + " -O2 -std=c++17 -w -Inative -include native/perf_hooks.h " + source +
+                      " -o " + binary + " -lSDL2 -lSDL2_ttf -pthread > " + binary + ".log 2>&1";
+    return system(cmd.c_str()) == 0;
+}
+
+double percentile(std::vector<float>& samples, double p) {
+    size_t k = (size_t)(p * (samples.size() - 1) + 0.5);
+    std::nth_element(samples.begin(), samples.begin() + k, samples.end());
+    return samples[k];
+}
+
+bool readResults(const std::string& path, RunResult& result) {
+    std::ifstream file(path);
+    if (!file) return false;
+    std::vector<float> frameMs;
+    double sumMs = 0.0, sumDraws = 0.0, sumCalls = 0.0;
+    std::string line;
+    while (std::getline(file, line)) {
+        std::istringstream in(line);
+        std::string key;
+        in >> key;
+        if (key == "startup_ms") in >> result.startupMs;
+        else if (key == "peak_rss_kb") in >> result.peakRssKb;
+        else if (key == "frame") {
+            float ms;
+            int draws, calls;
+            if (!(in >> ms >> draws >> calls)) continue;
+            frameMs.push_back(ms);
+            sumMs += ms;
+            sumDraws += draws;
+            sumCalls += calls;
+        }
+    }
+    if (frameMs.empty()) return false;
+    result.frames = frameMs.size();
+    result.fps = sumMs > 0.0 ? 1000.0 * frameMs.size() / sumMs : 0.0;
+    result.drawCalls = sumDraws / frameMs.size();
+    result.totalCalls = sumCalls / frameMs.size();
+    result.maxMs = *std::max_element(frameMs.begin(), frameMs.end());
+    result.p50 = percentile(frameMs, 0.50);
+    result.p95 = percentile(frameMs, 0.95);
+    result.p99 = percentile(frameMs, 0.99);
+    return true;
+}
+
+bool runVariant(const Options& opt, const std::string& binary, const std::string& prefix, RunResult& result) {
+    std::string cmd = "SDL_VIDEODRIVER=dummy SDL_AUDIODRIVER=dummy SNAKE_PERF_SECONDS=" + std::to_string(opt.seconds) +
+                      " SNAKE_PERF_SEED=" + std::to_string(opt.seed) + " SNAKE_PERF_SCRIPT=" + opt.scriptPath +
+                      " SNAKE_PERF_OUT=" + prefix + " ./" + binary + " > " + prefix + ".log 2>&1";
+    fs::remove(prefix + ".perf");
+    if (system(cmd.c_str()) != 0) return false;
+    return readResults(prefix + ".perf", result);
+}
+
+// Column-wise median over the repeated runs
+RunResult median(std::vector<RunResult>& runs) {
+    RunResult m = runs[0];
+    auto pick = [&](auto field) {
+        std::vector<double> values;
+        for (const RunResult& r : runs) values.push_back((double)(r.*field));
+        std::sort(values.begin(), values.end());
+        return values[values.size() / 2];
+    };
+    m.startupMs = pick(&RunResult::startupMs);
+    m.peakRssKb = (long)pick(&RunResult::peakRssKb);
+    m.fps = pick(&RunResult::fps);
+    m.p50 = pick(&RunResult::p50);
+    m.p95 = pick(&RunResult::p95);
+    m.p99 = pick(&RunResult::p99);
+    m.maxMs = pick(&RunResult::maxMs);
+    m.drawCalls = pick(&RunResult::drawCalls);
+    m.totalCalls = pick(&RunResult::totalCalls);
+    m.frames = (size_t)pick(&RunResult::frames);
+    return m;
+}
+
+int main(int argc, char* argv[]) {
+    Options opt;
+    std::vector<std::string> variants;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--seconds" && i + 1 < argc) opt.seconds = atof(argv[++i]);
+        else if (arg == "--script" && i + 1 < argc) opt.scriptPath = argv[++i];
+        else if (arg == "--seed" && i + 1 < argc) opt.seed = (unsigned)strtoul(argv[++i], nullptr, 10);
+        else if (arg == "--repeat" && i + 1 < argc) opt.repeat = std::max(1, atoi(argv[++i]));
+        else if (arg == "--csv") opt.csv = true;
+        else if (arg == "--cxx" && i + 1 < argc) opt.cxx = argv[++i];
+        else if (arg[0] == '-') {
+            std::cerr << "usage: perf_matrix [--seconds N] [--script FILE] [--seed N] [--repeat N]\n"
+                         "                   [--csv] [--cxx COMPILER] [variant.cpp...]\n";
+            return EXIT_FAILURE;
+        } else variants.push_back(arg);
+    }
+    if (variants.empty()) variants.assign(std::begin(defaultVariants), std::end(defaultVariants));
+    if (!fs::exists(opt.scriptPath)) {
+        std::cerr << "No input script at " << opt.scriptPath << "\n";
+        return EXIT_FAILURE;
+    }
+    fs::create_directories(opt.outDir + "/bin");
+
+    int failures = 0;
+    if (opt.csv) {
+        printf("variant,frames,fps,p50_ms,p95_ms,p99_ms,max_ms,draw_calls,sdl_calls,peak_rss_mb,startup_ms\n");
+    } else {
+        printf("%-24s %7s %7s %8s %8s %8s %8s %8s %8s %8s %10s\n", "variant", "frames", "fps", "p50 ms", "p95 ms",
+               "p99 ms", "max ms", "draws", "sdl", "rss MB", "startup ms");
+    }
+    for (const std::string& source : variants) {
+        std::string name = stem(source);
+        std::string binary = opt.outDir + "/bin/" + name;
+        if (!buildVariant(opt, source, binary)) {
+            if (!opt.csv) printf("%-24s %-8s (see %s.log)\n", name.c_str(), "NOBUILD", binary.c_str());
+            failures++;
+            continue;
+        }
+
+        std::string prefix = opt.outDir + "/" + name;
+        std::vector<RunResult> runs;
+        for (int r = 0; r < opt.repeat; ++r) {
+            RunResult result;
+            if (!runVariant(opt, binary, prefix, result)) break;
+            runs.push_back(result);
+        }
+        if ((int)runs.size() < opt.repeat) {
+            if (!opt.csv) printf("%-24s %-8s (see %s.log)\n", name.c_str(), "NORUN", prefix.c_str());
+            failures++;
+            continue;
+        }
+
+        RunResult m = median(runs);
+        double rssMb = m.peakRssKb / 1024.0;
+        if (opt.csv) {
+            printf("%s,%zu,%.1f,%.3f,%.3f,%.3f,%.3f,%.1f,%.1f,%.1f,%.1f\n", name.c_str(), m.frames, m.fps, m.p50, m.p95,
+                   m.p99, m.maxMs, m.drawCalls, m.totalCalls, rssMb, m.startupMs);
+        } else {
+            printf("%-24s %7zu %7.1f %8.3f %8.3f %8.3f %8.3f %8.1f %8.1f %8.1f %10.1f\n", name.c_str(), m.frames, m.fps,
+                   m.p50, m.p95, m.p99, m.maxMs, m.drawCalls, m.totalCalls, rssMb, m.startupMs);
+        }
+        fflush(stdout);
+    }
+
+    if (failures && !opt.csv) printf("\n%d variant(s) failed to build or run; logs are in %s/\n", failures, opt.outDir.c_str());
+    return failures ? EXIT_FAILURE : EXIT_SUCCESS;
+}
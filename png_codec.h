@@ -0,0 +1,439 @@
+#pragma once
+#include <SDL2/SDL.h>
+#include <array>
+#include <vector>
+#include <cstdio>
+#include <cstring>
+#include <cstdlib>
+
+// Minimal PNG writer: one IDAT made by a fixed-Huffman LZ77 deflate. Game frames are mostly
+// flat colour, so this gets most of zlib's ratio without the dependency.
+class PngEncoder {
+public:
+    bool write(const char* path, const Uint8* rgba, int width, int height) {
+        // Filter type 0 (None) per scanline
+        raw.resize((size_t)(width * 4 + 1) * height);
+        for (int y = 0; y < height; ++y) {
+            Uint8* row = &raw[(size_t)y * (width * 4 + 1)];
+            row[0] = 0;
+            memcpy(row + 1, rgba + (size_t)y * width * 4, (size_t)width * 4);
+        }
+        deflate();
+
+        FILE* f = fopen(path, "wb");
+        if (!f) return false;
+        static const Uint8 signature[8] = { 0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n' };
+        fwrite(signature, 1, 8, f);
+        Uint8 ihdr[13] = { 0 };
+        putBE(ihdr, (Uint32)width);
+        putBE(ihdr + 4, (Uint32)height);
+        ihdr[8] = 8;  // Bit depth
+        ihdr[9] = 6;  // RGBA
+        writeChunk(f, "IHDR", ihdr, 13);
+        writeChunk(f, "IDAT", out.data(), out.size());
+        writeChunk(f, "IEND", nullptr, 0);
+        bool ok = ferror(f) == 0;
+        fclose(f);
+        return ok;
+    }
+
+    // The same deflate on its own, as a zlib stream (asset packs use it)
+    void compress(const Uint8* data, size_t size, std::vector<Uint8>& zlib) {
+        raw.assign(data, data + size);
+        deflate();
+        zlib.swap(out);
+    }
+
+    // CRC-32 as PNG chunks use it; score_store.h checks its files with it too. Safe from any
+    // thread (leaderboard_server's verifiers call it at once): the table is built on first use
+    static Uint32 crc32(Uint32 crc, const Uint8* data, size_t len) {
+        static const std::array<Uint32, 256> table = [] {
+            std::array<Uint32, 256> t;
+            for (Uint32 n = 0; n < 256; ++n) {
+                Uint32 c = n;
+                for (int k = 0; k < 8; ++k) c = (c & 1) ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+                t[n] = c;
+            }
+            return t;
+        }();
+        crc = ~crc;
+        for (size_t i = 0; i < len; ++i) crc = table[(crc ^ data[i]) & 0xFF] ^ (crc >> 8);
+        return ~crc;
+    }
+
+private:
+    std::vector<Uint8> raw;
+    std::vector<Uint8> out;
+    std::vector<int> head;
+    Uint32 bitBuffer;
+    int bitCount;
+
+    static void putBE(Uint8* p, Uint32 v) {
+        p[0] = (Uint8)(v >> 24); p[1] = (Uint8)(v >> 16); p[2] = (Uint8)(v >> 8); p[3] = (Uint8)v;
+    }
+
+    static void writeChunk(FILE* f, const char* type, const Uint8* data, size_t len) {
+        Uint8 header[8];
+        putBE(header, (Uint32)len);
+        memcpy(header + 4, type, 4);
+        fwrite(header, 1, 8, f);
+        if (len) fwrite(data, 1, len, f);
+        Uint32 crc = crc32(crc32(0, (const Uint8*)type, 4), data, len);
+        Uint8 crcBytes[4];
+        putBE(crcBytes, crc);
+        fwrite(crcBytes, 1, 4, f);
+    }
+
+    void putBits(Uint32 value, int count) {
+        bitBuffer |= value << bitCount;
+        bitCount += count;
+        while (bitCount >= 8) {
+            out.push_back((Uint8)bitBuffer);
+            bitBuffer >>= 8;
+            bitCount -= 8;
+        }
+    }
+
+    // Huffman codes are sent most significant bit first
+    void putCode(Uint32 code, int length) {
+        Uint32 reversed = 0;
+        for (int i = 0; i < length; ++i) reversed |= ((code >> i) & 1) << (length - 1 - i);
+        putBits(reversed, length);
+    }
+
+    void putLiteral(int symbol) {
+        if (symbol < 144) putCode(0x30 + symbol, 8);
+        else if (symbol < 256) putCode(0x190 + symbol - 144, 9);
+        else if (symbol < 280) putCode(symbol - 256, 7);
+        else putCode(0xC0 + symbol - 280, 8);
+    }
+
+    void putMatch(int length, int distance) {
+        static const int lengthBase[29] = { 3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31, 35, 43, 51, 59,
+                                            67, 83, 99, 115, 131, 163, 195, 227, 258 };
+        static const int lengthExtra[29] = { 0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2, 3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0 };
+        static const int distBase[30] = { 1, 2, 3, 4, 5, 7, 9, 13, 17, 25, 33, 49, 65, 97, 129, 193, 257, 385, 513, 769,
+                                          1025, 1537, 2049, 3073, 4097, 6145, 8193, 12289, 16385, 24577 };
+        static const int distExtra[30] = { 0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6, 7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13 };
+        int l = 28;
+        while (lengthBase[l] > length) l--;
+        putLiteral(257 + l);
+        putBits((Uint32)(length - lengthBase[l]), lengthExtra[l]);
+        int d = 29;
+        while (distBase[d] > distance) d--;
+        putCode((Uint32)d, 5);
+        putBits((Uint32)(distance - distBase[d]), distExtra[d]);
+    }
+
+    void deflate() {
+        out.clear();
+        bitBuffer = 0;
+        bitCount = 0;
+        out.push_back(0x78);  // zlib header: deflate, 32K window
+        out.push_back(0x01);
+        putBits(1, 1);        // Final block
+        putBits(1, 2);        // Fixed Huffman
+
+        const int hashSize = 1 << 15;
+        head.assign(hashSize, -1);
+        size_t n = raw.size();
+        size_t i = 0;
+        while (i < n) {
+            int bestLength = 0;
+            int bestDistance = 0;
+            if (i + 3 <= n) {
+                Uint32 h = ((raw[i] << 16) | (raw[i + 1] << 8) | raw[i + 2]) * 2654435761u >> 17;
+                int candidate = head[h];
+                head[h] = (int)i;
+                if (candidate >= 0 && i - candidate <= 32768) {
+                    size_t maxLength = n - i < 258 ? n - i : 258;
+                    size_t len = 0;
+                    while (len < maxLength && raw[candidate + len] == raw[i + len]) len++;
+                    if (len >= 3) {
+                        bestLength = (int)len;
+                        bestDistance = (int)(i - candidate);
+                    }
+                }
+            }
+            if (bestLength) {
+                putMatch(bestLength, bestDistance);
+                i += bestLength;
+            } else {
+                putLiteral(raw[i]);
+                i++;
+            }
+        }
+        putLiteral(256);  // End of block
+        if (bitCount) putBits(0, 8 - bitCount);
+
+        // Adler-32 of the uncompressed data
+        Uint32 a = 1, b = 0;
+        for (size_t k = 0; k < n; ++k) {
+            a = (a + raw[k]) % 65521;
+            b = (b + a) % 65521;
+        }
+        Uint8 adler[4];
+        putBE(adler, (b << 16) | a);
+        out.insert(out.end(), adler, adler + 4);
+    }
+};
+
+
+// Minimal PNG reader for 8-bit RGB/RGBA, non-interlaced images, which covers our own
+// captures and anything an image editor saves over a golden. Always returns RGBA.
+class PngDecoder {
+public:
+    bool read(const char* path, std::vector<Uint8>& rgba, int& width, int& height) {
+        std::vector<Uint8> file;
+        FILE* f = fopen(path, "rb");
+        if (!f) return false;
+        Uint8 chunk[65536];
+        size_t got;
+        while ((got = fread(chunk, 1, sizeof(chunk), f)) > 0) file.insert(file.end(), chunk, chunk + got);
+        fclose(f);
+
+        static const Uint8 signature[8] = { 0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n' };
+        if (file.size() < 8 || memcmp(file.data(), signature, 8) != 0) return false;
+
+        std::vector<Uint8> idat;
+        int channels = 0;
+        width = height = 0;
+        size_t pos = 8;
+        while (pos + 12 <= file.size()) {
+            Uint32 len = getBE(&file[pos]);
+            const char* type = (const char*)&file[pos + 4];
+            const Uint8* data = &file[pos + 8];
+            if (pos + 12 + len > file.size()) return false;
+            if (!memcmp(type, "IHDR", 4)) {
+                width = (int)getBE(data);
+                height = (int)getBE(data + 4);
+                if (data[8] != 8 || data[12] != 0) return false;  // 8-bit, non-interlaced only
+                if (data[9] == 6) channels = 4;
+                else if (data[9] == 2) channels = 3;
+                else return false;
+            } else if (!memcmp(type, "IDAT", 4)) {
+                idat.insert(idat.end(), data, data + len);
+            } else if (!memcmp(type, "IEND", 4)) {
+                break;
+            }
+            pos += 12 + len;
+        }
+        if (!channels || width <= 0 || height <= 0 || idat.size() < 2) return false;
+
+        size_t stride = (size_t)width * channels;
+        raw.clear();
+        raw.reserve((stride + 1) * height);
+        if (!inflate(idat.data() + 2, idat.size() - 2) || raw.size() < (stride + 1) * height) return false;
+
+        // Undo the per-scanline filters in place
+        for (int y = 0; y < height; ++y) {
+            Uint8* row = &raw[(size_t)y * (stride + 1)];
+            Uint8* line = row + 1;
+            const Uint8* prev = y ? line - (stride + 1) : nullptr;
+            for (size_t x = 0; x < stride; ++x) {
+                int a = x >= (size_t)channels ? line[x - channels] : 0;
+                int b = prev ? prev[x] : 0;
+                int c = prev && x >= (size_t)channels ? prev[x - channels] : 0;
+                switch (row[0]) {
+                    case 0: break;
+                    case 1: line[x] = (Uint8)(line[x] + a); break;
+                    case 2: line[x] = (Uint8)(line[x] + b); break;
+                    case 3: line[x] = (Uint8)(line[x] + ((a + b) >> 1)); break;
+                    case 4: {
+                        int p = a + b - c;
+                        int pa = abs(p - a), pb = abs(p - b), pc = abs(p - c);
+                        line[x] = (Uint8)(line[x] + (pa <= pb && pa <= pc ? a : pb <= pc ? b : c));
+                        break;
+                    }
+                    default: return false;
+                }
+            }
+        }
+
+        rgba.resize((size_t)width * height * 4);
+        for (int y = 0; y < height; ++y) {
+            const Uint8* line = &raw[(size_t)y * (stride + 1) + 1];
+            Uint8* dst = &rgba[(size_t)y * width * 4];
+            for (int x = 0; x < width; ++x) {
+                dst[x * 4 + 0] = line[x * channels + 0];
+                dst[x * 4 + 1] = line[x * channels + 1];
+                dst[x * 4 + 2] = line[x * channels + 2];
+                dst[x * 4 + 3] = channels == 4 ? line[x * channels + 3] : 255;
+            }
+        }
+        return true;
+    }
+
+    // Inflate a whole zlib stream; expectedSize only sizes the buffer up front
+    bool decompress(const Uint8* zlib, size_t size, std::vector<Uint8>& data, size_t expectedSize = 0) {
+        if (size < 2) return false;
+        raw.clear();
+        raw.reserve(expectedSize);
+        if (!inflate(zlib + 2, size - 2)) return false;
+        data.swap(raw);
+        return true;
+    }
+
+private:
+    struct Huffman {
+        short count[16];
+        short symbol[320];
+    };
+
+    std::vector<Uint8> raw;
+    const Uint8* in;
+    size_t inSize;
+    size_t inPos;
+    Uint32 bitBuffer;
+    int bitCount;
+    bool overrun;
+
+    static Uint32 getBE(const Uint8* p) {
+        return ((Uint32)p[0] << 24) | ((Uint32)p[1] << 16) | ((Uint32)p[2] << 8) | p[3];
+    }
+
+    int bits(int count) {
+        while (bitCount < count) {
+            if (inPos >= inSize) {
+                overrun = true;
+                return 0;
+            }
+            bitBuffer |= (Uint32)in[inPos++] << bitCount;
+            bitCount += 8;
+        }
+        int value = (int)(bitBuffer & ((1u << count) - 1));
+        bitBuffer >>= count;
+        bitCount -= count;
+        return value;
+    }
+
+    static void build(Huffman& h, const Uint8* lengths, int n) {
+        short offsets[16];
+        memset(h.count, 0, sizeof(h.count));
+        for (int i = 0; i < n; ++i) h.count[lengths[i]]++;
+        h.count[0] = 0;
+        offsets[1] = 0;
+        for (int len = 1; len < 15; ++len) offsets[len + 1] = offsets[len] + h.count[len];
+        for (int i = 0; i < n; ++i) {
+            if (lengths[i]) h.symbol[offsets[lengths[i]]++] = (short)i;
+        }
+    }
+
+    // Canonical codes are read one bit at a time, most significant first
+    int decode(const Huffman& h) {
+        int code = 0, first = 0, index = 0;
+        for (int len = 1; len < 16; ++len) {
+            code |= bits(1);
+            int count = h.count[len];
+            if (code - count < first) return h.symbol[index + (code - first)];
+            index += count;
+            first = (first + count) << 1;
+            code <<= 1;
+            if (overrun) return -1;
+        }
+        return -1;
+    }
+
+    bool codes(const Huffman& lengthCodes, const Huffman& distCodes) {
+        static const short lengthBase[29] = { 3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31, 35, 43, 51, 59,
+                                              67, 83, 99, 115, 131, 163, 195, 227, 258 };
+        static const short lengthExtra[29] = { 0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2, 3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0 };
+        static const short distBase[30] = { 1, 2, 3, 4, 5, 7, 9, 13, 17, 25, 33, 49, 65, 97, 129, 193, 257, 385, 513, 769,
+                                            1025, 1537, 2049, 3073, 4097, 6145, 8193, 12289, 16385, 24577 };
+        static const short distExtra[30] = { 0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6, 7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13 };
+        for (;;) {
+            int symbol = decode(lengthCodes);
+            if (symbol < 0) return false;
+            if (symbol < 256) {
+                raw.push_back((Uint8)symbol);
+            } else if (symbol == 256) {
+                return true;
+            } else {
+                symbol -= 257;
+                if (symbol >= 29) return false;
+                int length = lengthBase[symbol] + bits(lengthExtra[symbol]);
+                int d = decode(distCodes);
+                if (d < 0 || d >= 30) return false;
+                size_t distance = (size_t)(distBase[d] + bits(distExtra[d]));
+                if (overrun || distance > raw.size()) return false;
+                size_t from = raw.size() - distance;
+                for (int i = 0; i < length; ++i) raw.push_back(raw[from + i]);
+            }
+        }
+    }
+
+    bool inflate(const Uint8* data, size_t size) {
+        in = data;
+        inSize = size;
+        inPos = 0;
+        bitBuffer = 0;
+        bitCount = 0;
+        overrun = false;
+
+        int last;
+        do {
+            last = bits(1);
+            int type = bits(2);
+            if (type == 0) {
+                // Stored block: drop the partial byte, then LEN/NLEN and raw bytes
+                bitBuffer = 0;
+                bitCount = 0;
+                if (inPos + 4 > inSize) return false;
+                size_t len = in[inPos] | (in[inPos + 1] << 8);
+                inPos += 4;
+                if (inPos + len > inSize) return false;
+                raw.insert(raw.end(), in + inPos, in + inPos + len);
+                inPos += len;
+            } else if (type == 1) {
+                Uint8 lengths[288 + 30];
+                for (int i = 0; i < 144; ++i) lengths[i] = 8;
+                for (int i = 144; i < 256; ++i) lengths[i] = 9;
+                for (int i = 256; i < 280; ++i) lengths[i] = 7;
+                for (int i = 280; i < 288; ++i) lengths[i] = 8;
+                for (int i = 0; i < 30; ++i) lengths[288 + i] = 5;
+                Huffman lengthCodes, distCodes;
+                build(lengthCodes, lengths, 288);
+                build(distCodes, lengths + 288, 30);
+                if (!codes(lengthCodes, distCodes)) return false;
+            } else if (type == 2) {
+                static const Uint8 order[19] = { 16, 17, 18, 0, 8, 7, 9, 6, 10, 5, 11, 4, 12, 3, 13, 2, 14, 1, 15 };
+                int literalCount = bits(5) + 257;
+                int distCount = bits(5) + 1;
+                int codeCount = bits(4) + 4;
+                if (literalCount > 286 || distCount > 30) return false;
+                Uint8 lengths[320] = { 0 };
+                for (int i = 0; i < codeCount; ++i) lengths[order[i]] = (Uint8)bits(3);
+                Huffman lengthCodes, distCodes;
+                build(lengthCodes, lengths, 19);
+                int index = 0;
+                while (index < literalCount + distCount) {
+                    int symbol = decode(lengthCodes);
+                    if (symbol < 0) return false;
+                    if (symbol < 16) {
+                        lengths[index++] = (Uint8)symbol;
+                        continue;
+                    }
+                    int value = 0, repeat;
+                    if (symbol == 16) {
+                        if (index == 0) return false;
+                        value = lengths[index - 1];
+                        repeat = 3 + bits(2);
+                    } else if (symbol == 17) {
+                        repeat = 3 + bits(3);
+                    } else {
+                        repeat = 11 + bits(7);
+                    }
+                    if (index + repeat > literalCount + distCount) return false;
+                    while (repeat--) lengths[index++] = (Uint8)value;
+                }
+                build(lengthCodes, lengths, literalCount);
+                build(distCodes, lengths + literalCount, distCount);
+                if (!codes(lengthCodes, distCodes)) return false;
+            } else {
+                return false;
+            }
+            if (overrun) return false;
+        } while (!last);
+        return true;
+    }
+};
@@ -0,0 +1,170 @@
+#pragma once
+#include <SDL2/SDL.h>
+#include <vector>
+#include <algorithm>
+#include "trace_events.h"
+
+// Frame profiler. Code marks nestable zones with PROFILE_ZONE("name"); each zone's
+// inclusive time is summed per frame and kept in a ring buffer of recent frames, from
+// which p50/p95/p99 are computed on demand. A zone costs two performance-counter reads,
+// so it stays compiled into release builds; setEnabled(false) turns it into a branch.
+// While the TraceRecorder is recording, every zone is also emitted as a trace event.
+//
+//   void render() {
+//       PROFILE_ZONE("render");
+//       ...
+//   }
+
+class Profiler {
+public:
+    static const int maxZones = 48;
+    static const int historyFrames = 240;  // About four seconds at 60 Hz
+
+    struct ZoneStats {
+        const char* name;
+        int depth;
+        float average, p50, p95, p99;  // Milliseconds per frame
+        float calls;                   // Average calls per frame
+    };
+
+    static Profiler& instance() {
+        static Profiler profiler;
+        return profiler;
+    }
+
+    // Zone ids are handed out once per call site; nesting depth is taken from the first call
+    int registerZone(const char* name) {
+        for (int i = 0; i < zoneCount; ++i) {
+            if (zones[i].name == name) return i;
+        }
+        if (zoneCount == maxZones) return -1;
+        zones[zoneCount].name = name;
+        zones[zoneCount].depth = stackDepth;
+        return zoneCount++;
+    }
+
+    void setEnabled(bool on) { enabled = on; }
+    bool isEnabled() const { return enabled; }
+
+    void beginFrame() {
+        if (!enabled) return;
+        Uint64 now = SDL_GetPerformanceCounter();
+        if (frameStart) intervals[head] = toMs(now - frameStart);
+        frameStart = now;
+        stackDepth = 0;
+        for (int i = 0; i < zoneCount; ++i) {
+            zones[i].frameTicks = 0;
+            zones[i].frameCalls = 0;
+        }
+    }
+
+    void endFrame() {
+        if (!enabled || !frameStart) return;
+        Uint64 now = SDL_GetPerformanceCounter();
+        frameTimes[head] = toMs(now - frameStart);
+        TraceRecorder::instance().complete("frame", frameStart, now);
+        for (int i = 0; i < zoneCount; ++i) {
+            zones[i].history[head] = toMs(zones[i].frameTicks);
+            zones[i].calls[head] = (Uint16)std::min(zones[i].frameCalls, 65535);
+        }
+        head = (head + 1) % historyFrames;
+        if (filled < historyFrames) filled++;
+    }
+
+    Uint64 enter(int zone) {
+        if (!enabled || zone < 0) return 0;
+        stackDepth++;
+        return SDL_GetPerformanceCounter();
+    }
+
+    void leave(int zone, Uint64 start) {
+        if (!start) return;
+        Uint64 end = SDL_GetPerformanceCounter();
+        zones[zone].frameTicks += end - start;
+        TraceRecorder::instance().complete(zones[zone].name, start, end);
+        zones[zone].frameCalls++;
+        stackDepth--;
+    }
+
+    int frameCount() const { return filled; }
+
+    // CPU time of a recorded frame, 0 = most recent
+    float frameMs(int framesAgo) const {
+        return frameTimes[(head - 1 - framesAgo + 2 * historyFrames) % historyFrames];
+    }
+
+    // Percentiles over the history window: frame work time, frame interval, then every zone
+    // in registration order (which is also nesting order for the first frame)
+    void computeStats(ZoneStats& frame, ZoneStats& interval, std::vector<ZoneStats>& out) {
+        frame = summarize("frame", 0, frameTimes, nullptr);
+        interval = summarize("interval", 0, intervals, nullptr);
+        out.clear();
+        for (int i = 0; i < zoneCount; ++i) out.push_back(summarize(zones[i].name, zones[i].depth, zones[i].history, zones[i].calls));
+    }
+
+private:
+    struct Zone {
+        const char* name = nullptr;
+        int depth = 0;
+        Uint64 frameTicks = 0;
+        int frameCalls = 0;
+        float history[historyFrames] = {};
+        Uint16 calls[historyFrames] = {};
+    };
+
+    Zone zones[maxZones];
+    int zoneCount = 0;
+    int stackDepth = 0;
+    bool enabled = true;
+    Uint64 frameStart = 0;
+    float frameTimes[historyFrames] = {};
+    float intervals[historyFrames] = {};
+    int head = 0;
+    int filled = 0;
+    std::vector<float> scratch;
+
+    static float toMs(Uint64 ticks) {
+        static const double scale = 1000.0 / (double)SDL_GetPerformanceFrequency();
+        return (float)(ticks * scale);
+    }
+
+    ZoneStats summarize(const char* name, int depth, const float* samples, const Uint16* calls) {
+        ZoneStats s = { name, depth, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f };
+        if (!filled) return s;
+        scratch.assign(samples, samples + filled);
+        float sum = 0.0f;
+        for (float v : scratch) sum += v;
+        s.average = sum / filled;
+        s.p50 = percentile(0.50f);
+        s.p95 = percentile(0.95f);
+        s.p99 = percentile(0.99f);
+        if (calls) {
+            long total = 0;
+            for (int i = 0; i < filled; ++i) total += calls[i];
+            s.calls = (float)total / filled;
+        }
+        return s;
+    }
+
+    float percentile(float p) {
+        size_t k = (size_t)(p * (scratch.size() - 1) + 0.5f);
+        std::nth_element(scratch.begin(), scratch.begin() + k, scratch.end());
+        return scratch[k];
+    }
+};
+
+class ProfileScope {
+public:
+    explicit ProfileScope(int zoneId) : zone(zoneId), start(Profiler::instance().enter(zoneId)) {}
+    ~ProfileScope() { Profiler::instance().leave(zone, start); }
+
+private:
+    int zone;
+    Uint64 start;
+};
+
+#define PROFILE_CONCAT_INNER(a, b) a##b
+#define PROFILE_CONCAT(a, b) PROFILE_CONCAT_INNER(a, b)
+#define PROFILE_ZONE(name)                                                                           \
+    static const int PROFILE_CONCAT(profileZone, __LINE__) = Profiler::instance().registerZone(name); \
+    ProfileScope PROFILE_CONCAT(profileScope, __LINE__)(PROFILE_CONCAT(profileZone, __LINE__))
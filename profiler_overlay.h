@@ -0,0 +1,109 @@
+#pragma once
+#include <SDL2/SDL.h>
+#include <vector>
+#include <string>
+#include <algorithm>
+#include <cstdio>
+#include "sdl_stats.h"
+#include "alloc_tracker.h"
+#include "profiler.h"
+#include "render_commands.h"
+
+// On-screen view of the Profiler: a bar graph of recent frame times against the 60 Hz
+// budget, frame percentiles, the slowest zones by p95, last frame's SDL call counts and,
+// in builds with SNAKE_TRACK_ALLOCS, its heap allocations.
+// Recorded into the Overlay layer of a command buffer; percentiles are only recomputed a
+// few times a second.
+
+class ProfilerOverlay {
+public:
+    static const int graphFrames = 120;
+    static const int topZones = 5;
+
+    ProfilerOverlay() : visible(false), framesUntilRefresh(0) {}
+
+    void toggle() { visible = !visible; }
+    void setVisible(bool on) { visible = on; }
+    bool isVisible() const { return visible; }
+
+    void draw(RenderCommandBuffer& cmd, int x, int y) {
+        if (!visible) return;
+        Profiler& profiler = Profiler::instance();
+        if (--framesUntilRefresh <= 0) {
+            refresh(profiler);
+            framesUntilRefresh = 15;
+        }
+
+        const int width = 2 * graphFrames + 130;
+        const int graphHeight = 64;
+        const float graphMaxMs = 33.3f;
+        const int lineHeight = 26;
+        int extraLines = AllocTracker::compiledIn() ? 1 : 0;
+        int height = graphHeight + 16 + lineHeight * (4 + extraLines + (int)lines.size());
+        cmd.setLayer(LayerOverlay);
+        cmd.fillRect({ x, y, width, height }, { 10, 10, 20, 255 });
+        cmd.rect({ x, y, width, height }, { 0, 255, 255, 255 });
+
+        // Frame time bars, newest on the right, coloured against the 16.7 ms budget
+        int baseY = y + 8 + graphHeight;
+        int frames = std::min(profiler.frameCount(), graphFrames);
+        for (int i = 0; i < frames; ++i) {
+            float ms = profiler.frameMs(i);
+            int h = std::min(graphHeight, std::max(1, (int)(ms / graphMaxMs * graphHeight)));
+            SDL_Color c = ms < 8.0f ? SDL_Color{ 0, 200, 0, 255 } : ms < 16.7f ? SDL_Color{ 220, 200, 0, 255 } : SDL_Color{ 255, 40, 40, 255 };
+            cmd.fillRect({ x + 8 + 2 * (graphFrames - 1 - i), baseY - h, 2, h }, c);
+        }
+        int budgetY = baseY - (int)(16.7f / graphMaxMs * graphHeight);
+        cmd.line(x + 8, budgetY, x + 8 + 2 * graphFrames, budgetY, { 255, 255, 255, 255 });
+
+        int textY = baseY + 8;
+        cmd.text(frameLine, x + 8, textY, { 255, 255, 255, 255 }, 0);
+        cmd.text(intervalLine, x + 8, textY + lineHeight, { 180, 180, 180, 255 }, 0);
+        for (size_t i = 0; i < lines.size(); ++i) {
+            cmd.text(lines[i], x + 8, textY + lineHeight * (int)(i + 2), { 0, 255, 255, 255 }, 0);
+        }
+
+        // SDL call volume of the previous frame (this frame's calls are still being made)
+        const SdlCallStats& calls = SdlStats::instance().last;
+        char buf[128];
+        int callsY = textY + lineHeight * (int)(lines.size() + 2);
+        snprintf(buf, sizeof(buf), "sdl %d draw %d all", calls.drawCalls(), calls.totalCalls());
+        cmd.text(buf, x + 8, callsY, { 255, 180, 0, 255 }, 0);
+        snprintf(buf, sizeof(buf), "%ldk px tex +%d/-%d ttf %d", calls.pixels / 1000, calls.texturesCreated,
+                 calls.texturesDestroyed, calls.ttfRenders);
+        cmd.text(buf, x + 8, callsY + lineHeight, { 255, 180, 0, 255 }, 0);
+
+        if (AllocTracker::compiledIn()) {
+            const AllocTracker& allocs = AllocTracker::instance();
+            const AllocTracker::FrameAllocs& frame = allocs.lastFrame();
+            snprintf(buf, sizeof(buf), "alloc %ld %ldk max %ld", frame.allocations, frame.bytes / 1024, allocs.recentMax());
+            cmd.text(buf, x + 8, callsY + 2 * lineHeight, frame.allocations ? SDL_Color{ 255, 80, 80, 255 } : SDL_Color{ 0, 200, 0, 255 }, 0);
+        }
+    }
+
+private:
+    bool visible;
+    int framesUntilRefresh;
+    std::string frameLine;
+    std::string intervalLine;
+    std::vector<std::string> lines;
+    std::vector<Profiler::ZoneStats> stats;
+
+    void refresh(Profiler& profiler) {
+        Profiler::ZoneStats frame, interval;
+        profiler.computeStats(frame, interval, stats);
+        char buf[128];
+        snprintf(buf, sizeof(buf), "cpu %.2f/%.2f/%.2f ms", frame.p50, frame.p95, frame.p99);
+        frameLine = buf;
+        snprintf(buf, sizeof(buf), "frame %.2f/%.2f/%.2f ms", interval.p50, interval.p95, interval.p99);
+        intervalLine = buf;
+
+        std::sort(stats.begin(), stats.end(),
+                  [](const Profiler::ZoneStats& a, const Profiler::ZoneStats& b) { return a.p95 > b.p95; });
+        lines.clear();
+        for (size_t i = 0; i < stats.size() && (int)i < topZones; ++i) {
+            snprintf(buf, sizeof(buf), "%-9s %5.2f %5.2f", stats[i].name, stats[i].p50, stats[i].p95);
+            lines.push_back(buf);
+        }
+    }
+};
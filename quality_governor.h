@@ -0,0 +1,167 @@
+#pragma once
+#include <SDL2/SDL.h>
+
+// Adaptive quality governor shared by the visual variants (snakev11, snake_v5,
+// snake-game). It watches the measured frame time over a sliding window and
+// steps between quality tiers. Dropping a tier is quick, climbing back is slow,
+// and every failed climb doubles the wait before the next one so we don't
+// oscillate between two tiers on a borderline machine.
+
+enum QualityTier { QualityUltra = 0, QualityHigh, QualityMedium, QualityLow, QualityTierCount };
+
+struct QualitySettings {
+    const char* name;
+    float glowScale;        // Multiplier for glow radius
+    int glowStep;           // Radius step between glow rings
+    int backgroundInterval; // Redraw background every N frames (1 = every frame)
+    int maxParticles;       // Live particle cap
+    int textGlowLayers;     // Extra shadow/glow passes per text draw
+    bool scanlines;         // CRT scanline overlay
+};
+
+const QualitySettings qualityTiers[QualityTierCount] = {
+    { "ULTRA",  1.00f, 1, 1, 400, 3, true  },
+    { "HIGH",   0.75f, 1, 2, 200, 2, true  },
+    { "MEDIUM", 0.50f, 2, 4, 100, 1, false },
+    { "LOW",    0.30f, 3, 8,  40, 0, false },
+};
+
+class QualityGovernor {
+public:
+    static const int windowSize = 90;         // Frames in the sliding window
+    static const int upgradeWindow = 240;     // Stable frames needed before climbing a tier
+    static const int minUpgradeDelay = 240;   // Initial frames to wait after any tier change
+
+    explicit QualityGovernor(float targetFrameMs = 1000.0f / 60.0f)
+        : targetMs(targetFrameMs), current(QualityUltra), forced(-1), count(0), head(0), sum(0.0f),
+          stableFrames(0), framesSinceChange(0), upgradeDelay(minUpgradeDelay), lastChangeWasUpgrade(false) {
+        for (int i = 0; i < windowSize; ++i) samples[i] = 0.0f;
+    }
+
+    // Feed the duration of the last frame. Returns true if the tier changed.
+    bool addFrameTime(float frameMs) {
+        if (frameMs <= 0.0f) return false;
+        if (frameMs > 250.0f) frameMs = 250.0f; // Tab switches and breakpoints shouldn't count
+
+        if (count == windowSize) sum -= samples[head];
+        else count++;
+        samples[head] = frameMs;
+        sum += frameMs;
+        head = (head + 1) % windowSize;
+        framesSinceChange++;
+
+        if (forced >= 0 || count < windowSize) return false;
+
+        float avg = averageFrameMs();
+        if (avg > targetMs * 1.2f) {
+            stableFrames = 0;
+            if (current < QualityLow) {
+                // A climb that immediately fails makes the next attempt wait twice as long
+                if (lastChangeWasUpgrade && framesSinceChange < upgradeDelay * 2) {
+                    upgradeDelay = upgradeDelay * 2 > 7200 ? 7200 : upgradeDelay * 2;
+                }
+                changeTier(current + 1, false);
+                return true;
+            }
+        } else if (avg < targetMs * 1.05f) {
+            stableFrames++;
+            if (current > QualityUltra && stableFrames >= upgradeWindow && framesSinceChange >= upgradeDelay) {
+                changeTier(current - 1, true);
+                return true;
+            }
+        } else {
+            stableFrames = 0;
+        }
+        return false;
+    }
+
+    // Pin a tier (0..QualityTierCount-1) or pass -1 to return to automatic control
+    void forceTier(int tier) {
+        if (tier < 0 || tier >= QualityTierCount) {
+            forced = -1;
+            return;
+        }
+        forced = tier;
+        changeTier(tier, false);
+    }
+
+    QualityTier tier() const { return current; }
+    bool isForced() const { return forced >= 0; }
+    const QualitySettings& settings() const { return qualityTiers[current]; }
+    float averageFrameMs() const { return count ? sum / count : 0.0f; }
+
+private:
+    float targetMs;
+    QualityTier current;
+    int forced;
+    float samples[windowSize];
+    int count;
+    int head;
+    float sum;
+    int stableFrames;
+    int framesSinceChange;
+    int upgradeDelay;
+    bool lastChangeWasUpgrade;
+
+    void changeTier(int tier, bool upgrade) {
+        current = (QualityTier)tier;
+        lastChangeWasUpgrade = upgrade;
+        if (!upgrade && framesSinceChange >= upgradeDelay * 4) upgradeDelay = minUpgradeDelay; // Long stable run, forgive
+        framesSinceChange = 0;
+        stableFrames = 0;
+        // Start the new tier with a fresh window so old samples don't trigger another step
+        count = 0;
+        head = 0;
+        sum = 0.0f;
+    }
+};
+
+// Render-target cache for backgrounds that only need refreshing every few frames.
+// begin() returns true when the caller should draw the background (into the cache
+// texture if one is in use); end() then blits the cached frame to the screen.
+class BackgroundCache {
+public:
+    BackgroundCache() : texture(nullptr), frame(0), drawing(false) {}
+    ~BackgroundCache() { release(); }
+
+    bool begin(SDL_Renderer* renderer, int width, int height, int interval) {
+        frame++;
+        if (interval <= 1) {
+            release(); // Full quality draws straight to the screen
+            return true;
+        }
+        if (!texture) {
+            texture = SDL_CreateTexture(renderer, SDL_PIXELFORMAT_RGBA8888, SDL_TEXTUREACCESS_TARGET, width, height);
+            if (!texture) return true; // No render target support, fall back to direct drawing
+            frame = 0;
+        }
+        drawing = (frame % interval) == 0;
+        if (drawing) SDL_SetRenderTarget(renderer, texture);
+        return drawing;
+    }
+
+    void end(SDL_Renderer* renderer) {
+        if (!texture) return;
+        finish(renderer);
+        SDL_RenderCopy(renderer, texture, nullptr, nullptr);
+    }
+
+    // Like end(), but leaves drawing the cached texture to the caller (e.g. as a sprite command)
+    void finish(SDL_Renderer* renderer) {
+        if (drawing) SDL_SetRenderTarget(renderer, nullptr);
+        drawing = false;
+    }
+
+    // Cached background texture, or null when drawing straight to the screen
+    SDL_Texture* cached() const { return texture; }
+
+    void release() {
+        if (texture) SDL_DestroyTexture(texture);
+        texture = nullptr;
+    }
+
+private:
+    SDL_Texture* texture;
+    unsigned frame;
+    bool drawing;
+};
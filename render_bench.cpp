@@ -0,0 +1,206 @@
+// Render microbenchmarks: each drawing primitive of a variant called many times into an
+// offscreen target, reporting microseconds and SDL calls per call. Runs on SDL's software
+// renderer, so with the dummy video driver it needs no display or GPU, and the numbers
+// compare the primitive implementations themselves rather than a driver.
+//
+//   g++ -O2 -std=c++17 -Inative render_bench.cpp -o render_bench_v11 -lSDL2 -lSDL2_ttf -pthread
+//   g++ -O2 -std=c++17 -Inative -DRENDER_BENCH_V5 render_bench.cpp -o render_bench_v5 -lSDL2 -lSDL2_ttf -pthread
+//   g++ -O2 -std=c++17 -Inative -DRENDER_BENCH_GAME render_bench.cpp -o render_bench_game -lSDL2 -lSDL2_ttf -pthread
+//   ./render_bench_v11 [--min-ms N] [--tier 0-3] [--csv]
+//
+// Run from the repository root: snake_v5 and snake-game open arial.ttf in their constructors,
+// and snakev11 loads it in its startup stages, run here by finishStartup(). snakev11 records
+// into a command buffer, so its timings include the backend submit that turns the commands
+// into SDL calls.
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+#include <functional>
+#include <algorithm>
+
+#include "sdl_stats.h"  // Before the game, so its SDL calls are counted
+
+#define SNAKE_NO_MAIN
+#if defined(RENDER_BENCH_V5)
+#include "snake_v5.cpp"
+#elif defined(RENDER_BENCH_GAME)
+#include "snake-game.cpp"
+#else
+#include "snakev11.cpp"
+#endif
+
+struct BenchCase {
+    const char* name;
+    std::function<void()> draw;
+};
+
+// The primitives each variant has, called the way the variant's own render code calls them.
+// Positions wander over the target so clipping and cache effects match a real frame.
+struct RenderBench {
+    static const int targetWidth = 800;
+    static const int targetHeight = 600;
+
+    static int px(int i) { return 40 + (i * 97) % (targetWidth - 80); }
+    static int py(int i) { return 40 + (i * 61) % (targetHeight - 80); }
+
+    // Swaps the game's renderer for a software one drawing into an offscreen texture. The
+    // variants ask for an accelerated renderer, which the dummy driver can't provide, and a
+    // window only takes one renderer, so whatever the constructor got is destroyed first. Its
+    // draw blend mode carries over: most variants keep SDL's default (none), snake_v5 blends.
+    static SDL_Renderer* useSoftwareTarget(SnakeGame& g) {
+        SDL_BlendMode blend = SDL_BLENDMODE_NONE;
+        if (g.renderer) {
+            SDL_GetRenderDrawBlendMode(g.renderer, &blend);
+            SDL_DestroyRenderer(g.renderer);
+        }
+        SDL_Renderer* r = SDL_CreateRenderer(g.window, -1, SDL_RENDERER_SOFTWARE | SDL_RENDERER_TARGETTEXTURE);
+        if (!r) return nullptr;
+        SDL_SetRenderDrawBlendMode(r, blend);
+        SDL_Texture* target = SDL_CreateTexture(r, SDL_PIXELFORMAT_ARGB8888, SDL_TEXTUREACCESS_TARGET, targetWidth, targetHeight);
+        if (!target || SDL_SetRenderTarget(r, target) != 0) return nullptr;
+        SDL_SetRenderDrawColor(r, 0, 0, 0, 255);
+        SDL_RenderClear(r);
+        g.renderer = r;
+#if !defined(RENDER_BENCH_V5) && !defined(RENDER_BENCH_GAME)
+        // snakev11 loads its font in startup stages; run them here, onto this renderer
+        g.startup.quiet = true;
+        g.finishStartup();
+#endif
+        return r;
+    }
+
+#if defined(RENDER_BENCH_V5)
+    static const char* variant() { return "snake_v5"; }
+
+    static std::vector<BenchCase> cases(SnakeGame& g) {
+        static int i = 0;
+        return {
+            { "drawAdvancedGlow", [&g] { i++; g.drawAdvancedGlow(px(i), py(i), 35, 120, { 255, 60, 60, 255 }); } },
+            { "drawCircle", [&g] { i++; SDL_SetRenderDrawColor(g.renderer, 255, 255, 0, 255); g.drawCircle(px(i), py(i), 10); } },
+            { "fillCircle", [&g] { i++; SDL_SetRenderDrawColor(g.renderer, 255, 255, 0, 255); g.fillCircle(px(i), py(i), 10); } },
+            { "drawEnhancedText", [&g] { i++; g.drawEnhancedText("Score: 1234", px(i), py(i), { 255, 255, 255, 255 }, false); } },
+            { "renderApple", [&g] { i++; g.renderRealisticApple(Apple((float)(px(i) / 20 * 20), (float)(py(i) / 20 * 20))); } },
+        };
+    }
+#elif defined(RENDER_BENCH_GAME)
+    static const char* variant() { return "snake-game"; }
+
+    static std::vector<BenchCase> cases(SnakeGame& g) {
+        static int i = 0;
+        return {
+            { "drawGlow", [&g] { i++; g.drawGlow((float)px(i), (float)py(i), 35, 120, { 255, 60, 60, 255 }); } },
+            { "fillCircle", [&g] { i++; SDL_SetRenderDrawColor(g.renderer, 255, 255, 0, 255); g.fillCircle(px(i), py(i), 10); } },
+            { "drawTextWithGlow", [&g] { i++; g.drawTextWithGlow("Score: 1234", px(i), py(i), { 255, 255, 255, 255 }, false); } },
+            { "renderApple", [&g] {
+                i++;
+                Apple apple((float)(px(i) / 20 * 20), (float)(py(i) / 20 * 20));
+                g.renderApple(apple);
+            } },
+        };
+    }
+#else
+    static const char* variant() { return "snakev11"; }
+
+    // Records one primitive and submits it on its own, as a frame with one command would
+    static void submit(SnakeGame& g) {
+        g.renderBackend.submit(g.commands);
+        g.commands.clear();
+    }
+
+    static std::vector<BenchCase> cases(SnakeGame& g) {
+        static int i = 0;
+        return {
+            { "drawGlow", [&g] { i++; g.drawGlow(px(i), py(i), 35, 120, { 255, 60, 60, 255 }); submit(g); } },
+            { "drawCircle", [&g] { i++; g.commands.circle(px(i), py(i), 10, { 255, 255, 0, 255 }); submit(g); } },
+            { "fillCircle", [&g] { i++; g.commands.fillCircle(px(i), py(i), 10, { 255, 255, 0, 255 }); submit(g); } },
+            { "drawText", [&g] { i++; g.drawText("Score: 1234", px(i), py(i), { 255, 255, 255, 255 }); submit(g); } },
+            { "renderApple", [&g] { i++; g.renderApple(Apple((float)(px(i) / 20 * 20), (float)(py(i) / 20 * 20))); submit(g); } },
+        };
+    }
+#endif
+};
+
+struct Result {
+    double usPerCall;
+    double drawCallsPerCall;
+    double sdlCallsPerCall;
+    double pixelsPerCall;
+};
+
+// Times batches of calls until one takes at least minMs. SDL batches draws internally, so
+// every batch ends with SDL_RenderFlush to make the rasterization land inside the timing.
+Result measure(SDL_Renderer* renderer, const BenchCase& c, double minMs) {
+    for (int i = 0; i < 16; ++i) c.draw();  // Warm glyph caches and vector capacities
+    SDL_RenderFlush(renderer);
+
+    long calls = 16;
+    for (;;) {
+        SdlCallStats before = SdlStats::instance().current;
+        auto start = std::chrono::steady_clock::now();
+        for (long i = 0; i < calls; ++i) c.draw();
+        SDL_RenderFlush(renderer);
+        auto end = std::chrono::steady_clock::now();
+        const SdlCallStats& after = SdlStats::instance().current;
+        double ms = std::chrono::duration<double, std::milli>(end - start).count();
+        if (ms >= minMs || calls >= (1L << 24)) {
+            Result r;
+            r.usPerCall = ms * 1000.0 / calls;
+            r.drawCallsPerCall = (double)(after.drawCalls() - before.drawCalls()) / calls;
+            r.sdlCallsPerCall = (double)(after.totalCalls() - before.totalCalls()) / calls;
+            r.pixelsPerCall = (double)(after.pixels - before.pixels) / calls;
+            return r;
+        }
+        calls *= ms > 0.5 ? std::max(2L, (long)(minMs / ms) + 1) : 8;
+        // Counters are per frame; start a fresh one so they can't overflow on long runs
+        sdlStatsEndFrame();
+    }
+}
+
+int main(int argc, char* argv[]) {
+    double minMs = 200.0;
+    int tier = 0;
+    bool csv = false;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--min-ms" && i + 1 < argc) minMs = atof(argv[++i]);
+        else if (arg == "--tier" && i + 1 < argc) tier = atoi(argv[++i]);
+        else if (arg == "--csv") csv = true;
+        else {
+            fprintf(stderr, "usage: %s [--min-ms N] [--tier 0-3] [--csv]\n", argv[0]);
+            return EXIT_FAILURE;
+        }
+    }
+
+    // The constructor opens a window (and most variants load the font); keep that off-screen
+    SDL_setenv("SDL_VIDEODRIVER", "dummy", 0);
+    SnakeGame* game = new SnakeGame();
+    game->forceQualityTier(tier);
+
+    SDL_Renderer* renderer = RenderBench::useSoftwareTarget(*game);
+    if (!renderer) {
+        fprintf(stderr, "no software render target: %s\n", SDL_GetError());
+        return EXIT_FAILURE;
+    }
+
+    if (csv) printf("variant,primitive,tier,us_per_call,draw_calls_per_call,sdl_calls_per_call,pixels_per_call\n");
+    else printf("%-10s %-18s %4s %10s %11s %10s %10s\n", "variant", "primitive", "tier", "us/call", "draws/call", "sdl/call", "px/call");
+
+    for (const BenchCase& c : RenderBench::cases(*game)) {
+        Result r = measure(renderer, c, minMs);
+        if (csv) {
+            printf("%s,%s,%d,%.2f,%.1f,%.1f,%.0f\n", RenderBench::variant(), c.name, tier, r.usPerCall, r.drawCallsPerCall,
+                   r.sdlCallsPerCall, r.pixelsPerCall);
+        } else {
+            printf("%-10s %-18s %4d %10.2f %11.1f %10.1f %10.0f\n", RenderBench::variant(), c.name, tier, r.usPerCall,
+                   r.drawCallsPerCall, r.sdlCallsPerCall, r.pixelsPerCall);
+        }
+        fflush(stdout);
+    }
+
+    // Skip the destructor: snake_v5 and snake-game would write the high-score file (snakev11's
+    // ScoreStore only saves when a name is entered)
+    return EXIT_SUCCESS;
+}
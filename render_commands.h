@@ -0,0 +1,456 @@
+#pragma once
+#include <SDL2/SDL.h>
+#ifndef SNAKE_NO_TTF
+#include <SDL2/SDL_ttf.h>
+#else
+typedef struct _TTF_Font TTF_Font;  // Text comes from a BitmapFont only
+#endif
+#include <vector>
+#include <string>
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <cmath>
+#include "profiler.h"
+#include "bitmap_font.h"
+
+// Render command buffer. Game code records high-level draw commands instead of
+// calling SDL directly; a backend then sorts them, merges runs that share state
+// and submits them. Buffers are plain data, so they can be filled on several
+// threads and appended together, or saved to disk and replayed offline.
+
+enum RenderCommandType : Uint8 {
+    CmdClear,
+    CmdFillRect,
+    CmdRect,
+    CmdLine,
+    CmdPoint,
+    CmdCircle,      // Outline, x/y = center, w = radius
+    CmdFillCircle,  // Filled, x/y = center, w = radius
+    CmdGlow,        // Concentric rings, x/y = center, w = radius, h = ring step, color.a = peak alpha
+    CmdText,        // x/y = position, w/h = offset/length in the text pool
+    CmdSprite       // x/y/w/h = destination, texture = source
+};
+
+// Render layers, drawn back to front
+enum RenderLayer : Uint8 {
+    LayerBackground = 0,
+    LayerBackgroundOverlay,
+    LayerWorld,
+    LayerParticles,
+    LayerUI,
+    LayerOverlay
+};
+
+enum TextFlags : Uint8 {
+    TextCentered = 1,
+    TextShadow = 2
+};
+
+struct RenderCommand {
+    Uint64 sortKey;  // layer:4 | state:36 (type:4 | rgba:32) | sequence:24
+    RenderCommandType type;
+    Uint8 flags;
+    SDL_Color color;
+    int x, y, w, h;
+    SDL_Texture* texture;
+};
+static_assert(CmdSprite < 16 && LayerOverlay < 16, "type and layer have 4 bits each in sortKey");
+
+class RenderCommandBuffer {
+public:
+    RenderCommandBuffer() : layer(LayerBackground), unordered(false), sequence(0) {
+        commands.reserve(4096);
+        textPool.reserve(1024);
+    }
+
+    void clear() {
+        commands.clear();
+        textPool.clear();
+        sequence = 0;
+        layer = LayerBackground;
+        unordered = false;
+    }
+
+    // Commands in an unordered layer don't overlap each other, so the backend may
+    // regroup them by state. Ordered layers keep submission order.
+    void setLayer(RenderLayer newLayer, bool isUnordered = false) {
+        layer = newLayer;
+        unordered = isUnordered;
+    }
+
+    void clearScreen(SDL_Color c) { push(CmdClear, c, 0, 0, 0, 0); }
+    void fillRect(const SDL_Rect& r, SDL_Color c) { push(CmdFillRect, c, r.x, r.y, r.w, r.h); }
+    void rect(const SDL_Rect& r, SDL_Color c) { push(CmdRect, c, r.x, r.y, r.w, r.h); }
+    void line(int x1, int y1, int x2, int y2, SDL_Color c) { push(CmdLine, c, x1, y1, x2, y2); }
+    void point(int x, int y, SDL_Color c) { push(CmdPoint, c, x, y, 0, 0); }
+    void circle(int cx, int cy, int radius, SDL_Color c) { push(CmdCircle, c, cx, cy, radius, 0); }
+    void fillCircle(int cx, int cy, int radius, SDL_Color c) { push(CmdFillCircle, c, cx, cy, radius, 0); }
+
+    void glow(int cx, int cy, int radius, int step, int alpha, SDL_Color c) {
+        if (radius <= 0 || alpha <= 0) return;
+        c.a = (Uint8)(alpha > 255 ? 255 : alpha);
+        push(CmdGlow, c, cx, cy, radius, step < 1 ? 1 : step);
+    }
+
+    void text(const std::string& str, int x, int y, SDL_Color c, Uint8 textFlags) { text(str.data(), str.size(), x, y, c, textFlags); }
+
+    // Copies the bytes into the pool, so literals and stack buffers need no std::string
+    void text(const char* str, size_t length, int x, int y, SDL_Color c, Uint8 textFlags) {
+        if (!length) return;
+        RenderCommand& cmd = push(CmdText, c, x, y, (int)textPool.size(), (int)length);
+        cmd.flags = textFlags;
+        textPool.append(str, length);
+        textPool.push_back('\0');
+    }
+
+    void sprite(SDL_Texture* texture, const SDL_Rect& dst) {
+        if (!texture) return;
+        push(CmdSprite, { 255, 255, 255, 255 }, dst.x, dst.y, dst.w, dst.h).texture = texture;
+    }
+
+    // Merge another buffer (e.g. one filled on a worker thread) after this one's commands
+    void append(const RenderCommandBuffer& other) {
+        int poolBase = (int)textPool.size();
+        for (RenderCommand cmd : other.commands) {
+            if (cmd.type == CmdText) cmd.w += poolBase;
+            cmd.sortKey = (cmd.sortKey & ~(Uint64)0xFFFFFF) | (sequence++ & 0xFFFFFF);
+            commands.push_back(cmd);
+        }
+        textPool.append(other.textPool);
+    }
+
+    void sort() {
+        std::sort(commands.begin(), commands.end(),
+                  [](const RenderCommand& a, const RenderCommand& b) { return a.sortKey < b.sortKey; });
+    }
+
+    const char* textAt(const RenderCommand& cmd) const { return textPool.c_str() + cmd.w; }
+    const std::vector<RenderCommand>& all() const { return commands; }
+    size_t size() const { return commands.size(); }
+
+    // Binary dump of one frame's commands for offline replay. Texture pointers are not
+    // meaningful outside the process, so sprites replay as outlines.
+    std::string serialize() const {
+        Uint32 header[3] = { 0x32424352u /* "RCB2", the 4-bit layer sort key */, (Uint32)commands.size(), (Uint32)textPool.size() };
+        std::string out((const char*)header, sizeof(header));
+        out.reserve(sizeof(header) + commands.size() * sizeof(RenderCommand) + textPool.size());
+        for (RenderCommand cmd : commands) {
+            cmd.texture = nullptr;
+            out.append((const char*)&cmd, sizeof(cmd));
+        }
+        out += textPool;
+        return out;
+    }
+
+    bool save(const char* path) const {
+        FILE* f = fopen(path, "wb");
+        if (!f) return false;
+        std::string data = serialize();
+        bool ok = fwrite(data.data(), 1, data.size(), f) == data.size();
+        fclose(f);
+        return ok;
+    }
+
+    // Dumps come from outside the process, so the counts must add up to the file's size before
+    // anything is allocated, and every command must name a known type and layer and, for text,
+    // a NUL-terminated span inside the pool. Texture pointers are cleared whatever the file says.
+    bool load(const char* path) {
+        FILE* f = fopen(path, "rb");
+        if (!f) return false;
+        Uint32 header[3];
+        long size = fseek(f, 0, SEEK_END) == 0 ? ftell(f) : -1;
+        bool ok = size >= (long)sizeof(header) && fseek(f, 0, SEEK_SET) == 0 && fread(header, sizeof(header), 1, f) == 1 &&
+                  header[0] == 0x32424352u &&
+                  (Uint64)size == sizeof(header) + (Uint64)header[1] * sizeof(RenderCommand) + header[2];
+        if (ok) {
+            commands.resize(header[1]);
+            textPool.resize(header[2]);
+            ok = (commands.empty() || fread(commands.data(), sizeof(RenderCommand), commands.size(), f) == commands.size()) &&
+                 (textPool.empty() || fread(&textPool[0], 1, textPool.size(), f) == textPool.size());
+            sequence = (Uint32)commands.size();
+        }
+        fclose(f);
+        for (size_t i = 0; ok && i < commands.size(); ++i) {
+            RenderCommand& cmd = commands[i];
+            cmd.texture = nullptr;
+            ok = cmd.type <= CmdSprite && (cmd.sortKey >> 60) <= LayerOverlay;
+            if (ok && cmd.type == CmdText) {
+                ok = cmd.w >= 0 && cmd.h >= 0 && (size_t)cmd.w + (size_t)cmd.h < textPool.size() && textPool[(size_t)cmd.w + cmd.h] == '\0';
+            }
+        }
+        if (!ok) clear();
+        return ok;
+    }
+
+private:
+    std::vector<RenderCommand> commands;
+    std::string textPool;
+    RenderLayer layer;
+    bool unordered;
+    Uint32 sequence;
+
+    RenderCommand& push(RenderCommandType type, SDL_Color c, int x, int y, int w, int h) {
+        Uint64 state = 0;
+        if (unordered) {
+            // Group by primitive type and full RGBA so runs merge into one SDL call
+            Uint32 rgba = ((Uint32)c.r << 24) | ((Uint32)c.g << 16) | ((Uint32)c.b << 8) | c.a;
+            state = ((Uint64)type << 32) | rgba;
+        }
+        RenderCommand cmd;
+        cmd.sortKey = ((Uint64)layer << 60) | (state << 24) | (sequence++ & 0xFFFFFF);
+        cmd.type = type;
+        cmd.flags = 0;
+        cmd.color = c;
+        cmd.x = x; cmd.y = y; cmd.w = w; cmd.h = h;
+        cmd.texture = nullptr;
+        commands.push_back(cmd);
+        return commands.back();
+    }
+};
+
+// Executes a command buffer against an SDL renderer. Consecutive commands of the same
+// kind and colour are merged into a single SDL_RenderFillRects/DrawPoints/DrawRects call,
+// and circles and glows are expanded into batched point lists and spans.
+class SdlRenderBackend {
+public:
+    SdlRenderBackend() : renderer(nullptr), font(nullptr), bitmapFace(nullptr), sdlCalls(0) {
+        rects.reserve(1024);
+        points.reserve(4096);
+    }
+
+    void init(SDL_Renderer* r, TTF_Font* f) {
+        renderer = r;
+        font = f;
+    }
+
+    // Draw text from a baked atlas instead of the TTF font; the atlas must already be uploaded
+    void useBitmapFont(BitmapFont* f, int pixelSize) {
+        bitmapFont = f;
+        bitmapFace = f ? f->face(pixelSize) : nullptr;
+    }
+
+    void submit(RenderCommandBuffer& buffer) {
+        PROFILE_ZONE("submit");
+        buffer.sort();
+        sdlCalls = 0;
+        hasColor = false;
+        const std::vector<RenderCommand>& cmds = buffer.all();
+
+        size_t i = 0;
+        while (i < cmds.size()) {
+            const RenderCommand& cmd = cmds[i];
+            // Find the run of commands this one can be merged with
+            size_t end = i + 1;
+            if (cmd.type == CmdFillRect || cmd.type == CmdRect || cmd.type == CmdPoint ||
+                cmd.type == CmdCircle || cmd.type == CmdFillCircle) {
+                while (end < cmds.size() && cmds[end].type == cmd.type && sameColor(cmds[end].color, cmd.color)) end++;
+            }
+
+            switch (cmd.type) {
+                case CmdClear:
+                    setColor(cmd.color);
+                    SDL_RenderClear(renderer);
+                    sdlCalls++;
+                    break;
+                case CmdFillRect:
+                case CmdRect:
+                    rects.clear();
+                    for (size_t j = i; j < end; ++j) rects.push_back({ cmds[j].x, cmds[j].y, cmds[j].w, cmds[j].h });
+                    setColor(cmd.color);
+                    if (cmd.type == CmdFillRect) SDL_RenderFillRects(renderer, rects.data(), (int)rects.size());
+                    else SDL_RenderDrawRects(renderer, rects.data(), (int)rects.size());
+                    sdlCalls++;
+                    break;
+                case CmdPoint:
+                    points.clear();
+                    for (size_t j = i; j < end; ++j) points.push_back({ cmds[j].x, cmds[j].y });
+                    flushPoints(cmd.color);
+                    break;
+                case CmdLine:
+                    setColor(cmd.color);
+                    SDL_RenderDrawLine(renderer, cmd.x, cmd.y, cmd.w, cmd.h);
+                    sdlCalls++;
+                    break;
+                case CmdCircle:
+                    points.clear();
+                    for (size_t j = i; j < end; ++j) appendCircle(cmds[j].x, cmds[j].y, cmds[j].w);
+                    flushPoints(cmd.color);
+                    break;
+                case CmdFillCircle:
+                    rects.clear();
+                    for (size_t j = i; j < end; ++j) appendCircleSpans(cmds[j].x, cmds[j].y, cmds[j].w);
+                    setColor(cmd.color);
+                    SDL_RenderFillRects(renderer, rects.data(), (int)rects.size());
+                    sdlCalls++;
+                    break;
+                case CmdGlow:
+                    drawGlow(cmd);
+                    break;
+                case CmdText:
+                    drawText(buffer.textAt(cmd), cmd.x, cmd.y, cmd.color, cmd.flags);
+                    break;
+                case CmdSprite: {
+                    SDL_Rect dst = { cmd.x, cmd.y, cmd.w, cmd.h };
+                    if (cmd.texture) {
+                        SDL_RenderCopy(renderer, cmd.texture, nullptr, &dst);
+                    } else {
+                        setColor({ 255, 0, 255, 255 });
+                        SDL_RenderDrawRect(renderer, &dst);
+                    }
+                    sdlCalls++;
+                    break;
+                }
+            }
+            i = end;
+        }
+    }
+
+    // SDL calls issued by the last submit()
+    int lastCallCount() const { return sdlCalls; }
+
+private:
+    SDL_Renderer* renderer;
+    TTF_Font* font;
+    BitmapFont* bitmapFont = nullptr;
+    const BitmapFont::Face* bitmapFace;
+    std::vector<SDL_Rect> rects;
+    std::vector<SDL_Point> points;
+    SDL_Color currentColor;
+    bool hasColor;
+    int sdlCalls;
+
+    static bool sameColor(SDL_Color a, SDL_Color b) {
+        return a.r == b.r && a.g == b.g && a.b == b.b && a.a == b.a;
+    }
+
+    void setColor(SDL_Color c) {
+        if (hasColor && sameColor(c, currentColor)) return;
+        SDL_SetRenderDrawColor(renderer, c.r, c.g, c.b, c.a);
+        currentColor = c;
+        hasColor = true;
+        sdlCalls++;
+    }
+
+    void flushPoints(SDL_Color c) {
+        if (points.empty()) return;
+        setColor(c);
+        SDL_RenderDrawPoints(renderer, points.data(), (int)points.size());
+        sdlCalls++;
+    }
+
+    // Midpoint circle algorithm for outline
+    void appendCircle(int cx, int cy, int radius) {
+        int x = radius - 1;
+        int y = 0;
+        int dx = 1;
+        int dy = 1;
+        int err = dx - (radius << 1);
+
+        while (x >= y) {
+            points.push_back({ cx + x, cy + y });
+            points.push_back({ cx + y, cy + x });
+            points.push_back({ cx - y, cy + x });
+            points.push_back({ cx - x, cy + y });
+            points.push_back({ cx - x, cy - y });
+            points.push_back({ cx - y, cy - x });
+            points.push_back({ cx + y, cy - x });
+            points.push_back({ cx + x, cy - y });
+
+            if (err <= 0) {
+                y++;
+                err += dy;
+                dy += 2;
+            }
+            if (err > 0) {
+                x--;
+                dx += 2;
+                err += dx - (radius << 1);
+            }
+        }
+    }
+
+    // Same pixels as testing x*x + y*y <= r*r per point, as one span per row
+    void appendCircleSpans(int cx, int cy, int radius) {
+        for (int y = -radius; y <= radius; y++) {
+            int half = (int)std::sqrt((double)(radius * radius - y * y));
+            rects.push_back({ cx - half, cy + y, half * 2 + 1, 1 });
+        }
+    }
+
+    void drawGlow(const RenderCommand& cmd) {
+        PROFILE_ZONE("glow");
+        int radius = cmd.w;
+        int alpha = cmd.color.a;
+        for (int r = radius; r > 0; r -= cmd.h) {
+            float intensity = (float)r / radius;
+            Uint8 a = (Uint8)((float)alpha * intensity * intensity); // Quadratic falloff
+
+            // Color mixing for more realistic glow effect
+            SDL_Color mixed = { (Uint8)(cmd.color.r * (0.8 + 0.2 * intensity)),
+                                (Uint8)(cmd.color.g * (0.8 + 0.2 * intensity)),
+                                (Uint8)(cmd.color.b * (0.8 + 0.2 * intensity)), a };
+            points.clear();
+            appendCircle(cmd.x, cmd.y, r);
+            flushPoints(mixed);
+
+            // Inner bright core
+            if (r < radius / 3) {
+                setColor({ 255, 255, 255, (Uint8)(a / 2) });
+                SDL_RenderDrawPoints(renderer, points.data(), (int)points.size());
+                sdlCalls++;
+            }
+        }
+    }
+
+    void drawText(const char* text, int x, int y, SDL_Color color, Uint8 flags) {
+        if (bitmapFace) {
+            drawBitmapText(text, x, y, color, flags);
+            return;
+        }
+#ifndef SNAKE_NO_TTF
+        if (!font) return;
+        PROFILE_ZONE("text");
+        SDL_Surface* surface = TTF_RenderText_Blended(font, text, color);
+        if (!surface) return;
+        SDL_Texture* texture = SDL_CreateTextureFromSurface(renderer, surface);
+        SDL_Rect destRect = { x, y, surface->w, surface->h };
+        if (flags & TextCentered) {
+            destRect.x -= surface->w / 2;
+            destRect.y -= surface->h / 2;
+        }
+
+        // Drop shadow
+        if (flags & TextShadow) {
+            SDL_Surface* shadowSurface = TTF_RenderText_Blended(font, text, { 0, 0, 0, 160 });
+            if (shadowSurface) {
+                SDL_Texture* shadowTexture = SDL_CreateTextureFromSurface(renderer, shadowSurface);
+                SDL_Rect shadowRect = { destRect.x + 2, destRect.y + 2, shadowSurface->w, shadowSurface->h };
+                SDL_RenderCopy(renderer, shadowTexture, NULL, &shadowRect);
+                SDL_DestroyTexture(shadowTexture);
+                SDL_FreeSurface(shadowSurface);
+                sdlCalls += 3;
+            }
+        }
+
+        SDL_RenderCopy(renderer, texture, NULL, &destRect);
+        SDL_DestroyTexture(texture);
+        SDL_FreeSurface(surface);
+        sdlCalls += 3;
+#endif
+    }
+
+    // Shadow and text quads go out together in one geometry call
+    void drawBitmapText(const char* text, int x, int y, SDL_Color color, Uint8 flags) {
+        PROFILE_ZONE("text");
+        if (flags & TextCentered) {
+            int w, h;
+            bitmapFont->measure(*bitmapFace, text, w, h);
+            x -= w / 2;
+            y -= h / 2;
+        }
+        if (flags & TextShadow) bitmapFont->queue(*bitmapFace, text, x + 2, y + 2, { 0, 0, 0, 160 });
+        bitmapFont->queue(*bitmapFace, text, x, y, color);
+        sdlCalls += bitmapFont->draw(renderer);
+    }
+};
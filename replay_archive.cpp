@@ -0,0 +1,363 @@
+// Replay archive tool (replay_archive.h): fills an archive, indexes it, lists replays by score,
+// seed, day or variant, and plays any subset back in parallel for balance analysis.
+//
+//   g++ -O2 -std=c++17 -pthread replay_archive.cpp -o replay_archive
+//   ./replay_archive add ARCHIVE [--day N] [--variant N] FILE...     replays in the wire format, back to back
+//   ./replay_archive generate ARCHIVE ROUNDS [--seed N] [--threads N] [--day N]
+//   ./replay_archive index ARCHIVE
+//   ./replay_archive info ARCHIVE
+//   ./replay_archive list ARCHIVE [FILTERS] [--by score|seed|day|variant] [--limit N]
+//   ./replay_archive resim ARCHIVE [FILTERS] [--threads N] [--obstacle-every N] [--autopilot]
+//
+// FILTERS: --score MIN:MAX --seed S --day MIN:MAX --variant V (a single number means MIN = MAX).
+// resim replays every selected log under the game's rules, or with obstacles every N points
+// instead of every 5 (0 = never), and reports how the snakes died: overall, by the number of
+// obstacles added before the death, and how long after the latest obstacle a collision came.
+// A log replayed under changed rules keeps its recorded moves, which stop making sense as soon as
+// the board differs (and it can outlive them; those rounds are counted separately). --autopilot
+// instead plays each selected seed afresh with the autopilot under the rules, which is slower but
+// shows how a player steering around the new board would fare.
+// ARCHIVE names the pair ARCHIVE.seg / ARCHIVE.idx; add and generate reindex when they're done.
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <string>
+#include <vector>
+#include <thread>
+#include <atomic>
+#include <chrono>
+#include <algorithm>
+#include "replay_archive.h"
+
+static double nowMs() {
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+static void usage(const char* program) {
+    fprintf(stderr,
+            "usage: %s add ARCHIVE [--day N] [--variant N] FILE...\n"
+            "       %s generate ARCHIVE ROUNDS [--seed N] [--threads N] [--day N]\n"
+            "       %s index ARCHIVE\n"
+            "       %s info ARCHIVE\n"
+            "       %s list ARCHIVE [--score MIN:MAX] [--seed S] [--day MIN:MAX] [--variant V] [--by score|seed|day|variant] [--limit N]\n"
+            "       %s resim ARCHIVE [--score MIN:MAX] [--seed S] [--day MIN:MAX] [--variant V] [--threads N] [--obstacle-every N] [--autopilot]\n",
+            program, program, program, program, program, program);
+}
+
+struct Filter {
+    bool used[4] = {};
+    Sint64 lo[4] = {}, hi[4] = {};
+
+    // "MIN:MAX" or "N"
+    bool set(ReplayArchive::Order o, const char* text) {
+        char* end;
+        lo[o] = strtoll(text, &end, 10);
+        hi[o] = lo[o];
+        if (*end == ':') hi[o] = strtoll(end + 1, &end, 10);
+        used[o] = true;
+        return *end == '\0' && lo[o] <= hi[o];
+    }
+
+    bool accepts(const ArchiveEntry& e) const {
+        for (int o = 0; o < 4; ++o) {
+            Sint64 k = ReplayArchive::key((ReplayArchive::Order)o, e);
+            if (used[o] && (k < lo[o] || k > hi[o])) return false;
+        }
+        return true;
+    }
+
+    // Entry numbers passing the filter, in the order asked for. The narrowest filtered key is
+    // looked up in its sorted index; the others are checked entry by entry.
+    std::vector<Uint32> select(const ReplayArchive& archive, ReplayArchive::Order by) const {
+        size_t first = 0, last = archive.size();
+        int narrowest = -1;
+        for (int o = 0; o < 4; ++o) {
+            if (!used[o]) continue;
+            size_t f, l;
+            archive.range((ReplayArchive::Order)o, lo[o], hi[o], f, l);
+            if (narrowest < 0 || l - f < last - first) {
+                narrowest = o;
+                first = f;
+                last = l;
+            }
+        }
+        std::vector<Uint32> chosen;
+        const Uint32* ord = archive.order(narrowest < 0 ? by : (ReplayArchive::Order)narrowest);
+        for (size_t i = first; i < last; ++i) {
+            if (accepts(archive.entry(ord[i]))) chosen.push_back(ord[i]);
+        }
+        if (narrowest >= 0 && narrowest != by) {
+            std::stable_sort(chosen.begin(), chosen.end(), [&](Uint32 a, Uint32 b) {
+                return ReplayArchive::key(by, archive.entry(a)) < ReplayArchive::key(by, archive.entry(b));
+            });
+        }
+        return chosen;
+    }
+};
+
+static bool openArchive(const std::string& name, ReplayArchive& archive) {
+    if (!archive.open(name)) {
+        fprintf(stderr, "replay_archive: can't open %s (run replay_archive index %s if only the .idx is missing)\n", name.c_str(), name.c_str());
+        return false;
+    }
+    if (archive.unindexedBytes()) {
+        fprintf(stderr, "replay_archive: %zu bytes appended since the last index are not included\n", archive.unindexedBytes());
+    }
+    return true;
+}
+
+static int reindex(const std::string& name) {
+    size_t indexed = 0, skipped = 0;
+    double start = nowMs();
+    if (!buildReplayIndex(name, &indexed, &skipped)) return EXIT_FAILURE;
+    printf("indexed %zu replays in %.0f ms%s\n", indexed, nowMs() - start, skipped ? " (some records skipped)" : "");
+    return EXIT_SUCCESS;
+}
+
+static int addFiles(const std::string& name, Uint32 day, Uint16 variant, const std::vector<std::string>& files) {
+    ReplayArchiveWriter writer;
+    if (!writer.open(name)) return EXIT_FAILURE;
+    size_t added = 0;
+    SnakeReplay replay;
+    for (const std::string& path : files) {
+        MappedFile file;
+        if (!file.open(path)) {
+            fprintf(stderr, "replay_archive: can't read %s\n", path.c_str());
+            continue;
+        }
+        size_t pos = 0;
+        while (pos < file.size() && replay.decode(file.data(), file.size(), pos)) {
+            writer.append(replay, day, variant);
+            added++;
+        }
+        if (pos < file.size()) fprintf(stderr, "replay_archive: %s has %zu bytes that aren't a replay\n", path.c_str(), file.size() - pos);
+    }
+    writer.close();
+    printf("added %zu replays\n", added);
+    return reindex(name);
+}
+
+static int generate(const std::string& name, size_t rounds, Uint32 seed, int threads, Uint32 day) {
+    std::vector<SnakeReplay> played(rounds);
+    std::atomic<size_t> next(0);
+    std::vector<std::thread> pool;
+    double start = nowMs();
+    for (int t = 0; t < threads; ++t) {
+        pool.emplace_back([&] {
+            for (size_t i; (i = next++) < rounds;) {
+                SnakeRandom seeds(seed + (Uint32)i * 2654435761u);
+                playAutopilotRound(seeds.next(), played[i]);
+                played[i].name = "autopilot";
+            }
+        });
+    }
+    for (std::thread& t : pool) t.join();
+    printf("played %zu rounds in %.0f ms\n", rounds, nowMs() - start);
+
+    ReplayArchiveWriter writer;
+    if (!writer.open(name)) return EXIT_FAILURE;
+    for (const SnakeReplay& r : played) writer.append(r, day, VariantSnakeV11);
+    writer.close();
+    return reindex(name);
+}
+
+static int info(const std::string& name) {
+    ReplayArchive archive;
+    if (!openArchive(name, archive)) return EXIT_FAILURE;
+    printf("%zu replays, segment %.1f MB (%.1f bytes/replay)\n", archive.size(), archive.segmentBytes() / (1024.0 * 1024.0),
+           archive.size() ? archive.segmentBytes() / (double)archive.size() : 0.0);
+    if (!archive.size()) return EXIT_SUCCESS;
+    const char* names[] = { "score", "seed", "day", "variant" };
+    for (int o = 0; o < 4; ++o) {
+        const Uint32* ord = archive.order((ReplayArchive::Order)o);
+        printf("%-8s %lld .. %lld\n", names[o], (long long)ReplayArchive::key((ReplayArchive::Order)o, archive.entry(ord[0])),
+               (long long)ReplayArchive::key((ReplayArchive::Order)o, archive.entry(ord[archive.size() - 1])));
+    }
+    return EXIT_SUCCESS;
+}
+
+static int list(const std::string& name, const Filter& filter, ReplayArchive::Order by, size_t limit) {
+    ReplayArchive archive;
+    if (!openArchive(name, archive)) return EXIT_FAILURE;
+    std::vector<Uint32> chosen = filter.select(archive, by);
+    printf("%10s %10s %8s %8s %6s %7s %7s  %s\n", "entry", "seed", "score", "ticks", "day", "variant", "turns", "name");
+    SnakeReplay replay;
+    for (size_t i = 0; i < chosen.size() && i < limit; ++i) {
+        const ArchiveEntry& e = archive.entry(chosen[i]);
+        archive.decode(chosen[i], replay);
+        printf("%10u %10u %8d %8u %6u %7u %7zu  %s\n", chosen[i], e.seed, e.score, e.ticks, e.day, e.variant, replay.turns.size(),
+               replay.name.c_str());
+    }
+    printf("%zu of %zu replays match\n", chosen.size(), archive.size());
+    return EXIT_SUCCESS;
+}
+
+// Per-thread tallies, added up at the end
+struct ResimStats {
+    static const int obstaclesPerBucket = 5;
+    static const int obstacleBuckets = 16;  // The last bucket collects everything beyond
+
+    size_t rounds = 0;
+    size_t undecodable = 0;
+    size_t asRecorded = 0;    // Died on the recorded tick at the recorded score
+    size_t outlived = 0;      // Still alive when the log ran out
+    size_t deaths[4] = {};
+    size_t byObstacles[obstacleBuckets][4] = {};
+    double ticksSinceObstacle = 0;  // Summed over obstacle deaths after at least one added obstacle
+    size_t lateObstacleDeaths = 0;
+    Uint64 ticks = 0;
+
+    void add(const ResimStats& o) {
+        rounds += o.rounds;
+        undecodable += o.undecodable;
+        asRecorded += o.asRecorded;
+        outlived += o.outlived;
+        for (int d = 0; d < 4; ++d) deaths[d] += o.deaths[d];
+        for (int b = 0; b < obstacleBuckets; ++b) {
+            for (int d = 0; d < 4; ++d) byObstacles[b][d] += o.byObstacles[b][d];
+        }
+        ticksSinceObstacle += o.ticksSinceObstacle;
+        lateObstacleDeaths += o.lateObstacleDeaths;
+        ticks += o.ticks;
+    }
+};
+
+static int resim(const std::string& name, const Filter& filter, int threads, int obstacleEvery, bool autopilot) {
+    ReplayArchive archive;
+    if (!openArchive(name, archive)) return EXIT_FAILURE;
+    // Segment order, so the threads walk the mapping front to back
+    std::vector<Uint32> chosen = filter.select(archive, ReplayArchive::ByScore);
+    std::sort(chosen.begin(), chosen.end());
+
+    const size_t chunk = 256;
+    std::atomic<size_t> next(0);
+    std::vector<ResimStats> perThread((size_t)threads);
+    std::vector<std::thread> pool;
+    double start = nowMs();
+    for (int t = 0; t < threads; ++t) {
+        pool.emplace_back([&, t] {
+            ResimStats& stats = perThread[(size_t)t];
+            SnakeSim sim(obstacleEvery);
+            SnakeReplay replay;
+            for (size_t first; (first = next.fetch_add(chunk)) < chosen.size();) {
+                size_t last = std::min(first + chunk, chosen.size());
+                for (size_t i = first; i < last; ++i) {
+                    stats.rounds++;
+                    if (!archive.decode(chosen[i], replay)) {
+                        stats.undecodable++;
+                        continue;
+                    }
+                    if (autopilot) playAutopilotRound(sim, replay.seed, replay);
+                    else sim.play(replay);
+                    stats.ticks += sim.ticksPlayed();
+                    if (sim.isAlive()) {
+                        stats.outlived++;
+                        continue;
+                    }
+                    if (sim.ticksPlayed() == replay.ticks && sim.currentScore() == replay.score) stats.asRecorded++;
+                    int d = sim.death();
+                    stats.deaths[d]++;
+                    stats.byObstacles[std::min(sim.obstaclesAdded() / ResimStats::obstaclesPerBucket, ResimStats::obstacleBuckets - 1)][d]++;
+                    if (d == SnakeSim::HitObstacle && sim.obstaclesAdded() > 0) {
+                        stats.ticksSinceObstacle += sim.ticksPlayed() - sim.lastObstacleAt();
+                        stats.lateObstacleDeaths++;
+                    }
+                }
+            }
+        });
+    }
+    for (std::thread& t : pool) t.join();
+    double elapsed = nowMs() - start;
+    ResimStats total;
+    for (const ResimStats& s : perThread) total.add(s);
+
+    printf("replayed %zu rounds (%.1f M ticks) on %d threads in %.0f ms, %.0f rounds/s\n", total.rounds, total.ticks / 1e6, threads,
+           elapsed, total.rounds * 1000.0 / std::max(elapsed, 1e-3));
+    printf("rules: an obstacle every %d points%s; %s\n", obstacleEvery, obstacleEvery == SnakeRules::obstacleEvery ? " (as shipped)" : "",
+           autopilot ? "seeds played by the autopilot" : "recorded moves");
+    printf("ended as recorded %zu, outlived their log %zu, undecodable %zu\n", total.asRecorded, total.outlived, total.undecodable);
+    size_t died = total.rounds - total.outlived - total.undecodable;
+    if (!died) return EXIT_SUCCESS;
+    printf("\ndeath cause      rounds  share\n");
+    for (int d = SnakeSim::HitSelf; d <= SnakeSim::NoRoom; ++d) {
+        printf("%-14s %8zu %5.1f%%\n", SnakeSim::deathName((SnakeSim::Death)d), total.deaths[d], total.deaths[d] * 100.0 / died);
+    }
+    printf("\nobstacles added   rounds    self  obstacle  no room\n");
+    for (int b = 0; b < ResimStats::obstacleBuckets; ++b) {
+        const size_t* row = total.byObstacles[b];
+        size_t n = row[SnakeSim::HitSelf] + row[SnakeSim::HitObstacle] + row[SnakeSim::NoRoom];
+        if (!n) continue;
+        int low = b * ResimStats::obstaclesPerBucket;
+        std::string label = b == ResimStats::obstacleBuckets - 1 ? std::to_string(low) + "+"
+                                                                 : std::to_string(low) + "-" + std::to_string(low + ResimStats::obstaclesPerBucket - 1);
+        printf("%-15s %8zu  %5.1f%%  %7.1f%%  %6.1f%%\n", label.c_str(), n,
+               row[SnakeSim::HitSelf] * 100.0 / n, row[SnakeSim::HitObstacle] * 100.0 / n, row[SnakeSim::NoRoom] * 100.0 / n);
+    }
+    if (total.lateObstacleDeaths) {
+        printf("\nobstacle deaths after an added obstacle: %zu, on average %.0f ticks after the latest one appeared\n",
+               total.lateObstacleDeaths, total.ticksSinceObstacle / total.lateObstacleDeaths);
+    }
+    return EXIT_SUCCESS;
+}
+
+int main(int argc, char* argv[]) {
+    if (argc < 3) {
+        usage(argv[0]);
+        return EXIT_FAILURE;
+    }
+    std::string command = argv[1], name = argv[2];
+    Filter filter;
+    ReplayArchive::Order by = ReplayArchive::ByScore;
+    size_t limit = 20;
+    int threads = (int)std::max(1u, std::thread::hardware_concurrency());
+    int obstacleEvery = SnakeRules::obstacleEvery;
+    bool autopilot = false;
+    Uint32 day = (Uint32)(time(nullptr) / 86400);
+    Uint16 variant = VariantSnakeV11;
+    Uint32 seed = 1;
+    std::vector<std::string> positional;
+    bool ok = true;
+    for (int i = 3; i < argc && ok; ++i) {
+        std::string arg = argv[i];
+        bool hasValue = i + 1 < argc;
+        if (arg == "--score" && hasValue) ok = filter.set(ReplayArchive::ByScore, argv[++i]);
+        else if (arg == "--seed" && hasValue && command == "generate") seed = (Uint32)strtoul(argv[++i], nullptr, 10);
+        else if (arg == "--seed" && hasValue) ok = filter.set(ReplayArchive::BySeed, argv[++i]);
+        else if (arg == "--day" && hasValue && (command == "add" || command == "generate")) day = (Uint32)strtoul(argv[++i], nullptr, 10);
+        else if (arg == "--day" && hasValue) ok = filter.set(ReplayArchive::ByDay, argv[++i]);
+        else if (arg == "--variant" && hasValue && command == "add") variant = (Uint16)atoi(argv[++i]);
+        else if (arg == "--variant" && hasValue) ok = filter.set(ReplayArchive::ByVariant, argv[++i]);
+        else if (arg == "--threads" && hasValue) threads = std::max(1, atoi(argv[++i]));
+        else if (arg == "--obstacle-every" && hasValue) obstacleEvery = std::max(0, atoi(argv[++i]));
+        else if (arg == "--autopilot") autopilot = true;
+        else if (arg == "--limit" && hasValue) limit = (size_t)std::max(0, atoi(argv[++i]));
+        else if (arg == "--by" && hasValue) {
+            std::string key = argv[++i];
+            if (key == "score") by = ReplayArchive::ByScore;
+            else if (key == "seed") by = ReplayArchive::BySeed;
+            else if (key == "day") by = ReplayArchive::ByDay;
+            else if (key == "variant") by = ReplayArchive::ByVariant;
+            else ok = false;
+        } else if (arg.compare(0, 2, "--") != 0) positional.push_back(arg);
+        else ok = false;
+    }
+    if (!ok) {
+        usage(argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    if (command == "add" && !positional.empty()) return addFiles(name, day, variant, positional);
+    if (command == "generate" && positional.size() == 1) return generate(name, (size_t)atol(positional[0].c_str()), seed, threads, day);
+    if (!positional.empty()) {
+        usage(argv[0]);
+        return EXIT_FAILURE;
+    }
+    if (command == "index") return reindex(name);
+    if (command == "info") return info(name);
+    if (command == "list") return list(name, filter, by, limit);
+    if (command == "resim") return resim(name, filter, threads, obstacleEvery, autopilot);
+    usage(argv[0]);
+    return EXIT_FAILURE;
+}
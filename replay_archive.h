@@ -0,0 +1,433 @@
+#pragma once
+#include <SDL2/SDL.h>
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include "snake_replay.h"
+#include "png_codec.h"
+#ifdef _WIN32
+#include <fstream>
+#else
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+// Append-only archive of replays for bulk analysis, as two files next to each other:
+//
+//   NAME.seg  "SNKA" version:u32, then records  length:u32 payload crc32:u32
+//   NAME.idx  "SNKI" version:u32 count:u32 indexedBytes:u64 reserved:u32 (pads the entries to 8 bytes)
+//             count x ArchiveEntry (32 bytes, in segment order)
+//             4 x count x u32: entry numbers sorted by score, seed, day and variant
+//
+// A payload is the replay packed with LEB128 varints: seed, ticks, zigzag score, day, variant,
+// name length and bytes, turn count, then one varint per turn holding its tick delta and direction
+// (tick delta << 2 | direction). Most turns fit in one or two bytes instead of the five the wire
+// format spends; deflate would save a little more but would need an inflate buffer per record,
+// whereas these decode straight out of the mapping.
+//
+// Writers only ever append to the segment, after cutting off any record a crash left torn. The
+// index covers the segment up to indexedBytes and is rebuilt by buildReplayIndex() (replay_archive
+// index); records appended since are invisible to readers until then. Readers mmap both files:
+// entries, the sort orders and every payload are used in place.
+
+struct ArchiveEntry {
+    Uint64 offset;  // Of the payload in the segment
+    Uint32 length;
+    Uint32 seed;
+    Sint32 score;
+    Uint32 ticks;
+    Uint32 day;
+    Uint16 variant;
+    Uint16 turns;  // Saturates at 65535
+};
+static_assert(sizeof(ArchiveEntry) == 32, "index layout");
+
+enum ReplayVariant { VariantUnknown = 0, VariantSnakeV11 = 1 };
+
+namespace replay_archive_detail {
+
+inline void putVarint(std::string& out, Uint64 v) {
+    while (v >= 0x80) {
+        out.push_back((char)(v | 0x80));
+        v >>= 7;
+    }
+    out.push_back((char)v);
+}
+
+// False if it would run past end
+inline bool getVarint(const Uint8*& p, const Uint8* end, Uint64& v) {
+    v = 0;
+    for (int shift = 0; p < end && shift < 64; shift += 7) {
+        Uint8 b = *p++;
+        v |= (Uint64)(b & 0x7F) << shift;
+        if (!(b & 0x80)) return true;
+    }
+    return false;
+}
+
+inline void put32(std::string& out, Uint32 v) {
+    char b[4] = { (char)v, (char)(v >> 8), (char)(v >> 16), (char)(v >> 24) };
+    out.append(b, 4);
+}
+
+inline Uint32 get32(const Uint8* p) { return p[0] | (p[1] << 8) | (p[2] << 16) | ((Uint32)p[3] << 24); }
+
+const Uint32 segmentVersion = 1;
+const Uint32 indexVersion = 2;  // 1 had a 20-byte header, which left the entries misaligned
+const size_t segmentHeaderBytes = 8;
+const size_t indexHeaderBytes = 24;
+// Readers use the entries and orders in place in a page-aligned mapping
+static_assert(indexHeaderBytes % alignof(ArchiveEntry) == 0 && sizeof(ArchiveEntry) % alignof(Uint32) == 0, "index alignment");
+
+}  // namespace replay_archive_detail
+
+// Packs a replay into an archive payload
+inline void encodeArchivedReplay(const SnakeReplay& r, Uint32 day, Uint16 variant, std::string& out) {
+    using namespace replay_archive_detail;
+    putVarint(out, r.seed);
+    putVarint(out, r.ticks);
+    putVarint(out, ((Uint32)r.score << 1) ^ (Uint32)(r.score >> 31));
+    putVarint(out, day);
+    putVarint(out, variant);
+    size_t nameLength = std::min(r.name.size(), (size_t)SnakeReplay::nameBytes - 1);
+    putVarint(out, nameLength);
+    out.append(r.name.data(), nameLength);
+    putVarint(out, r.turns.size());
+    Uint32 tick = 0;
+    for (const ReplayTurn& t : r.turns) {
+        putVarint(out, ((Uint64)(t.tick - tick) << 2) | (t.direction & 3));
+        tick = t.tick;
+    }
+}
+
+// Unpacks a payload; r's buffers are reused, so a reader decoding in a loop doesn't allocate
+inline bool decodeArchivedReplay(const Uint8* p, size_t length, SnakeReplay& r, Uint32* day = nullptr, Uint16* variant = nullptr) {
+    using namespace replay_archive_detail;
+    const Uint8* end = p + length;
+    Uint64 seed, ticks, score, d, v, nameLength, count;
+    if (!getVarint(p, end, seed) || !getVarint(p, end, ticks) || !getVarint(p, end, score) || !getVarint(p, end, d) ||
+        !getVarint(p, end, v) || !getVarint(p, end, nameLength) || nameLength > (Uint64)(end - p)) {
+        return false;
+    }
+    r.seed = (Uint32)seed;
+    r.ticks = (Uint32)ticks;
+    r.score = (int)((Uint32)(score >> 1) ^ (0u - (Uint32)(score & 1)));
+    r.name.assign((const char*)p, (size_t)nameLength);
+    p += nameLength;
+    if (!getVarint(p, end, count) || count > (Uint64)(end - p)) return false;
+    r.turns.resize((size_t)count);
+    Uint32 tick = 0;
+    for (ReplayTurn& t : r.turns) {
+        Uint64 packed;
+        if (!getVarint(p, end, packed)) return false;
+        tick += (Uint32)(packed >> 2);
+        t.tick = tick;
+        t.direction = (Uint8)(packed & 3);
+    }
+    if (day) *day = (Uint32)d;
+    if (variant) *variant = (Uint16)v;
+    return p == end;
+}
+
+// Read-only file mapping (a plain read where there's no mmap)
+class MappedFile {
+public:
+    MappedFile() = default;
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+    ~MappedFile() { close(); }
+
+    bool open(const std::string& path) {
+        close();
+#ifdef _WIN32
+        std::ifstream in(path, std::ios::binary);
+        if (!in) return false;
+        copy.assign(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+        bytes = copy.data();
+        length = copy.size();
+        return true;
+#else
+        int fd = ::open(path.c_str(), O_RDONLY);
+        if (fd < 0) return false;
+        struct stat st;
+        bool ok = fstat(fd, &st) == 0;
+        length = ok ? (size_t)st.st_size : 0;
+        if (ok && length) {
+            void* p = mmap(nullptr, length, PROT_READ, MAP_SHARED, fd, 0);
+            ok = p != MAP_FAILED;
+            bytes = ok ? (const Uint8*)p : nullptr;
+        }
+        ::close(fd);  // The mapping stays valid
+        if (!ok) length = 0;
+        return ok;
+#endif
+    }
+
+    void close() {
+#ifdef _WIN32
+        copy.clear();
+#else
+        if (bytes) munmap((void*)bytes, length);
+#endif
+        bytes = nullptr;
+        length = 0;
+    }
+
+    // Tell the kernel the whole file will be read front to back
+    void adviseSequential() const {
+#ifndef _WIN32
+        if (bytes) madvise((void*)bytes, length, MADV_SEQUENTIAL);
+#endif
+    }
+
+    const Uint8* data() const { return bytes; }
+    size_t size() const { return length; }
+
+private:
+    const Uint8* bytes = nullptr;
+    size_t length = 0;
+#ifdef _WIN32
+    std::vector<Uint8> copy;
+#endif
+};
+
+class ReplayArchiveWriter {
+public:
+    ~ReplayArchiveWriter() { close(); }
+
+    // Opens NAME.seg for appending, creating it if needed. A record cut off by a crash mid-append
+    // would swallow everything appended after it, so the segment is first cut back to the end of
+    // its last complete record that passes its checksum.
+    bool open(const std::string& name) {
+        using namespace replay_archive_detail;
+        close();
+        std::string path = name + ".seg";
+        size_t keep = 0;
+        if (!validLength(path, keep)) return false;
+        std::error_code ec;
+        if (std::filesystem::exists(path, ec) && std::filesystem::file_size(path, ec) != keep) {
+            fprintf(stderr, "archive: cutting %s back to %zu bytes, after its last complete record\n", path.c_str(), keep);
+            std::filesystem::resize_file(path, keep, ec);
+            if (ec) {
+                fprintf(stderr, "archive: can't truncate %s: %s\n", path.c_str(), ec.message().c_str());
+                return false;
+            }
+        }
+        file = fopen(path.c_str(), "ab");
+        if (!file) {
+            fprintf(stderr, "archive: can't open %s\n", path.c_str());
+            return false;
+        }
+        fseek(file, 0, SEEK_END);
+        if (ftell(file) == 0) {
+            std::string header("SNKA", 4);
+            put32(header, segmentVersion);
+            fwrite(header.data(), 1, header.size(), file);
+        }
+        return true;
+    }
+
+    bool append(const SnakeReplay& replay, Uint32 day, Uint16 variant) {
+        if (!file) return false;
+        payload.clear();
+        encodeArchivedReplay(replay, day, variant, payload);
+        record.clear();
+        replay_archive_detail::put32(record, (Uint32)payload.size());
+        record += payload;
+        replay_archive_detail::put32(record, PngEncoder::crc32(0, (const Uint8*)payload.data(), payload.size()));
+        return fwrite(record.data(), 1, record.size(), file) == record.size();
+    }
+
+    bool flush() { return file && fflush(file) == 0; }
+
+    void close() {
+        if (file) fclose(file);
+        file = nullptr;
+    }
+
+private:
+    FILE* file = nullptr;
+    std::string payload, record;
+
+    // Bytes of path worth keeping: 0 for a missing or half-written header, else up to the end of
+    // the last whole record with a good checksum (bad ones before it stay; the index skips them)
+    static bool validLength(const std::string& path, size_t& keep) {
+        using namespace replay_archive_detail;
+        MappedFile segment;
+        keep = 0;
+        if (!segment.open(path) || segment.size() < segmentHeaderBytes) return true;
+        const Uint8* data = segment.data();
+        if (memcmp(data, "SNKA", 4) != 0 || get32(data + 4) != segmentVersion) {
+            fprintf(stderr, "archive: %s is not a replay segment\n", path.c_str());
+            return false;
+        }
+        keep = segmentHeaderBytes;
+        for (size_t pos = segmentHeaderBytes; pos + 8 <= segment.size();) {
+            Uint32 length = get32(data + pos);
+            if (length > segment.size() - pos - 8) break;
+            pos += 8 + length;
+            if (PngEncoder::crc32(0, data + pos - 4 - length, length) == get32(data + pos - 4)) keep = pos;
+        }
+        return true;
+    }
+};
+
+// Scans NAME.seg and writes NAME.idx (through a temporary file and a rename). A record cut off
+// by a crash mid-append ends the scan; the next ReplayArchiveWriter::open() cuts it off.
+inline bool buildReplayIndex(const std::string& name, size_t* indexed = nullptr, size_t* skipped = nullptr) {
+    using namespace replay_archive_detail;
+    MappedFile segment;
+    if (!segment.open(name + ".seg") || segment.size() < segmentHeaderBytes || memcmp(segment.data(), "SNKA", 4) != 0 ||
+        get32(segment.data() + 4) != segmentVersion) {
+        fprintf(stderr, "archive: %s.seg is missing or not a replay segment\n", name.c_str());
+        return false;
+    }
+    segment.adviseSequential();
+    std::vector<ArchiveEntry> entries;
+    SnakeReplay replay;
+    size_t pos = segmentHeaderBytes, bad = 0;
+    const Uint8* data = segment.data();
+    while (pos + 8 <= segment.size()) {
+        Uint32 length = get32(data + pos);
+        if (length > segment.size() - pos - 8) break;
+        const Uint8* payload = data + pos + 4;
+        ArchiveEntry e = {};
+        if (PngEncoder::crc32(0, payload, length) == get32(payload + length) &&
+            decodeArchivedReplay(payload, length, replay, &e.day, &e.variant)) {
+            e.offset = pos + 4;
+            e.length = length;
+            e.seed = replay.seed;
+            e.score = replay.score;
+            e.ticks = replay.ticks;
+            e.turns = (Uint16)std::min<size_t>(replay.turns.size(), 65535);
+            entries.push_back(e);
+        } else {
+            bad++;
+        }
+        pos += 8 + length;
+    }
+    if (pos != segment.size()) fprintf(stderr, "archive: %zu bytes at the end of %s.seg are an incomplete record\n", segment.size() - pos, name.c_str());
+    if (bad) fprintf(stderr, "archive: %zu records failed their checksum and were left out\n", bad);
+
+    Uint32 count = (Uint32)entries.size();
+    std::vector<Uint32> order(count);
+    std::string out("SNKI", 4);
+    put32(out, indexVersion);
+    put32(out, count);
+    put32(out, (Uint32)pos);
+    put32(out, (Uint32)((Uint64)pos >> 32));
+    put32(out, 0);
+    out.append((const char*)entries.data(), entries.size() * sizeof(ArchiveEntry));
+    auto appendOrder = [&](auto key) {
+        for (Uint32 i = 0; i < count; ++i) order[i] = i;
+        std::stable_sort(order.begin(), order.end(), [&](Uint32 a, Uint32 b) { return key(entries[a]) < key(entries[b]); });
+        out.append((const char*)order.data(), order.size() * sizeof(Uint32));
+    };
+    appendOrder([](const ArchiveEntry& e) { return (Sint64)e.score; });
+    appendOrder([](const ArchiveEntry& e) { return (Sint64)e.seed; });
+    appendOrder([](const ArchiveEntry& e) { return (Sint64)e.day; });
+    appendOrder([](const ArchiveEntry& e) { return (Sint64)e.variant; });
+
+    std::string path = name + ".idx", temp = path + ".tmp";
+    FILE* f = fopen(temp.c_str(), "wb");
+    bool ok = f && fwrite(out.data(), 1, out.size(), f) == out.size();
+    if (f) ok = fclose(f) == 0 && ok;
+    if (!ok || rename(temp.c_str(), path.c_str()) != 0) {
+        fprintf(stderr, "archive: can't write %s\n", path.c_str());
+        remove(temp.c_str());
+        return false;
+    }
+    if (indexed) *indexed = count;
+    if (skipped) *skipped = bad;
+    return true;
+}
+
+class ReplayArchive {
+public:
+    enum Order { ByScore, BySeed, ByDay, ByVariant };
+
+    bool open(const std::string& name) {
+        using namespace replay_archive_detail;
+        if (!segment.open(name + ".seg") || !index.open(name + ".idx")) return false;
+        const Uint8* h = index.data();
+        if (index.size() < indexHeaderBytes || memcmp(h, "SNKI", 4) != 0 || get32(h + 4) != indexVersion) return false;
+        count = get32(h + 8);
+        Uint64 indexedBytes = get32(h + 12) | ((Uint64)get32(h + 16) << 32);
+        if (index.size() != indexHeaderBytes + (size_t)count * (sizeof(ArchiveEntry) + 4 * sizeof(Uint32)) ||
+            indexedBytes > segment.size()) {
+            fprintf(stderr, "archive: %s.idx doesn't match %s.seg; run replay_archive index\n", name.c_str(), name.c_str());
+            return false;
+        }
+        unindexed = segment.size() - (size_t)indexedBytes;
+        entryTable = (const ArchiveEntry*)(h + indexHeaderBytes);
+        orders = (const Uint32*)(entryTable + count);
+        // Checked once here so payload() and order() can trust the index without per-call checks
+        for (size_t i = 0; i < count; ++i) {
+            const ArchiveEntry& e = entryTable[i];
+            if (e.offset < segmentHeaderBytes + 4 || e.offset > indexedBytes || e.length > indexedBytes - e.offset) {
+                return damaged(name, "entry " + std::to_string(i) + " points outside the segment");
+            }
+        }
+        for (size_t i = 0; i < 4 * count; ++i) {
+            if (orders[i] >= count) return damaged(name, "a sort order names entry " + std::to_string(orders[i]));
+        }
+        return true;
+    }
+
+    size_t size() const { return count; }
+    size_t unindexedBytes() const { return unindexed; }
+    size_t segmentBytes() const { return segment.size(); }
+
+    const ArchiveEntry& entry(size_t i) const { return entryTable[i]; }
+
+    // Entry numbers sorted ascending by the key
+    const Uint32* order(Order o) const { return orders + (size_t)o * count; }
+
+    // [first, last) positions in order(o) whose key lies within [lo, hi]
+    void range(Order o, Sint64 lo, Sint64 hi, size_t& first, size_t& last) const {
+        const Uint32* ord = order(o);
+        first = std::partition_point(ord, ord + count, [&](Uint32 i) { return key(o, entryTable[i]) < lo; }) - ord;
+        last = std::partition_point(ord + first, ord + count, [&](Uint32 i) { return key(o, entryTable[i]) <= hi; }) - ord;
+    }
+
+    // The packed record, in place in the mapping
+    const Uint8* payload(size_t i, size_t& length) const {
+        length = entryTable[i].length;
+        return segment.data() + entryTable[i].offset;
+    }
+
+    bool decode(size_t i, SnakeReplay& replay) const {
+        size_t length;
+        const Uint8* p = payload(i, length);
+        return decodeArchivedReplay(p, length, replay);
+    }
+
+    static Sint64 key(Order o, const ArchiveEntry& e) {
+        switch (o) {
+            case ByScore: return e.score;
+            case BySeed: return e.seed;
+            case ByDay: return e.day;
+            default: return e.variant;
+        }
+    }
+
+private:
+    bool damaged(const std::string& name, const std::string& why) {
+        fprintf(stderr, "archive: %s.idx is damaged (%s); run replay_archive index\n", name.c_str(), why.c_str());
+        count = 0;
+        entryTable = nullptr;
+        orders = nullptr;
+        return false;
+    }
+
+    MappedFile segment, index;
+    size_t count = 0;
+    size_t unindexed = 0;
+    const ArchiveEntry* entryTable = nullptr;
+    const Uint32* orders = nullptr;
+};
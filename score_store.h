@@ -0,0 +1,196 @@
+#pragma once
+#include <SDL2/SDL.h>
+#include <vector>
+#include <string>
+#include <cstdio>
+#include <cstring>
+#include "png_codec.h"
+#include "io_service.h"
+#ifdef __EMSCRIPTEN__
+#include <emscripten/emscripten.h>
+#elif !defined(_WIN32)
+#include <unistd.h>
+#endif
+
+// Persistent high-score table. The file is small, fixed-size records behind a versioned header
+// and a CRC, read with a single fread and checked before anything is used, so a truncated or
+// corrupt file reads as "no scores" instead of garbage. Saves go to a temporary file that is
+// flushed to disk and then renamed over the old one, so a crash mid-write leaves the previous
+// table intact.
+//
+// Layout, all integers little-endian:
+//   "SNKS" version:u32 count:u32
+//   count x { score:i32 name:char[24] }  (name NUL-padded)
+//   crc32:u32 of everything before it
+//
+// saveAsync() does the write on the I/O thread (io_service.h) so a game over never waits on the
+// disk; saves reach the file in the order they were made.
+//
+// In the browser the file lives on an IDBFS mount. mount() starts copying it in from IndexedDB,
+// ready() turns true when that's done, and every save starts an async write-back; none of it
+// waits on the main loop. Link with -lidbfs.js.
+
+struct ScoreRecord {
+    std::string name;
+    int score;
+};
+
+class ScoreStore {
+public:
+    static const Uint32 version = 1;
+    static const int nameBytes = 24;
+    static const int recordBytes = 4 + nameBytes;
+    static const int maxRecords = 100;
+
+    explicit ScoreStore(const char* fileName) {
+#ifdef __EMSCRIPTEN__
+        path = std::string(mountPoint) + "/" + fileName;
+#else
+        path = fileName;
+#endif
+    }
+
+    // Brings the persistent copy into the filesystem (browser only)
+    void mount() {
+#ifdef __EMSCRIPTEN__
+        EM_ASM({
+            if (Module.scoreStoreMounted) return;
+            Module.scoreStoreMounted = true;
+            var dir = UTF8ToString($0);
+            try { FS.mkdir(dir); } catch (e) {}
+            FS.mount(IDBFS, {}, dir);
+            FS.syncfs(true, function(err) {
+                if (err) console.warn("scores: IndexedDB read failed", err);
+                Module.scoreStoreReady = true;
+            });
+        }, mountPoint);
+#endif
+    }
+
+    // True once load() can see the persistent copy
+    bool ready() const {
+#ifdef __EMSCRIPTEN__
+        return EM_ASM_INT({ return Module.scoreStoreReady ? 1 : 0; }) != 0;
+#else
+        return true;
+#endif
+    }
+
+    // False if there's no table yet or it fails its checks; records is left empty then
+    bool load(std::vector<ScoreRecord>& records) const {
+        records.clear();
+        FILE* f = fopen(path.c_str(), "rb");
+        if (!f) return false;
+        Uint8 data[12 + maxRecords * recordBytes + 4 + 1];
+        size_t size = fread(data, 1, sizeof(data), f);
+        fclose(f);
+        if (size < 16 || size == sizeof(data) || memcmp(data, "SNKS", 4) != 0) return corrupt("not a score table");
+        if (get32(data + 4) != version) return corrupt("unknown version");
+        Uint32 count = get32(data + 8);
+        if (count > (Uint32)maxRecords || size != 12 + count * recordBytes + 4) return corrupt("wrong size");
+        if (PngEncoder::crc32(0, data, size - 4) != get32(data + size - 4)) return corrupt("checksum mismatch");
+        for (Uint32 i = 0; i < count; ++i) {
+            const Uint8* r = data + 12 + i * recordBytes;
+            ScoreRecord record;
+            record.score = (int)get32(r);
+            const char* name = (const char*)r + 4;
+            record.name.assign(name, strnlen(name, nameBytes));
+            records.push_back(record);
+        }
+        return true;
+    }
+
+    // Write-and-rename; names longer than 23 bytes are cut
+    bool save(const std::vector<ScoreRecord>& records) const {
+        if (!replace(path, encode(records))) return false;
+        persist();
+        return true;
+    }
+
+    // The same on the I/O thread; done (optional) runs on the game thread afterwards
+    void saveAsync(const std::vector<ScoreRecord>& records, IoDone done = nullptr) const {
+        std::string target = path;
+        IoService::instance().submit("save scores", [target, data = encode(records)] { return replace(target, data); },
+                                     [done](bool ok) {
+                                         if (ok) persist();
+                                         if (done) done(ok);
+                                     });
+    }
+
+    const std::string& filePath() const { return path; }
+
+private:
+    static constexpr const char* mountPoint = "/persist";
+    std::string path;
+
+    static std::vector<Uint8> encode(const std::vector<ScoreRecord>& records) {
+        size_t count = records.size() < (size_t)maxRecords ? records.size() : (size_t)maxRecords;
+        std::vector<Uint8> data(12 + count * recordBytes + 4, 0);
+        memcpy(data.data(), "SNKS", 4);
+        put32(&data[4], version);
+        put32(&data[8], (Uint32)count);
+        for (size_t i = 0; i < count; ++i) {
+            Uint8* r = &data[12 + i * recordBytes];
+            put32(r, (Uint32)records[i].score);
+            memcpy(r + 4, records[i].name.data(), records[i].name.size() < (size_t)nameBytes ? records[i].name.size() : nameBytes - 1);
+        }
+        put32(&data[data.size() - 4], PngEncoder::crc32(0, data.data(), data.size() - 4));
+        return data;
+    }
+
+    // Temporary file, flushed to disk, renamed over the old one
+    static bool replace(const std::string& path, const std::vector<Uint8>& data) {
+        std::string temp = path + ".tmp";
+        FILE* f = fopen(temp.c_str(), "wb");
+        if (!f) {
+            fprintf(stderr, "scores: can't write %s\n", temp.c_str());
+            return false;
+        }
+        bool ok = fwrite(data.data(), 1, data.size(), f) == data.size() && fflush(f) == 0;
+#if !defined(__EMSCRIPTEN__) && !defined(_WIN32)
+        ok = ok && fsync(fileno(f)) == 0;
+#endif
+        ok = fclose(f) == 0 && ok;
+#ifdef _WIN32
+        if (ok) remove(path.c_str());  // rename() won't replace an existing file there
+#endif
+        if (!ok || rename(temp.c_str(), path.c_str()) != 0) {
+            fprintf(stderr, "scores: can't replace %s\n", path.c_str());
+            remove(temp.c_str());
+            return false;
+        }
+        return true;
+    }
+
+    // Copies the mount back to IndexedDB; saves during a write-back are folded into one more
+    static void persist() {
+#ifdef __EMSCRIPTEN__
+        EM_ASM({
+            if (Module.scoreStoreSyncing) {
+                Module.scoreStoreDirty = true;
+                return;
+            }
+            Module.scoreStoreSyncing = true;
+            var sync = function() {
+                Module.scoreStoreDirty = false;
+                FS.syncfs(false, function(err) {
+                    if (err) console.warn("scores: IndexedDB write failed", err);
+                    if (Module.scoreStoreDirty) sync();
+                    else Module.scoreStoreSyncing = false;
+                });
+            };
+            sync();
+        });
+#endif
+    }
+
+    bool corrupt(const char* why) const {
+        fprintf(stderr, "scores: ignoring %s (%s)\n", path.c_str(), why);
+        return false;
+    }
+
+    static Uint32 get32(const Uint8* p) { return p[0] | (p[1] << 8) | (p[2] << 16) | ((Uint32)p[3] << 24); }
+    static void put32(Uint8* p, Uint32 v) {
+        p[0] = (Uint8)v; p[1] = (Uint8)(v >> 8); p[2] = (Uint8)(v >> 16); p[3] = (Uint8)(v >> 24);
+    }
+};
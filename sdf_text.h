@@ -0,0 +1,239 @@
+#pragma once
+#include <SDL2/SDL.h>
+#include <vector>
+#include <string>
+#include <cmath>
+#include <cstring>
+#include <algorithm>
+#include "bitmap_font.h"
+
+// Signed-distance-field text. font_baker --sdf stores each glyph as the distance to its outline
+// (128 on the edge, brighter inside, +-spread px at 255/0) instead of coverage, so one atlas
+// draws crisp text at any size: the field is resampled at the output scale and the edge found
+// again there. The same field gives outline, glow and drop shadow for free: they're just other
+// thresholds of it, so a styled string is one shading pass over one field rather than a
+// rasterization per effect.
+//
+// SDL_Renderer has no custom shaders, so the shading runs on the CPU and SdfTextCache keeps the
+// results as textures; HUD strings change rarely, and a cached string costs one RenderCopy.
+
+struct SdfTextStyle {
+    SDL_Color fill = { 255, 255, 255, 255 };
+    float outline = 0.0f;  // Width in output pixels
+    SDL_Color outlineColor = { 0, 0, 0, 255 };
+    float glow = 0.0f;  // Falloff radius in output pixels, limited by the baked spread
+    SDL_Color glowColor = { 255, 255, 255, 128 };
+    int shadowX = 0, shadowY = 0;  // Offset of the shadow, none if both are 0
+    SDL_Color shadowColor = { 0, 0, 0, 160 };
+};
+
+class SdfText {
+public:
+    // face must be a distance field face of font (BitmapFont::sdfFace())
+    SdfText(const BitmapFont& font, const BitmapFont::Face& face) : font(font), face(face) {}
+
+    float scaleFor(float pixelSize) const { return pixelSize / face.pixelSize; }
+
+    // Size of the text itself at pixelSize, without room for effects
+    void measure(const char* text, float pixelSize, int& w, int& h) const {
+        int sw, sh;
+        font.measure(face, text, sw, sh);
+        float scale = scaleFor(pixelSize);
+        w = (int)ceilf(sw * scale);
+        h = (int)ceilf(sh * scale);
+    }
+
+    // Pixels the effects reach beyond the text box on each side
+    int margin(float pixelSize, const SdfTextStyle& style) const {
+        float reach = std::max(style.outline, std::min(style.glow, maxReach(pixelSize)));
+        return (int)ceilf(reach) + std::max(abs(style.shadowX), abs(style.shadowY)) + 1;
+    }
+
+    // RGBA32 surface of the styled text, the text box margin() pixels in from the top-left
+    SDL_Surface* render(const char* text, float pixelSize, const SdfTextStyle& style) {
+        float scale = scaleFor(pixelSize);
+        int tw, th;
+        measure(text, pixelSize, tw, th);
+        int m = margin(pixelSize, style);
+        int w = std::max(tw, 1) + 2 * m, h = std::max(th, 1) + 2 * m;
+        buildField(text, scale, m, w, h);
+
+        SDL_Surface* surface = SDL_CreateRGBSurfaceWithFormat(0, w, h, 32, SDL_PIXELFORMAT_RGBA32);
+        if (!surface) return nullptr;
+        SDL_Color fill = BitmapFont::opaqueIfUnset(style.fill);  // {r, g, b} fills, as with TTF
+        float glow = std::min(style.glow, maxReach(pixelSize));
+        bool shadow = style.shadowX || style.shadowY;
+        for (int y = 0; y < h; ++y) {
+            Uint8* row = (Uint8*)surface->pixels + (size_t)y * surface->pitch;
+            const float* d = &field[(size_t)y * w];
+            for (int x = 0; x < w; ++x) {
+                // Back to front in premultiplied colour: shadow, glow, outline, fill
+                float out[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
+                if (shadow) {
+                    int sx = x - style.shadowX, sy = y - style.shadowY;
+                    float ds = sx >= 0 && sy >= 0 && sx < w && sy < h ? field[(size_t)sy * w + sx] : -far;
+                    over(out, style.shadowColor, coverage(ds + style.outline));
+                }
+                if (glow > 0.0f && d[x] < 0.0f && d[x] > -glow) {
+                    float t = 1.0f + d[x] / glow;
+                    over(out, style.glowColor, t * t);
+                }
+                if (style.outline > 0.0f) over(out, style.outlineColor, coverage(d[x] + style.outline));
+                over(out, fill, coverage(d[x]));
+
+                Uint8* px = row + x * 4;
+                if (out[3] <= 0.0f) {
+                    px[0] = px[1] = px[2] = px[3] = 0;
+                    continue;
+                }
+                for (int c = 0; c < 3; ++c) px[c] = (Uint8)std::min(255.0f, out[c] / out[3] * 255.0f + 0.5f);
+                px[3] = (Uint8)std::min(255.0f, out[3] * 255.0f + 0.5f);
+            }
+        }
+        return surface;
+    }
+
+private:
+    static constexpr float far = 1e6f;
+    const BitmapFont& font;
+    const BitmapFont::Face& face;
+    std::vector<float> field;  // Signed distance in output pixels, reused between renders
+
+    // The field only knows distances up to spread, so effects can't reach further
+    float maxReach(float pixelSize) const { return face.spread * scaleFor(pixelSize) - 0.5f; }
+
+    static float coverage(float distance) { return std::max(0.0f, std::min(1.0f, distance + 0.5f)); }
+
+    static void over(float* out, SDL_Color c, float coverage) {
+        float a = coverage * c.a / 255.0f;
+        if (a <= 0.0f) return;
+        out[0] = c.r / 255.0f * a + out[0] * (1.0f - a);
+        out[1] = c.g / 255.0f * a + out[1] * (1.0f - a);
+        out[2] = c.b / 255.0f * a + out[2] * (1.0f - a);
+        out[3] = a + out[3] * (1.0f - a);
+    }
+
+    // Union of every glyph's field at output scale; overlapping glyphs keep the nearer edge
+    void buildField(const char* text, float scale, int m, int w, int h) {
+        float outside = -face.spread * scale;
+        field.assign((size_t)w * h, outside);
+        float toDistance = face.spread * scale / 127.0f;
+        int pen = 0;
+        for (const char* c = text; *c; ++c) {
+            const BitmapFont::Glyph* g = face.glyph(*c);
+            if (!g) continue;
+            if (c != text) pen += face.kern(c[-1], *c);
+            if (g->w && g->h) {
+                float gx = m + (pen + g->left) * scale, gy = m + g->top * scale;
+                int x0 = std::max(0, (int)floorf(gx)), y0 = std::max(0, (int)floorf(gy));
+                int x1 = std::min(w, (int)ceilf(gx + g->w * scale)), y1 = std::min(h, (int)ceilf(gy + g->h * scale));
+                for (int y = y0; y < y1; ++y) {
+                    float v = (y + 0.5f - gy) / scale - 0.5f;
+                    for (int x = x0; x < x1; ++x) {
+                        float u = (x + 0.5f - gx) / scale - 0.5f;
+                        float d = (sample(*g, u, v) - 128.0f) * toDistance;
+                        float& f = field[(size_t)y * w + x];
+                        f = std::max(f, d);
+                    }
+                }
+            }
+            pen += g->advance;
+        }
+    }
+
+    // Bilinear read of a glyph's cell, clamped to its edges
+    float sample(const BitmapFont::Glyph& g, float u, float v) const {
+        u = std::max(0.0f, std::min(u, g.w - 1.0f));
+        v = std::max(0.0f, std::min(v, g.h - 1.0f));
+        int u0 = (int)u, v0 = (int)v;
+        int u1 = std::min(u0 + 1, g.w - 1), v1 = std::min(v0 + 1, g.h - 1);
+        float fu = u - u0, fv = v - v0;
+        const Uint8* r0 = &font.atlas[(size_t)(g.y + v0) * font.atlasWidth + g.x];
+        const Uint8* r1 = &font.atlas[(size_t)(g.y + v1) * font.atlasWidth + g.x];
+        float top = r0[u0] + (r0[u1] - r0[u0]) * fu;
+        float bottom = r1[u0] + (r1[u1] - r1[u0]) * fu;
+        return top + (bottom - top) * fv;
+    }
+};
+
+// Rendered strings kept as textures, least recently used dropped first
+class SdfTextCache {
+public:
+    static const int capacity = 32;
+
+    SdfTextCache(const BitmapFont& font, const BitmapFont::Face& face) : text(font, face) {}
+    ~SdfTextCache() { release(); }
+
+    // Draws at (x, y), the text box's top-left corner or its centre
+    void draw(SDL_Renderer* renderer, const std::string& s, int x, int y, float pixelSize, const SdfTextStyle& style,
+              bool centered) {
+        Entry* e = lookup(renderer, s, pixelSize, style);
+        if (!e || !e->texture) return;
+        int left = centered ? x - e->textW / 2 : x;
+        int top = centered ? y - e->textH / 2 : y;
+        SDL_Rect dest = { left - e->margin, top - e->margin, e->w, e->h };
+        SDL_RenderCopy(renderer, e->texture, nullptr, &dest);
+    }
+
+    void release() {
+        for (Entry& e : entries) {
+            if (e.texture) SDL_DestroyTexture(e.texture);
+        }
+        entries.clear();
+    }
+
+    int hits = 0, misses = 0;
+
+private:
+    struct Entry {
+        std::string key;
+        SDL_Texture* texture;
+        int w, h, textW, textH, margin;
+        Uint32 lastUsed;
+    };
+
+    SdfText text;
+    std::vector<Entry> entries;
+    Uint32 clock = 0;
+
+    Entry* lookup(SDL_Renderer* renderer, const std::string& s, float pixelSize, const SdfTextStyle& style) {
+        std::string key = s;
+        key.append(1, '\0');
+        key.append((const char*)&pixelSize, sizeof(pixelSize));
+        key.append((const char*)&style, sizeof(style));
+        clock++;
+        for (Entry& e : entries) {
+            if (e.key == key) {
+                e.lastUsed = clock;
+                hits++;
+                return &e;
+            }
+        }
+        misses++;
+
+        SDL_Surface* surface = text.render(s.c_str(), pixelSize, style);
+        if (!surface) return nullptr;
+        Entry e;
+        e.key = key;
+        e.texture = SDL_CreateTextureFromSurface(renderer, surface);
+        if (e.texture) SDL_SetTextureBlendMode(e.texture, SDL_BLENDMODE_BLEND);
+        e.w = surface->w;
+        e.h = surface->h;
+        e.margin = text.margin(pixelSize, style);
+        text.measure(s.c_str(), pixelSize, e.textW, e.textH);
+        e.lastUsed = clock;
+        SDL_FreeSurface(surface);
+
+        if ((int)entries.size() < capacity) {
+            entries.push_back(e);
+            return &entries.back();
+        }
+        Entry* oldest = &entries[0];
+        for (Entry& o : entries) {
+            if (o.lastUsed < oldest->lastUsed) oldest = &o;
+        }
+        if (oldest->texture) SDL_DestroyTexture(oldest->texture);
+        *oldest = e;
+        return oldest;
+    }
+};
@@ -0,0 +1,261 @@
+#pragma once
+#include <SDL2/SDL.h>
+#ifndef SNAKE_NO_TTF
+#include <SDL2/SDL_ttf.h>
+#endif
+#include <string>
+#include <cstdio>
+#include <cstdlib>
+#include <algorithm>
+#include "io_service.h"
+
+// SDL call counting. Including this header routes the SDL render, texture and TTF entry
+// points used after it through counting wrappers, so it has to come before any code that
+// should be measured (the game, render_commands.h, quality_governor.h). Counters are per
+// frame: call sdlStatsEndFrame() once per frame after presenting. Define SNAKE_NO_SDL_STATS
+// to compile the wrappers out.
+
+struct SdlCallStats {
+    int clears = 0;
+    int pointCalls = 0;      // SDL_RenderDrawPoint(s) calls
+    int lineCalls = 0;       // SDL_RenderDrawLine(s)
+    int rectCalls = 0;       // SDL_RenderDrawRect(s)
+    int fillCalls = 0;       // SDL_RenderFillRect(s)
+    int copyCalls = 0;       // SDL_RenderCopy(Ex) and SDL_RenderGeometry
+    int colorChanges = 0;    // SDL_SetRenderDrawColor
+    int targetChanges = 0;   // SDL_SetRenderTarget
+    int textureUploads = 0;  // SDL_UpdateTexture
+    int texturesCreated = 0;
+    int texturesDestroyed = 0;
+    int ttfRenders = 0;      // Glyph rasterizations via TTF_Render*
+    long primitives = 0;     // Points, lines and rects submitted, counting each element of batched calls
+    long pixels = 0;         // Approximate pixels touched by draws and copies
+
+    int drawCalls() const { return clears + pointCalls + lineCalls + rectCalls + fillCalls + copyCalls; }
+    int totalCalls() const { return drawCalls() + colorChanges + targetChanges + textureUploads + texturesCreated + texturesDestroyed + ttfRenders; }
+};
+
+class SdlStats {
+public:
+    static SdlStats& instance() {
+        static SdlStats stats;
+        return stats;
+    }
+
+    SdlCallStats current;  // Frame being recorded
+    SdlCallStats last;     // Last finished frame
+
+    // Start collecting one CSV row per frame, written out by flushCsv()
+    void recordCsv(const std::string& path) {
+        csvPath = path;
+        csv = "frame,draw_calls,total_calls,clears,point_calls,line_calls,rect_calls,fill_calls,copy_calls,"
+              "color_changes,target_changes,texture_uploads,textures_created,textures_destroyed,ttf_renders,"
+              "primitives,pixels\n";
+        recording = true;
+    }
+
+    void flushCsv() {
+        if (recording) exportFileAsync(csvPath.c_str(), csv, "text/csv");
+    }
+
+    void endFrame() {
+        last = current;
+        current = SdlCallStats();
+        if (recording) {
+            char row[256];
+            snprintf(row, sizeof(row), "%ld,%d,%d,%d,%d,%d,%d,%d,%d,%d,%d,%d,%d,%d,%d,%ld,%ld\n", frame, last.drawCalls(),
+                     last.totalCalls(), last.clears, last.pointCalls, last.lineCalls, last.rectCalls, last.fillCalls,
+                     last.copyCalls, last.colorChanges, last.targetChanges, last.textureUploads, last.texturesCreated,
+                     last.texturesDestroyed, last.ttfRenders, last.primitives, last.pixels);
+            csv += row;
+        }
+        frame++;
+    }
+
+private:
+    bool recording = false;
+    long frame = 0;
+    std::string csvPath;
+    std::string csv;
+};
+
+inline void sdlStatsEndFrame() { SdlStats::instance().endFrame(); }
+
+#ifndef SNAKE_NO_SDL_STATS
+
+inline SdlCallStats& sdlFrameStats() { return SdlStats::instance().current; }
+
+inline long sdlStatsTargetArea(SDL_Renderer* renderer) {
+    int w = 0, h = 0;
+    SDL_GetRendererOutputSize(renderer, &w, &h);
+    return (long)w * h;
+}
+
+inline int sdlStatsClear(SDL_Renderer* renderer) {
+    SdlCallStats& s = sdlFrameStats();
+    s.clears++;
+    s.pixels += sdlStatsTargetArea(renderer);
+    return SDL_RenderClear(renderer);
+}
+
+inline int sdlStatsDrawPoint(SDL_Renderer* renderer, int x, int y) {
+    SdlCallStats& s = sdlFrameStats();
+    s.pointCalls++;
+    s.primitives++;
+    s.pixels++;
+    return SDL_RenderDrawPoint(renderer, x, y);
+}
+
+inline int sdlStatsDrawPoints(SDL_Renderer* renderer, const SDL_Point* points, int count) {
+    SdlCallStats& s = sdlFrameStats();
+    s.pointCalls++;
+    s.primitives += count;
+    s.pixels += count;
+    return SDL_RenderDrawPoints(renderer, points, count);
+}
+
+inline int sdlStatsDrawLine(SDL_Renderer* renderer, int x1, int y1, int x2, int y2) {
+    SdlCallStats& s = sdlFrameStats();
+    s.lineCalls++;
+    s.primitives++;
+    s.pixels += std::max(abs(x2 - x1), abs(y2 - y1)) + 1;
+    return SDL_RenderDrawLine(renderer, x1, y1, x2, y2);
+}
+
+inline int sdlStatsDrawLines(SDL_Renderer* renderer, const SDL_Point* points, int count) {
+    SdlCallStats& s = sdlFrameStats();
+    s.lineCalls++;
+    for (int i = 1; i < count; ++i) {
+        s.primitives++;
+        s.pixels += std::max(abs(points[i].x - points[i - 1].x), abs(points[i].y - points[i - 1].y)) + 1;
+    }
+    return SDL_RenderDrawLines(renderer, points, count);
+}
+
+inline int sdlStatsDrawRect(SDL_Renderer* renderer, const SDL_Rect* rect) {
+    SdlCallStats& s = sdlFrameStats();
+    s.rectCalls++;
+    s.primitives++;
+    s.pixels += rect ? 2L * (rect->w + rect->h) : 0;
+    return SDL_RenderDrawRect(renderer, rect);
+}
+
+inline int sdlStatsDrawRects(SDL_Renderer* renderer, const SDL_Rect* rects, int count) {
+    SdlCallStats& s = sdlFrameStats();
+    s.rectCalls++;
+    s.primitives += count;
+    for (int i = 0; i < count; ++i) s.pixels += 2L * (rects[i].w + rects[i].h);
+    return SDL_RenderDrawRects(renderer, rects, count);
+}
+
+inline int sdlStatsFillRect(SDL_Renderer* renderer, const SDL_Rect* rect) {
+    SdlCallStats& s = sdlFrameStats();
+    s.fillCalls++;
+    s.primitives++;
+    s.pixels += rect ? (long)rect->w * rect->h : sdlStatsTargetArea(renderer);
+    return SDL_RenderFillRect(renderer, rect);
+}
+
+inline int sdlStatsFillRects(SDL_Renderer* renderer, const SDL_Rect* rects, int count) {
+    SdlCallStats& s = sdlFrameStats();
+    s.fillCalls++;
+    s.primitives += count;
+    for (int i = 0; i < count; ++i) s.pixels += (long)rects[i].w * rects[i].h;
+    return SDL_RenderFillRects(renderer, rects, count);
+}
+
+inline int sdlStatsCopy(SDL_Renderer* renderer, SDL_Texture* texture, const SDL_Rect* src, const SDL_Rect* dst) {
+    SdlCallStats& s = sdlFrameStats();
+    s.copyCalls++;
+    s.pixels += dst ? (long)dst->w * dst->h : sdlStatsTargetArea(renderer);
+    return SDL_RenderCopy(renderer, texture, src, dst);
+}
+
+inline int sdlStatsCopyEx(SDL_Renderer* renderer, SDL_Texture* texture, const SDL_Rect* src, const SDL_Rect* dst,
+                          double angle, const SDL_Point* center, SDL_RendererFlip flip) {
+    SdlCallStats& s = sdlFrameStats();
+    s.copyCalls++;
+    s.pixels += dst ? (long)dst->w * dst->h : sdlStatsTargetArea(renderer);
+    return SDL_RenderCopyEx(renderer, texture, src, dst, angle, center, flip);
+}
+
+inline int sdlStatsSetDrawColor(SDL_Renderer* renderer, Uint8 r, Uint8 g, Uint8 b, Uint8 a) {
+    sdlFrameStats().colorChanges++;
+    return SDL_SetRenderDrawColor(renderer, r, g, b, a);
+}
+
+inline int sdlStatsSetTarget(SDL_Renderer* renderer, SDL_Texture* texture) {
+    sdlFrameStats().targetChanges++;
+    return SDL_SetRenderTarget(renderer, texture);
+}
+
+inline int sdlStatsUpdateTexture(SDL_Texture* texture, const SDL_Rect* rect, const void* pixels, int pitch) {
+    sdlFrameStats().textureUploads++;
+    return SDL_UpdateTexture(texture, rect, pixels, pitch);
+}
+
+inline SDL_Texture* sdlStatsCreateTexture(SDL_Renderer* renderer, Uint32 format, int access, int w, int h) {
+    sdlFrameStats().texturesCreated++;
+    return SDL_CreateTexture(renderer, format, access, w, h);
+}
+
+inline SDL_Texture* sdlStatsCreateTextureFromSurface(SDL_Renderer* renderer, SDL_Surface* surface) {
+    sdlFrameStats().texturesCreated++;
+    return SDL_CreateTextureFromSurface(renderer, surface);
+}
+
+inline void sdlStatsDestroyTexture(SDL_Texture* texture) {
+    if (texture) sdlFrameStats().texturesDestroyed++;
+    SDL_DestroyTexture(texture);
+}
+
+inline int sdlStatsGeometry(SDL_Renderer* renderer, SDL_Texture* texture, const SDL_Vertex* vertices, int numVertices,
+                            const int* indices, int numIndices) {
+    SdlCallStats& s = sdlFrameStats();
+    s.copyCalls++;
+    s.primitives += (numIndices ? numIndices : numVertices) / 3;
+    return SDL_RenderGeometry(renderer, texture, vertices, numVertices, indices, numIndices);
+}
+
+#ifndef SNAKE_NO_TTF
+inline SDL_Surface* sdlStatsTextSolid(TTF_Font* font, const char* text, SDL_Color fg) {
+    sdlFrameStats().ttfRenders++;
+    return TTF_RenderText_Solid(font, text, fg);
+}
+
+inline SDL_Surface* sdlStatsTextBlended(TTF_Font* font, const char* text, SDL_Color fg) {
+    sdlFrameStats().ttfRenders++;
+    return TTF_RenderText_Blended(font, text, fg);
+}
+
+inline SDL_Surface* sdlStatsTextShaded(TTF_Font* font, const char* text, SDL_Color fg, SDL_Color bg) {
+    sdlFrameStats().ttfRenders++;
+    return TTF_RenderText_Shaded(font, text, fg, bg);
+}
+#endif
+
+#define SDL_RenderClear sdlStatsClear
+#define SDL_RenderDrawPoint sdlStatsDrawPoint
+#define SDL_RenderDrawPoints sdlStatsDrawPoints
+#define SDL_RenderDrawLine sdlStatsDrawLine
+#define SDL_RenderDrawLines sdlStatsDrawLines
+#define SDL_RenderDrawRect sdlStatsDrawRect
+#define SDL_RenderDrawRects sdlStatsDrawRects
+#define SDL_RenderFillRect sdlStatsFillRect
+#define SDL_RenderFillRects sdlStatsFillRects
+#define SDL_RenderCopy sdlStatsCopy
+#define SDL_RenderCopyEx sdlStatsCopyEx
+#define SDL_SetRenderDrawColor sdlStatsSetDrawColor
+#define SDL_SetRenderTarget sdlStatsSetTarget
+#define SDL_UpdateTexture sdlStatsUpdateTexture
+#define SDL_CreateTexture sdlStatsCreateTexture
+#define SDL_CreateTextureFromSurface sdlStatsCreateTextureFromSurface
+#define SDL_DestroyTexture sdlStatsDestroyTexture
+#define SDL_RenderGeometry sdlStatsGeometry
+#ifndef SNAKE_NO_TTF
+#define TTF_RenderText_Solid sdlStatsTextSolid
+#define TTF_RenderText_Blended sdlStatsTextBlended
+#define TTF_RenderText_Shaded sdlStatsTextShaded
+#endif
+
+#endif
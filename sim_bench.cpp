@@ -0,0 +1,282 @@
+// Simulation microbenchmarks: moveSnake, checkCollisions, isPositionOccupied, spawnApple and
+// growSnake timed in isolation over snake lengths and board fill levels, reporting ns/op,
+// heap allocations/op and (on Linux, where perf events are allowed) cache misses/op.
+// The game file is compiled in whole, so these are the real methods, not copies.
+//
+//   g++ -O2 -std=c++17 -Inative sim_bench.cpp -o sim_bench_v11 -lSDL2 -lSDL2_ttf -pthread
+//   g++ -O2 -std=c++17 -Inative -DSIM_BENCH_MINI sim_bench.cpp -o sim_bench_mini -lSDL2 -lSDL2_ttf -pthread
+//   ./sim_bench_v11 [--min-ms N] [--csv]
+//
+// Run from the repository root: snake_mini opens arial.ttf in its constructor. snakev11 loads
+// its font in startup stages, which only run from the main loop, so here it has none.
+
+#include <new>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+#include <string>
+#include <random>
+#include <algorithm>
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+#define SNAKE_NO_MAIN
+#ifdef SIM_BENCH_MINI
+#include "snake_mini.cpp"
+#else
+#include "snakev11.cpp"
+#endif
+
+// Every heap allocation in the process goes through here
+static std::atomic<long> heapAllocations{ 0 };
+
+void* operator new(size_t size) {
+    heapAllocations.fetch_add(1, std::memory_order_relaxed);
+    if (void* p = malloc(size ? size : 1)) return p;
+    throw std::bad_alloc();
+}
+void* operator new[](size_t size) { return operator new(size); }
+void operator delete(void* p) noexcept { free(p); }
+void operator delete[](void* p) noexcept { free(p); }
+void operator delete(void* p, size_t) noexcept { free(p); }
+void operator delete[](void* p, size_t) noexcept { free(p); }
+
+const int boardColumns = 800 / 20;
+const int boardRows = 600 / 20;
+const int boardCells = boardColumns * boardRows;
+const int cellSize = 20;
+
+// Hardware cache-miss counter for the calling thread, if the kernel lets us have one
+class CacheMissCounter {
+public:
+    CacheMissCounter() : fd(-1) {
+#ifdef __linux__
+        perf_event_attr attr;
+        memset(&attr, 0, sizeof(attr));
+        attr.type = PERF_TYPE_HARDWARE;
+        attr.size = sizeof(attr);
+        attr.config = PERF_COUNT_HW_CACHE_MISSES;
+        attr.disabled = 1;
+        attr.exclude_kernel = 1;
+        attr.exclude_hv = 1;
+        fd = (int)syscall(__NR_perf_event_open, &attr, 0, -1, -1, 0);
+#endif
+    }
+    ~CacheMissCounter() {
+#ifdef __linux__
+        if (fd >= 0) close(fd);
+#endif
+    }
+
+    bool available() const { return fd >= 0; }
+
+    void start() {
+#ifdef __linux__
+        if (fd < 0) return;
+        ioctl(fd, PERF_EVENT_IOC_RESET, 0);
+        ioctl(fd, PERF_EVENT_IOC_ENABLE, 0);
+#endif
+    }
+
+    long long stop() {
+        long long count = 0;
+#ifdef __linux__
+        if (fd < 0) return 0;
+        ioctl(fd, PERF_EVENT_IOC_DISABLE, 0);
+        if (read(fd, &count, sizeof(count)) != sizeof(count)) count = 0;
+#endif
+        return count;
+    }
+
+private:
+    int fd;
+};
+
+// Board setup and method access for the variant under test. The snake is laid out along a
+// serpentine path from the top-left corner, so any length up to boardCells - 1 fits without
+// the head touching anything; obstacles fill random cells of the rest.
+struct SimBench {
+#ifdef SIM_BENCH_MINI
+    static const char* variant() { return "snake_mini"; }
+
+    static void clearBoard(SnakeGame& g) {
+        g.snake.clear(); g.lastPos.clear(); g.apples.clear(); g.obstacles.clear(); g.particles.clear();
+        g.direction = RIGHT; g.countdown = 0; g.gameOver = false; g.inputActive = false;
+        g.activePowerUp = NONE; g.shieldTime = 0;
+    }
+    static void addSegment(SnakeGame& g, int x, int y) { g.snake.emplace_back(x, y); g.lastPos.emplace_back(x, y); }
+    static void addObstacle(SnakeGame& g, int x, int y) { g.obstacles.emplace_back(x, y); }
+    static bool isOccupied(SnakeGame& g, float x, float y) { return g.isOccupied(x, y); }
+    static void growSnake(SnakeGame& g) { g.growSnake(); g.snake.pop_back(); g.lastPos.pop_back(); }
+    static bool gameOver(const SnakeGame& g) { return g.gameOver; }
+#else
+    static const char* variant() { return "snakev11"; }
+
+    static void clearBoard(SnakeGame& g) {
+        g.snake.clear(); g.lastPositions.clear(); g.apples.clear(); g.obstacles.clear(); g.particles.clear();
+        g.direction = Right; g.countdown = 0; g.gameOver = false; g.inputActive = false;
+    }
+    static void addSegment(SnakeGame& g, int x, int y) { g.snake.emplace_back(x, y); g.lastPositions.push_back({ x, y }); }
+    static void addObstacle(SnakeGame& g, int x, int y) { g.obstacles.emplace_back(x, y); }
+    static bool isOccupied(SnakeGame& g, float x, float y) { return g.isPositionOccupied(x, y); }
+    static void growSnake(SnakeGame& g) { g.growSnake(); g.snake.pop_back(); g.lastPositions.pop_back(); }
+    static bool gameOver(const SnakeGame& g) { return g.gameOver; }
+#endif
+    static void moveSnake(SnakeGame& g) { g.moveSnake(); }
+    static void checkCollisions(SnakeGame& g) { g.checkCollisions(); }
+    static void spawnApple(SnakeGame& g) { g.spawnApple(); g.apples.pop_back(); }
+
+    static void cellPosition(int index, int& x, int& y) {
+        int row = index / boardColumns;
+        int col = index % boardColumns;
+        if (row & 1) col = boardColumns - 1 - col;
+        x = col * cellSize;
+        y = row * cellSize;
+    }
+
+    // Lays out the board and returns the cells left free
+    static std::vector<int> setup(SnakeGame& g, int length, int obstacleCount, unsigned seed) {
+        clearBoard(g);
+        for (int i = 0; i < length; ++i) {
+            int x, y;
+            cellPosition(i, x, y);
+            addSegment(g, x, y);
+        }
+        std::vector<int> rest;
+        for (int i = length; i < boardCells; ++i) rest.push_back(i);
+        std::mt19937 rng(seed);
+        std::shuffle(rest.begin(), rest.end(), rng);
+        for (int i = 0; i < obstacleCount; ++i) {
+            int x, y;
+            cellPosition(rest[i], x, y);
+            addObstacle(g, x, y);
+        }
+        rest.erase(rest.begin(), rest.begin() + obstacleCount);
+        return rest;
+    }
+};
+
+struct Result {
+    double nsPerOp;
+    double allocsPerOp;
+    double missesPerOp;  // Negative when the counter isn't available
+};
+
+template <typename Op>
+Result measure(Op op, double minMs, CacheMissCounter& misses) {
+    for (int i = 0; i < 64; ++i) op();  // Warm caches and let vectors reach their steady capacity
+
+    long iterations = 64;
+    for (;;) {
+        long allocsBefore = heapAllocations.load();
+        misses.start();
+        auto start = std::chrono::steady_clock::now();
+        for (long i = 0; i < iterations; ++i) op();
+        auto end = std::chrono::steady_clock::now();
+        long long missCount = misses.stop();
+        long allocs = heapAllocations.load() - allocsBefore;
+        double ms = std::chrono::duration<double, std::milli>(end - start).count();
+        if (ms >= minMs || iterations >= (1L << 30)) {
+            Result r;
+            r.nsPerOp = ms * 1e6 / iterations;
+            r.allocsPerOp = (double)allocs / iterations;
+            r.missesPerOp = misses.available() ? (double)missCount / iterations : -1.0;
+            return r;
+        }
+        iterations *= ms > 0.5 ? std::max(2L, (long)(minMs / ms) + 1) : 8;
+    }
+}
+
+int main(int argc, char* argv[]) {
+    double minMs = 50.0;
+    bool csv = false;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--min-ms" && i + 1 < argc) minMs = atof(argv[++i]);
+        else if (arg == "--csv") csv = true;
+        else {
+            fprintf(stderr, "usage: %s [--min-ms N] [--csv]\n", argv[0]);
+            return EXIT_FAILURE;
+        }
+    }
+
+    // The constructor opens a window and loads the font; keep that off-screen
+    SDL_setenv("SDL_VIDEODRIVER", "dummy", 0);
+    SnakeGame* game = new SnakeGame();
+    CacheMissCounter misses;
+
+    const int lengths[] = { 4, 50, 300, 600, 900, 1199 };
+    const int fillPercents[] = { 0, 25, 50, 75, 90, 99 };
+    const char* ops[] = { "moveSnake", "checkCollisions", "isPositionOccupied", "spawnApple", "growSnake" };
+
+    if (csv) printf("variant,op,length,fill_pct,ns_per_op,allocs_per_op,cache_misses_per_op\n");
+    else printf("%-10s %-19s %6s %6s %12s %11s %13s\n", "variant", "op", "length", "fill%", "ns/op", "allocs/op", "misses/op");
+
+    for (int length : lengths) {
+        int lastOccupied = -1;
+        for (int fill : fillPercents) {
+            // Snake plus obstacles cover the fill level, always leaving one free cell for spawns
+            int occupied = std::min(boardCells - 1, std::max(length, boardCells * fill / 100));
+            if (occupied == lastOccupied) continue;
+            lastOccupied = occupied;
+            int obstacleCount = occupied - length;
+            double actualFill = 100.0 * occupied / boardCells;
+
+            for (const char* op : ops) {
+                std::vector<int> freeCells = SimBench::setup(*game, length, obstacleCount, 1234u + length + fill);
+                srand(42);
+                Result r;
+                if (!strcmp(op, "moveSnake")) {
+                    r = measure([&] { SimBench::moveSnake(*game); }, minMs, misses);
+                } else if (!strcmp(op, "checkCollisions")) {
+                    r = measure([&] { SimBench::checkCollisions(*game); }, minMs, misses);
+                } else if (!strcmp(op, "isPositionOccupied")) {
+                    // Alternate free and occupied cells so both the full scan and early exits count
+                    std::vector<SDL_Point> queries;
+                    std::mt19937 rng(7);
+                    for (int i = 0; i < 256; ++i) {
+                        int cell = (i & 1) && !freeCells.empty() ? freeCells[rng() % freeCells.size()] : (int)(rng() % boardCells);
+                        int x, y;
+                        SimBench::cellPosition(cell, x, y);
+                        queries.push_back({ x, y });
+                    }
+                    size_t q = 0;
+                    volatile bool sink = false;
+                    r = measure([&] {
+                        const SDL_Point& p = queries[q++ & 255];
+                        sink = SimBench::isOccupied(*game, (float)p.x, (float)p.y);
+                    }, minMs, misses);
+                    (void)sink;
+                } else if (!strcmp(op, "spawnApple")) {
+                    r = measure([&] { SimBench::spawnApple(*game); }, minMs, misses);
+                } else {
+                    r = measure([&] { SimBench::growSnake(*game); }, minMs, misses);
+                }
+                if (SimBench::gameOver(*game)) fprintf(stderr, "warning: %s ended the game during the run\n", op);
+
+                char missText[32];
+                if (r.missesPerOp < 0) snprintf(missText, sizeof(missText), "n/a");
+                else snprintf(missText, sizeof(missText), "%.2f", r.missesPerOp);
+                if (csv) {
+                    printf("%s,%s,%d,%.1f,%.1f,%.3f,%s\n", SimBench::variant(), op, length, actualFill, r.nsPerOp, r.allocsPerOp,
+                           r.missesPerOp < 0 ? "" : missText);
+                } else {
+                    printf("%-10s %-19s %6d %6.1f %12.1f %11.3f %13s\n", SimBench::variant(), op, length, actualFill, r.nsPerOp,
+                           r.allocsPerOp, missText);
+                }
+                fflush(stdout);
+            }
+        }
+    }
+
+    // The game is left to the OS: neither variant saves from its destructor, and snakev11's
+    // ScoreStore only writes when a name is entered, which takes input the benchmark never sends
+    return EXIT_SUCCESS;
+}
@@ -9,6 +9,8 @@
 #include <array>
 #include <iostream>
 #include <cmath>
+#include "quality_governor.h"
+#include "sdf_text.h"
 
 const int windowWidth = 800;
 const int windowHeight = 600;
@@ -87,6 +89,7 @@ public:
             std::cerr << "Font load failed\n";
             exit(EXIT_FAILURE);
         }
+        loadSdfFont();
         srand((unsigned)time(0));
         loadHighScores();
         resetGame();
@@ -94,6 +97,8 @@ public:
 
     ~SnakeGame() {
         saveHighScores();
+        backgroundCache.release();
+        delete sdfText;
         TTF_CloseFont(font);
         TTF_Quit();
         SDL_DestroyRenderer(renderer);
@@ -110,15 +115,22 @@ public:
         Uint32 currentTick = SDL_GetTicks();
         float deltaTime = (currentTick - lastTick) / 1000.0f;
         lastTick = currentTick;
+        quality.addFrameTime(deltaTime * 1000.0f);
         handleInput();
         update(deltaTime);
         render();
     }
 
+    // Quality tier API (see quality_governor.h). Pass -1 to return to automatic control.
+    int qualityTier() const { return quality.tier(); }
+    void forceQualityTier(int tier) { quality.forceTier(tier); }
+
 private:
     SDL_Window* window;
     SDL_Renderer* renderer;
     TTF_Font* font;
+    BitmapFont sdfFont;
+    SdfTextCache* sdfText = nullptr;  // Set when font_sdf.atlas loads
     std::vector<SnakeSegment> snake;
     std::vector<Apple> apples;
     std::vector<Obstacle> obstacles;
@@ -135,6 +147,8 @@ private:
     float timeSinceLastMove;
     float interp;
     std::vector<SDL_Point> lastPositions;
+    QualityGovernor quality;
+    BackgroundCache backgroundCache;
 
     void loadHighScores() {
         for (int i = 0; i < maxHighScores; ++i) {
@@ -363,7 +377,8 @@ private:
     }
 
     void addParticles(float x, float y) {
-        for (int i = 0; i < 30; ++i) {
+        int maxParticles = quality.settings().maxParticles;
+        for (int i = 0; i < 30 && (int)particles.size() < maxParticles; ++i) {
             particles.emplace_back(x, y);
         }
     }
@@ -379,6 +394,14 @@ private:
     }
 
     void renderBackground() {
+        // Lower quality tiers refresh the grass texture into a cached target every few frames
+        if (backgroundCache.begin(renderer, windowWidth, windowHeight, quality.settings().backgroundInterval)) {
+            drawBackground();
+        }
+        backgroundCache.end(renderer);
+    }
+
+    void drawBackground() {
         // Rich forest floor texture
         SDL_SetRenderDrawColor(renderer, 25, 40, 20, 255);
         SDL_RenderClear(renderer);
@@ -560,6 +583,8 @@ private:
             return;
         }
         drawTextWithGlow("Score: " + std::to_string(score), 20, 20, {100, 255, 100}, false);
+        drawTextWithGlow(std::string("Quality: ") + quality.settings().name + (quality.isForced() ? "*" : ""),
+                         windowWidth - 200, 20, {180, 200, 180}, false);
         drawTextWithGlow("Arrow keys to move", 20, windowHeight - 40, {150, 150, 150}, false);
     }
 
@@ -573,7 +598,30 @@ private:
         }
     }
 
+    // Distance field HUD text (sdf_text.h); without font_sdf.atlas the TTF path below is used
+    void loadSdfFont() {
+        FILE* f = fopen("font_sdf.atlas", "rb");
+        if (!f) return;
+        std::vector<Uint8> data;
+        Uint8 buf[4096];
+        for (size_t n; (n = fread(buf, 1, sizeof(buf), f)) > 0;) data.insert(data.end(), buf, buf + n);
+        fclose(f);
+        if (sdfFont.parse(data) && sdfFont.sdfFace()) sdfText = new SdfTextCache(sdfFont, *sdfFont.sdfFace());
+    }
+
     void drawTextWithGlow(const std::string& text, int x, int y, SDL_Color color, bool centered) {
+        if (sdfText) {
+            // The glow layers become one shadow plus a halo of the same width, shaded in one pass
+            int layers = quality.settings().textGlowLayers;
+            SdfTextStyle style;
+            style.fill = color;
+            style.glow = 2.0f * layers;
+            style.glowColor = { (Uint8)(color.r / 4), (Uint8)(color.g / 4), (Uint8)(color.b / 4), 100 };
+            style.shadowX = style.shadowY = -layers;
+            style.shadowColor = style.glowColor;
+            sdfText->draw(renderer, text, x, y, 24.0f, style, centered);
+            return;
+        }
         SDL_Surface* surface = TTF_RenderText_Blended(font, text.c_str(), color);
         if (!surface) return;
         
@@ -581,7 +629,7 @@ private:
         int destY = centered ? y - surface->h / 2 : y;
         
         // Multi-layer glow effect
-        for (int offset = 3; offset > 0; --offset) {
+        for (int offset = quality.settings().textGlowLayers; offset > 0; --offset) {
             SDL_Color glowColor = { color.r / 4, color.g / 4, color.b / 4, 100 };
             SDL_Surface* glowSurface = TTF_RenderText_Blended(font, text.c_str(), glowColor);
             if (glowSurface) {
@@ -602,7 +650,9 @@ private:
     }
 
     void drawGlow(float cx, float cy, int radius, int alpha, SDL_Color color) {
-        for (int r = radius; r > 0; r -= 2) {
+        const QualitySettings& qs = quality.settings();
+        radius = (int)(radius * qs.glowScale);
+        for (int r = radius; r > 0; r -= 2 * qs.glowStep) {
             Uint8 a = (Uint8)((float)alpha * ((float)r / radius) * 0.3f);
             for (int angle = 0; angle < 360; angle += 10) {
                 int x = (int)(cx + r * cos(angle * M_PI / 180.0));
@@ -624,6 +674,7 @@ private:
     }
 
     friend void ::mainLoop(void* arg);
+    friend struct RenderBench;  // render_bench.cpp times the draw primitives
 };
 
 SnakeGame* gameInstance = nullptr;
@@ -633,8 +684,21 @@ void mainLoop(void* arg) {
     game->mainLoopStep();
 }
 
+// Quality tier API for the page: -1 before the game exists, 0 (ULTRA) .. 3 (LOW) otherwise
+extern "C" EMSCRIPTEN_KEEPALIVE int getQualityTier() {
+    return gameInstance ? gameInstance->qualityTier() : -1;
+}
+
+// Pin a quality tier from the page, or pass -1 to hand control back to the governor
+extern "C" EMSCRIPTEN_KEEPALIVE void setQualityTier(int tier) {
+    if (gameInstance) gameInstance->forceQualityTier(tier);
+}
+
+// Tools that include this file for its SnakeGame (render_bench.cpp) define SNAKE_NO_MAIN
+#ifndef SNAKE_NO_MAIN
 int main(int argc, char* argv[]) {
     gameInstance = new SnakeGame();
     gameInstance->run();
     return 0;
-}
\ No newline at end of file
+}
+#endif
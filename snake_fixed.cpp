@@ -21,6 +21,8 @@ const int maxHighScores = 10;
 
 enum Direction { Up, Down, Left, Right };
 
+void mainLoop(void* arg);
+
 struct SnakeSegment {
     float x, y; // Use float for smooth interpolation
     SDL_Rect rect;
@@ -6,9 +6,10 @@
 #include <sstream>
 #include <string>
 #include <array>
-#include <fstream>
 #include <iostream>
 #include <cmath>
+#include "startup_stages.h"
+#include "score_store.h"
 
 // Constants
 const int windowWidth = 800;
@@ -19,7 +20,7 @@ const float snakeSpeed = 0.1f;
 const int initialObstacleCount = 5;
 const int countdownTime = 3;
 const int maxHighScores = 10;
-const std::string highScoresFile = "highscores.txt";
+const char* const highScoresFile = "highscores.bin";
 
 enum Direction { Up, Down, Left, Right };
 
@@ -52,31 +53,24 @@ struct HighScore {
 
 class SnakeGame {
 public:
-    SnakeGame() : direction(Right), score(0), gameOver(false), countdown(countdownTime),
+    SnakeGame() : font(nullptr), direction(Right), score(0), gameOver(false), countdown(countdownTime),
                   obstacleCount(initialObstacleCount), inputActive(false),
                   groundTexture(nullptr), snakeTexture(nullptr), appleTexture(nullptr), obstacleTexture(nullptr) {
         SDL_Init(SDL_INIT_VIDEO);
-        TTF_Init();
+        IoService::instance(); // Start the I/O thread now, not at the first save
         window = SDL_CreateWindow("Snake Game", SDL_WINDOWPOS_CENTERED, SDL_WINDOWPOS_CENTERED,
                                   windowWidth, windowHeight, SDL_WINDOW_SHOWN);
         renderer = SDL_CreateRenderer(window, -1, SDL_RENDERER_ACCELERATED);
-        font = TTF_OpenFont("arial.ttf", 24);
-        if (!font) {
-            printf("Failed to load font: %s\n", TTF_GetError());
-            exit(EXIT_FAILURE);
-        }
-        generateTextures(); // Generate the hex patterned ground with sinking effect
-        loadHighScores();
-        resetGame();
+        scoreStore.mount();
+        addStartupStages(); // Fonts, textures and high scores load from the main loop
     }
 
     ~SnakeGame() {
-        saveHighScores();
         if (groundTexture) SDL_DestroyTexture(groundTexture);
         if (snakeTexture) SDL_DestroyTexture(snakeTexture);
         if (appleTexture) SDL_DestroyTexture(appleTexture);
         if (obstacleTexture) SDL_DestroyTexture(obstacleTexture);
-        TTF_CloseFont(font);
+        if (font) TTF_CloseFont(font);
         TTF_Quit();
         SDL_DestroyRenderer(renderer);
         SDL_DestroyWindow(window);
@@ -89,6 +83,17 @@ public:
 
     static void mainLoop(void* arg) {
         SnakeGame* game = static_cast<SnakeGame*>(arg);
+        IoService::instance().poll();
+        if (!game->startup.done()) {
+            bool wasReady = game->startup.criticalReady();
+            game->startup.run();
+            if (!game->startup.criticalReady()) {
+                game->handleInput();
+                game->renderLoading();
+                return;
+            }
+            if (!wasReady) game->resetGame(); // The countdown starts once everything it draws is loaded
+        }
         game->handleInput();
         game->update(1.0f / 60.0f);
         game->render();
@@ -109,6 +114,11 @@ private:
     Uint32 startTime;
     int obstacleCount;
     bool inputActive;
+    std::string username;
+    std::array<HighScore, maxHighScores> highScores;
+    StartupStages startup;
+    ScoreStore scoreStore{ highScoresFile };
+    bool highScoresLoaded = false;
 
     // Textures
     SDL_Texture* groundTexture;
@@ -116,11 +126,40 @@ private:
     SDL_Texture* appleTexture;
     SDL_Texture* obstacleTexture;
 
-    void generateTextures() {
-        groundTexture = createHexSinkingPatternTexture(64, 64);
-        snakeTexture = createGradientTexture(gridSize, gridSize, {10, 50, 10, 255}, {20, 200, 20, 255});
-        appleTexture = createBrightGlowCircleTexture(gridSize, {255, 80, 80, 255});
-        obstacleTexture = createStoneRoughTexture(gridSize, gridSize);
+    // Everything the constructor used to load up front; mainLoop runs it a few ms per frame.
+    // Gameplay needs the font and textures, the high scores aren't shown before game over.
+    void addStartupStages() {
+        startup.add("font", true, [this] {
+            TTF_Init();
+            font = TTF_OpenFont("arial.ttf", 24);
+            if (!font) {
+                printf("Failed to load font: %s\n", TTF_GetError());
+                exit(EXIT_FAILURE);
+            }
+            return true;
+        });
+        startup.add("ground", true, [this] { groundTexture = createHexSinkingPatternTexture(64, 64); return true; });
+        startup.add("snake", true, [this] { snakeTexture = createGradientTexture(gridSize, gridSize, {10, 50, 10, 255}, {20, 200, 20, 255}); return true; });
+        startup.add("apple", true, [this] { appleTexture = createBrightGlowCircleTexture(gridSize, {255, 80, 80, 255}); return true; });
+        startup.add("obstacle", true, [this] { obstacleTexture = createStoneRoughTexture(gridSize, gridSize); return true; });
+        startup.add("high scores", false, [this] {
+            if (!scoreStore.ready()) return false; // Still coming in from IndexedDB
+            loadHighScores();
+            highScoresLoaded = true;
+            return true;
+        });
+    }
+
+    // Shown until the critical stages are done: a progress bar, nothing that needs the font
+    void renderLoading() {
+        SDL_SetRenderDrawColor(renderer, 10, 20, 10, 255);
+        SDL_RenderClear(renderer);
+        SDL_Rect frame = { windowWidth / 4, windowHeight / 2 - 8, windowWidth / 2, 16 };
+        SDL_Rect bar = { frame.x + 2, frame.y + 2, (int)((frame.w - 4) * startup.progress()), frame.h - 4 };
+        SDL_SetRenderDrawColor(renderer, 20, 200, 20, 255);
+        SDL_RenderDrawRect(renderer, &frame);
+        SDL_RenderFillRect(renderer, &bar);
+        SDL_RenderPresent(renderer);
     }
 
     // Generate a hexagonal tessellation with sinking effect
@@ -401,6 +440,7 @@ private:
                 break;
             }
         }
+        saveHighScores();
     }
 
     void renderText(const char* text, int x, int y) {
@@ -473,25 +513,20 @@ private:
     }
 
     void loadHighScores() {
-        std::ifstream hsFile(highScoresFile);
-        if (hsFile.is_open()) {
-            for (size_t i=0; i<maxHighScores && !hsFile.eof(); ++i) {
-                std::getline(hsFile, highScores[i].username);
-                hsFile>> highScores[i].score;
-                hsFile.ignore();
-            }
-            hsFile.close();
+        std::vector<ScoreRecord> records;
+        scoreStore.load(records);
+        for (size_t i=0; i<maxHighScores; ++i) {
+            highScores[i].username = i < records.size() ? records[i].name : "";
+            highScores[i].score = i < records.size() ? records[i].score : 0;
         }
     }
 
+    // Called whenever the table changes; the store replaces the file atomically
     void saveHighScores() {
-        std::ofstream hsFile(highScoresFile);
-        if (hsFile.is_open()) {
-            for (const auto& hs: highScores) {
-                hsFile<<hs.username<<'\n'<<hs.score<<'\n';
-            }
-            hsFile.close();
-        }
+        if (!highScoresLoaded) return; // Don't replace a table we haven't read yet
+        std::vector<ScoreRecord> records;
+        for (const auto& hs: highScores) records.push_back({ hs.username, hs.score });
+        scoreStore.saveAsync(records);
     }
 };
 
@@ -10,6 +10,7 @@
 #include <iostream>
 #include <cmath>
 #include <algorithm>
+#include "autopilot.h"
 
 const int W = 800, H = 600, GRID = 20, INIT_LEN = 4, MAX_SCORES = 8;
 const float SPEED = 0.12f, SPEED_BOOST = 0.08f;
@@ -64,6 +65,12 @@ class SnakeGame {
     
     std::vector<Vec2> lastPos;
 
+    // Autopilot soak testing (--stress)
+    Autopilot autopilot{W/GRID, H/GRID, GRID};
+    StressMonitor stress;
+    int stressRenderEvery = 0, stressObstacles = 0;
+    long powerUpsSeen[4] = {}, shieldsUsed = 0;
+
 public:
     SnakeGame() : countdown(COUNTDOWN), obstacleCount(INIT_OBSTACLES) {
         SDL_Init(SDL_INIT_VIDEO);
@@ -86,7 +93,14 @@ public:
     
     void run() { emscripten_set_main_loop_arg(mainLoop, this, 0, 1); }
 
+    // Bot plays back to back games at an uncapped tick rate, rendering every Nth tick (0 = never)
+    void startStress(double seconds, int renderEvery, int obstacles, double logSeconds) {
+        stressRenderEvery = renderEvery; stressObstacles = obstacles; countdown = 0;
+        stress.start(seconds, logSeconds);
+    }
+
     void mainLoopStep() {
+        if (stress.active()) { stressStep(); return; }
         Uint32 now = SDL_GetTicks();
         float dt = (now - lastMove) / 1000.0f;
         lastMove = now;
@@ -97,6 +111,55 @@ public:
     }
 
 private:
+    void stressStep() {
+        SDL_Event e;
+        while (SDL_PollEvent(&e)) if (e.type == SDL_QUIT) { stress.stop(); emscripten_cancel_main_loop(); return; }
+        
+        // Ticks up to the next rendered frame, or about a frame's worth of time without rendering
+        Uint64 start = SDL_GetPerformanceCounter(), budget = SDL_GetPerformanceFrequency() / 60;
+        for (int i = 0; stressRenderEvery > 0 ? i < stressRenderEvery : SDL_GetPerformanceCounter() - start < budget; ++i) stressTick();
+        if (stressRenderEvery > 0) {
+            Uint64 t = SDL_GetPerformanceCounter();
+            render();
+            stress.frameRendered((SDL_GetPerformanceCounter() - t) * 1000.0 / SDL_GetPerformanceFrequency());
+        }
+        
+        bool done = stress.finished();
+        if (stress.logDue() || done) {
+            char state[200];
+            snprintf(state, sizeof(state), "length=%zu score=%d obstacles=%zu apples=%zu particles=%zu powerups=%ld/%ld/%ld shields=%ld",
+                     snake.size(), score, obstacles.size(), apples.size(), particles.size(),
+                     powerUpsSeen[SPEED_DOWN], powerUpsSeen[MULTI_APPLE], powerUpsSeen[SHIELD], shieldsUsed);
+            stress.log(state);
+        }
+        if (done) { stress.stop(); emscripten_cancel_main_loop(); }
+    }
+    
+    void stressTick() {
+        stress.beginTick();
+        if (gameOver) {
+            stress.gameEnded((int)snake.size());
+            resetGame(); inputActive = false; SDL_StopTextInput();
+        }
+        if (countdown > 0) {
+            countdown = 0;
+            while ((int)obstacles.size() < stressObstacles) addObstacle();
+        }
+        
+        autopilot.clear();
+        for (size_t i = 0; i + 1 < snake.size(); ++i) autopilot.block(snake[i].pos.x, snake[i].pos.y);
+        for (auto& o : obstacles) autopilot.block(o.pos.x, o.pos.y);
+        for (auto& a : apples) autopilot.target(a.pos.x, a.pos.y);
+        int move = autopilot.choose(snake[0].pos.x, snake[0].pos.y, (int)snake.size());
+        if (move >= 0) direction = (Dir)move;
+        else if (hasShield) { activateShield(); shieldsUsed++; }  // Boxed in: spend the shield
+        
+        PowerUp before = activePowerUp;
+        update(moveSpeed);
+        if (activePowerUp != NONE && activePowerUp != before) powerUpsSeen[activePowerUp]++;
+        stress.endTick();
+    }
+    
     void resetGame() {
         snake.clear(); lastPos.clear(); apples.clear(); obstacles.clear(); particles.clear();
         
@@ -440,13 +503,28 @@ private:
     }
     
     friend void ::mainLoop(void* arg);
+    friend struct SimBench;  // sim_bench.cpp drives the simulation methods directly
 };
 
 SnakeGame* game = nullptr;
 void mainLoop(void* arg) { static_cast<SnakeGame*>(arg)->mainLoopStep(); }
 
-int main() {
+// Tools that include this file for its SnakeGame (sim_bench.cpp) define SNAKE_NO_MAIN
+#ifndef SNAKE_NO_MAIN
+int main(int argc, char* argv[]) {
     game = new SnakeGame();
+    // --stress SECONDS (0 = until closed) [--stress-render N] [--stress-obstacles N] [--stress-log SECONDS]
+    double stressSeconds = -1, stressLog = 10;
+    int stressRender = 0, stressObstacles = 0;
+    for (int i = 1; i + 1 < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--stress") stressSeconds = atof(argv[++i]);
+        else if (arg == "--stress-render") stressRender = atoi(argv[++i]);
+        else if (arg == "--stress-obstacles") stressObstacles = atoi(argv[++i]);
+        else if (arg == "--stress-log") stressLog = atof(argv[++i]);
+    }
+    if (stressSeconds >= 0) game->startStress(stressSeconds, stressRender, stressObstacles, stressLog);
     game->run();
     return 0;
-}
\ No newline at end of file
+}
+#endif
\ No newline at end of file
@@ -0,0 +1,362 @@
+#pragma once
+#include <SDL2/SDL.h>
+#include <vector>
+#include <deque>
+#include <string>
+#include <cstring>
+#include "png_codec.h"
+#include "autopilot.h"
+
+// Deterministic replays of snakev11 rounds, for the leaderboard server to check scores with.
+//
+// Everything random that decides a round (obstacle and apple cells) comes from SnakeRandom,
+// seeded once per round, so a round is fully described by its seed and the direction the snake
+// moved in on each tick. SnakeReplay records that: the seed, the tick count and only the ticks
+// where the direction changed. SnakeSim plays it back under the same rules as the game (board,
+// wrap-around, growth, an obstacle every fifth apple, self and obstacle collisions) and checks
+// that the snake dies on the last tick with the claimed score.
+//
+// SnakeSim can also run with another obstacle interval, for what-if balance analysis of recorded
+// rounds (replay_archive.cpp); verify() is only meaningful under the game's own rules.
+//
+// Wire format, all integers little-endian; several replays may be sent back to back:
+//   "SNKR" version:u32 seed:u32 ticks:u32 score:i32 name:char[24] count:u32
+//   count x { tick:u32 direction:u8 }  (ticks strictly increasing, direction 0..3 = Up Down Left Right)
+//   crc32:u32 of everything before it
+
+struct SnakeRules {
+    static const int columns = 40;
+    static const int rows = 30;
+    static const int cells = columns * rows;
+    static const int initialLength = 4;
+    static const int initialObstacles = 5;
+    static const int obstacleEvery = 5;  // An obstacle is added each time the score reaches a multiple of this
+    enum { Up, Down, Left, Right };      // Same order as the games' Direction enums
+
+    static bool opposite(int a, int b) { return a != b && (a >> 1) == (b >> 1); }
+};
+
+// xorshift32: identical on every compiler and platform, unlike rand()
+class SnakeRandom {
+public:
+    explicit SnakeRandom(Uint32 seed = 1) { reseed(seed); }
+    void reseed(Uint32 seed) { state = seed ? seed : 0x9E3779B9u; }
+    Uint32 next() {
+        state ^= state << 13;
+        state ^= state >> 17;
+        state ^= state << 5;
+        return state;
+    }
+    int below(int n) { return (int)(next() % (Uint32)n); }
+
+private:
+    Uint32 state;
+};
+
+struct ReplayTurn {
+    Uint32 tick;
+    Uint8 direction;
+};
+
+struct SnakeReplay {
+    static const Uint32 version = 1;
+    static const int nameBytes = 24;
+    static const size_t headerBytes = 4 + 4 + 4 + 4 + 4 + nameBytes + 4;
+    static const Uint32 maxTurns = 1u << 20;
+
+    std::string name;
+    Uint32 seed = 0;
+    Uint32 ticks = 0;
+    int score = 0;
+    std::vector<ReplayTurn> turns;
+
+    // New round; turns keeps its capacity so recording doesn't allocate during play
+    void start(Uint32 roundSeed) {
+        seed = roundSeed;
+        ticks = 0;
+        score = 0;
+        turns.clear();
+        if (turns.capacity() < 4096) turns.reserve(4096);
+        lastDirection = SnakeRules::Right;
+    }
+
+    // Once per tick, with the direction the snake moves in on it
+    void tick(int direction) {
+        if (direction != lastDirection) {
+            turns.push_back({ ticks, (Uint8)direction });
+            lastDirection = direction;
+        }
+        ticks++;
+    }
+
+    void finish(int finalScore) { score = finalScore; }
+
+    // Appends the wire form to out
+    void encode(std::string& out) const {
+        size_t start = out.size();
+        out.append("SNKR", 4);
+        put32(out, version);
+        put32(out, seed);
+        put32(out, ticks);
+        put32(out, (Uint32)score);
+        char padded[nameBytes] = {};
+        memcpy(padded, name.data(), name.size() < (size_t)nameBytes ? name.size() : nameBytes - 1);
+        out.append(padded, nameBytes);
+        put32(out, (Uint32)turns.size());
+        for (const ReplayTurn& t : turns) {
+            put32(out, t.tick);
+            out.push_back((char)t.direction);
+        }
+        put32(out, PngEncoder::crc32(0, (const Uint8*)out.data() + start, out.size() - start));
+    }
+
+    // Reads the replay starting at data[pos] and moves pos past it; false if it's malformed
+    bool decode(const Uint8* data, size_t size, size_t& pos) {
+        if (size - pos < headerBytes + 4 || memcmp(data + pos, "SNKR", 4) != 0) return false;
+        const Uint8* p = data + pos;
+        if (get32(p + 4) != version) return false;
+        Uint32 count = get32(p + 20 + nameBytes);
+        if (count > maxTurns || size - pos < headerBytes + count * 5 + 4) return false;
+        size_t length = headerBytes + count * 5;
+        if (PngEncoder::crc32(0, p, length) != get32(p + length)) return false;
+        seed = get32(p + 8);
+        ticks = get32(p + 12);
+        score = (int)get32(p + 16);
+        name.clear();
+        for (const char* c = (const char*)p + 20; c < (const char*)p + 20 + nameBytes && *c; ++c) {
+            if ((Uint8)*c >= 32 && *c != 127) name.push_back(*c);  // No control characters in names
+        }
+        turns.resize(count);
+        for (Uint32 i = 0; i < count; ++i) {
+            const Uint8* t = p + headerBytes + i * 5;
+            turns[i].tick = get32(t);
+            turns[i].direction = t[4];
+        }
+        pos += length + 4;
+        return true;
+    }
+
+private:
+    int lastDirection = SnakeRules::Right;
+
+    static Uint32 get32(const Uint8* p) { return p[0] | (p[1] << 8) | (p[2] << 16) | ((Uint32)p[3] << 24); }
+    static void put32(std::string& out, Uint32 v) {
+        char b[4] = { (char)v, (char)(v >> 8), (char)(v >> 16), (char)(v >> 24) };
+        out.append(b, 4);
+    }
+};
+
+// The game's rules on a grid of cells, without rendering or timing. Cells are row * columns + column.
+class SnakeSim {
+public:
+    enum Verdict { Valid, Malformed, BadTurn, DiedEarly, StillAlive, ScoreMismatch, TooLong, BoardFull };
+    enum Death { Alive, HitSelf, HitObstacle, NoRoom };
+
+    static const char* verdictName(Verdict v) {
+        static const char* names[] = { "valid", "malformed", "bad turn", "died early", "still alive", "score mismatch",
+                                       "too long", "board full" };
+        return names[v];
+    }
+
+    static const char* deathName(Death d) {
+        static const char* names[] = { "alive", "self", "obstacle", "no room" };
+        return names[d];
+    }
+
+    explicit SnakeSim(int obstacleEvery = SnakeRules::obstacleEvery)
+        : obstacleInterval(obstacleEvery), bodyCount(SnakeRules::cells, 0), obstacle(SnakeRules::cells, 0) {}
+
+    void reset(Uint32 seed) {
+        random.reseed(seed);
+        for (int c : body) bodyCount[c] = 0;
+        for (int c : obstacles) obstacle[c] = 0;
+        body.clear();
+        obstacles.clear();
+        apple = -1;
+        occupiedCells = 0;
+        full = false;
+        score = 0;
+        direction = SnakeRules::Right;
+        alive = true;
+        cause = Alive;
+        ticks = 0;
+        lastObstacleTick = 0;
+        for (int i = 0; i < SnakeRules::initialLength; ++i) addSegment(i, false);
+        for (int i = 0; i < SnakeRules::initialObstacles; ++i) addObstacle();
+        spawnApple();
+    }
+
+    // One move in direction; false once the snake has died (or the board has no free cell left)
+    bool tick(int newDirection) {
+        if (!alive) return false;
+        direction = newDirection;
+        ticks++;
+        int head = body.front();
+        int x = head % SnakeRules::columns, y = head / SnakeRules::columns;
+        switch (direction) {
+            case SnakeRules::Up:    y = y == 0 ? SnakeRules::rows - 1 : y - 1; break;
+            case SnakeRules::Down:  y = y == SnakeRules::rows - 1 ? 0 : y + 1; break;
+            case SnakeRules::Left:  x = x == 0 ? SnakeRules::columns - 1 : x - 1; break;
+            case SnakeRules::Right: x = x == SnakeRules::columns - 1 ? 0 : x + 1; break;
+        }
+        // Every segment takes the place of the one before it: the tail cell is freed, the head cell taken
+        removeSegment();
+        head = y * SnakeRules::columns + x;
+        addSegment(head, true);
+
+        if (head == apple) {
+            score++;
+            apple = -1;
+            occupiedCells--;
+            if (!spawnApple()) return die(NoRoom);
+            addSegment(body.back(), false);  // Grows by repeating the tail
+            if (obstacleInterval > 0 && score % obstacleInterval == 0) {
+                if (!addObstacle()) return die(NoRoom);
+                lastObstacleTick = ticks;
+            }
+        }
+        if (bodyCount[head] > 1) return die(HitSelf);
+        if (obstacle[head]) return die(HitObstacle);
+        return true;
+    }
+
+    // Follows the replay's turns without judging them, until the snake dies or the log ends
+    void play(const SnakeReplay& replay) {
+        reset(replay.seed);
+        size_t next = 0;
+        int current = SnakeRules::Right;
+        for (Uint32 t = 0; t < replay.ticks && alive; ++t) {
+            while (next < replay.turns.size() && replay.turns[next].tick <= t) current = replay.turns[next++].direction & 3;
+            tick(current);
+        }
+    }
+
+    // Plays the replay back; Valid if it ends in a game over on its last tick at its score
+    Verdict verify(const SnakeReplay& replay, Uint32 maxTicks = 1u << 22) {
+        if (replay.ticks > maxTicks) return TooLong;
+        reset(replay.seed);
+        size_t next = 0;
+        int current = SnakeRules::Right;
+        for (Uint32 t = 0; t < replay.ticks; ++t) {
+            if (next < replay.turns.size() && replay.turns[next].tick <= t) {
+                const ReplayTurn& turn = replay.turns[next++];
+                if (turn.tick != t || turn.direction > 3) return Malformed;
+                // Before the first move the snake may start out any way but back over its body,
+                // and the countdown lets the player change their mind freely
+                if (t > 0 && SnakeRules::opposite(turn.direction, current)) return BadTurn;
+                current = turn.direction;
+            }
+            if (!tick(current)) {
+                if (full) return BoardFull;
+                if (t + 1 != replay.ticks) return DiedEarly;
+                return score == replay.score ? Valid : ScoreMismatch;
+            }
+        }
+        return next < replay.turns.size() ? Malformed : StillAlive;
+    }
+
+    int currentScore() const { return score; }
+    Death death() const { return cause; }
+    Uint32 ticksPlayed() const { return ticks; }
+    Uint32 lastObstacleAt() const { return lastObstacleTick; }  // Tick the latest obstacle appeared on, 0 for the initial ones
+    int obstaclesAdded() const { return (int)obstacles.size() - SnakeRules::initialObstacles; }
+    bool isAlive() const { return alive; }
+    int heading() const { return direction; }
+    const std::deque<int>& snake() const { return body; }  // Head first; a grown tail repeats its cell
+    const std::vector<int>& obstacleCells() const { return obstacles; }
+    int appleCell() const { return apple; }
+
+private:
+    int obstacleInterval;
+    SnakeRandom random;
+    std::deque<int> body;
+    std::vector<Uint16> bodyCount;  // Segments on each cell
+    std::vector<Uint8> obstacle;
+    std::vector<int> obstacles;
+    int apple = -1;
+    int occupiedCells = 0;  // Cells holding a segment, an obstacle or the apple
+    bool full = false;      // A spawn found no free cell; the game itself would hang there
+    int score = 0;
+    int direction = SnakeRules::Right;
+    bool alive = false;
+    Death cause = Alive;
+    Uint32 ticks = 0;
+    Uint32 lastObstacleTick = 0;
+
+    bool die(Death why) {
+        cause = why;
+        return alive = false;
+    }
+
+    void addSegment(int cell, bool atHead) {
+        if (atHead) body.push_front(cell);
+        else body.push_back(cell);
+        if (bodyCount[cell]++ == 0) occupiedCells++;
+    }
+
+    void removeSegment() {
+        int cell = body.back();
+        body.pop_back();
+        if (--bodyCount[cell] == 0) occupiedCells--;
+    }
+
+    bool occupied(int cell) const { return bodyCount[cell] || obstacle[cell] || cell == apple; }
+
+    // Same draws as the game: column, then row, until the cell is free
+    int freeCell() {
+        if (occupiedCells >= SnakeRules::cells) {
+            full = true;
+            return -1;
+        }
+        int cell;
+        do {
+            int x = random.below(SnakeRules::columns);
+            int y = random.below(SnakeRules::rows);
+            cell = y * SnakeRules::columns + x;
+        } while (occupied(cell));
+        return cell;
+    }
+
+    bool spawnApple() {
+        int cell = freeCell();
+        if (cell < 0) return false;
+        apple = cell;
+        occupiedCells++;
+        return true;
+    }
+
+    bool addObstacle() {
+        int cell = freeCell();
+        if (cell < 0) return false;
+        obstacle[cell] = 1;
+        obstacles.push_back(cell);
+        occupiedCells++;
+        return true;
+    }
+};
+
+// A whole round played by the autopilot, the way stress mode plays the game, under sim's rules;
+// false if the snake was still alive after maxTicks
+inline bool playAutopilotRound(SnakeSim& sim, Uint32 seed, SnakeReplay& replay, Uint32 maxTicks = 1u << 20) {
+    Autopilot autopilot(SnakeRules::columns, SnakeRules::rows, 1);
+    sim.reset(seed);
+    replay.start(seed);
+    while (sim.isAlive() && replay.ticks < maxTicks) {
+        autopilot.clear();
+        const std::deque<int>& snake = sim.snake();
+        for (size_t i = 0; i + 1 < snake.size(); ++i) autopilot.block(snake[i] % SnakeRules::columns, snake[i] / SnakeRules::columns);
+        for (int c : sim.obstacleCells()) autopilot.block(c % SnakeRules::columns, c / SnakeRules::columns);
+        autopilot.target(sim.appleCell() % SnakeRules::columns, sim.appleCell() / SnakeRules::columns);
+        int move = autopilot.choose(snake[0] % SnakeRules::columns, snake[0] / SnakeRules::columns, (int)snake.size());
+        int direction = move >= 0 && !SnakeRules::opposite(move, sim.heading()) ? move : sim.heading();
+        replay.tick(direction);
+        sim.tick(direction);
+    }
+    replay.finish(sim.currentScore());
+    return !sim.isAlive();
+}
+
+inline bool playAutopilotRound(Uint32 seed, SnakeReplay& replay, Uint32 maxTicks = 1u << 20) {
+    SnakeSim sim;
+    return playAutopilotRound(sim, seed, replay, maxTicks);
+}
@@ -9,6 +9,8 @@
 #include <array>
 #include <iostream>
 #include <cmath>
+#include "sdl_stats.h"
+#include "quality_governor.h"
 
 const int windowWidth = 800;
 const int windowHeight = 600;
@@ -101,6 +103,7 @@ public:
 
     ~SnakeGame() {
         saveHighScores();
+        backgroundCache.release();
         TTF_CloseFont(font);
         TTF_Quit();
         SDL_DestroyRenderer(renderer);
@@ -118,12 +121,18 @@ public:
         float deltaTime = (currentTick - lastTick) / 1000.0f;
         lastTick = currentTick;
         globalTime += deltaTime;
+        quality.addFrameTime(deltaTime * 1000.0f);
 
         handleInput();
         update(deltaTime);
         render();
+        sdlStatsEndFrame();
     }
 
+    // Quality tier API (see quality_governor.h). Pass -1 to return to automatic control.
+    int qualityTier() const { return quality.tier(); }
+    void forceQualityTier(int tier) { quality.forceTier(tier); }
+
 private:
     SDL_Window* window;
     SDL_Renderer* renderer;
@@ -145,6 +154,9 @@ private:
     float interp;
     std::vector<SDL_Point> lastPositions;
     float globalTime;
+    QualityGovernor quality;
+    BackgroundCache backgroundCache;
+    bool showCallStats = false;  // F3: SDL call counts from sdl_stats.h
 
     void loadHighScores() {
         for (int i = 0; i < maxHighScores; ++i) {
@@ -240,6 +252,10 @@ private:
                 emscripten_cancel_main_loop();
                 return;
             }
+            if (event.type == SDL_KEYDOWN && event.key.keysym.sym == SDLK_F3) {
+                showCallStats = !showCallStats;
+                continue;
+            }
 
             if (gameOver) {
                 if (inputActive) {
@@ -397,7 +413,8 @@ private:
     }
 
     void addParticles(float x, float y) {
-        for (int i = 0; i < 30; ++i) {
+        int maxParticles = quality.settings().maxParticles;
+        for (int i = 0; i < 30 && (int)particles.size() < maxParticles; ++i) {
             particles.emplace_back(x, y);
         }
     }
@@ -413,6 +430,14 @@ private:
     }
 
     void renderRealisticBackground() {
+        // The noise overlay is tens of thousands of rects, so lower tiers cache it for a few frames
+        if (backgroundCache.begin(renderer, windowWidth, windowHeight, quality.settings().backgroundInterval)) {
+            drawRealisticBackground();
+        }
+        backgroundCache.end(renderer);
+    }
+
+    void drawRealisticBackground() {
         // Deep forest gradient
         for (int y = 0; y < windowHeight; y += 2) {
             float ratio = (float)y / windowHeight;
@@ -551,6 +576,8 @@ private:
     }
 
     void renderUI() {
+        if (showCallStats) renderCallStats();
+
         if (countdown > 0) {
             drawEnhancedText("GET READY: " + std::to_string(countdown + 1), windowWidth / 2, windowHeight / 2, {255,255,100}, true);
             return;
@@ -569,9 +596,23 @@ private:
         }
 
         drawEnhancedText("Score: " + std::to_string(score), 20, 30, {100, 255, 100}, false);
+        drawEnhancedText(std::string("Quality: ") + quality.settings().name + (quality.isForced() ? "*" : ""),
+                         windowWidth - 200, 30, {180, 180, 220}, false);
         drawEnhancedText("Arrow Keys to Move", 20, windowHeight - 30, {150, 150, 150}, false);
     }
 
+    // Last frame's SDL call volume; the readout's own text calls show up in the next frame
+    void renderCallStats() {
+        const SdlCallStats& s = SdlStats::instance().last;
+        SDL_Color color = {255, 180, 0};
+        drawEnhancedText("SDL calls: " + std::to_string(s.drawCalls()) + " draw / " + std::to_string(s.totalCalls()) + " total",
+                         20, 70, color, false);
+        drawEnhancedText("points " + std::to_string(s.pointCalls) + "  fills " + std::to_string(s.fillCalls) +
+                         "  colors " + std::to_string(s.colorChanges), 20, 100, color, false);
+        drawEnhancedText("pixels " + std::to_string(s.pixels / 1000) + "k  tex +" + std::to_string(s.texturesCreated) +
+                         "/-" + std::to_string(s.texturesDestroyed) + "  ttf " + std::to_string(s.ttfRenders), 20, 130, color, false);
+    }
+
     void renderHighScores() {
         int startY = windowHeight / 2;
         drawEnhancedText("HIGH SCORES", windowWidth / 2, startY, {255, 215, 0}, true);
@@ -591,7 +632,7 @@ private:
             SDL_Rect{x, y, surface->w, surface->h};
 
         // Multi-layer glow effect
-        for (int offset = 3; offset > 0; --offset) {
+        for (int offset = quality.settings().textGlowLayers; offset > 0; --offset) {
             SDL_Color glowColor = {0, 0, 0, (Uint8)(100 / offset)};
             SDL_Surface* glowSurface = TTF_RenderText_Blended(font, text.c_str(), glowColor);
             if (glowSurface) {
@@ -641,7 +682,9 @@ private:
     }
 
     void drawAdvancedGlow(int cx, int cy, int radius, int alpha, SDL_Color color) {
-        for (int r = radius; r > 0; r -= 2) {
+        const QualitySettings& qs = quality.settings();
+        radius = (int)(radius * qs.glowScale);
+        for (int r = radius; r > 0; r -= 2 * qs.glowStep) {
             float intensity = (float)r / radius;
             Uint8 a = (Uint8)(alpha * intensity * intensity);
             SDL_SetRenderDrawColor(renderer, color.r, color.g, color.b, a);
@@ -690,6 +733,7 @@ private:
     }
 
     friend void ::mainLoop(void* arg);
+    friend struct RenderBench;  // render_bench.cpp times the draw primitives
 };
 
 SnakeGame* gameInstance = nullptr;
@@ -699,7 +743,38 @@ void mainLoop(void* arg) {
     game->mainLoopStep();
 }
 
+// Quality tier API for the page: -1 before the game exists, 0 (ULTRA) .. 3 (LOW) otherwise
+extern "C" EMSCRIPTEN_KEEPALIVE int getQualityTier() {
+    return gameInstance ? gameInstance->qualityTier() : -1;
+}
+
+// Pin a quality tier from the page, or pass -1 to hand control back to the governor
+extern "C" EMSCRIPTEN_KEEPALIVE void setQualityTier(int tier) {
+    if (gameInstance) gameInstance->forceQualityTier(tier);
+}
+
+// Start collecting per-frame SDL call counts; downloadSdlStats() then saves them as CSV
+extern "C" EMSCRIPTEN_KEEPALIVE void recordSdlStats() {
+    SdlStats::instance().recordCsv("sdl_stats.csv");
+}
+
+extern "C" EMSCRIPTEN_KEEPALIVE void downloadSdlStats() {
+    SdlStats::instance().flushCsv();
+}
+
+// Tools that include this file for its SnakeGame (render_bench.cpp) define SNAKE_NO_MAIN
+#ifndef SNAKE_NO_MAIN
 int main(int argc, char* argv[]) {
     gameInstance = new SnakeGame();
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--sdl-stats" && i + 1 < argc) {
+            // One CSV row of SDL call counts per frame, written on exit
+            SdlStats::instance().recordCsv(argv[++i]);
+            atexit([] { SdlStats::instance().flushCsv(); });
+        }
+    }
     gameInstance->run();
-    return 0;
\ No newline at end of file
+    return 0;
+}
+#endif
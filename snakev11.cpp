@@ -1,6 +1,8 @@
 #include <emscripten/emscripten.h>
 #include <SDL2/SDL.h>
+#ifndef SNAKE_NO_TTF
 #include <SDL2/SDL_ttf.h>
+#endif
 #include <vector>
 #include <cstdlib>
 #include <ctime>
@@ -9,18 +11,68 @@
 #include <array>
 #include <iostream>
 #include <cmath>
+#include "sdl_stats.h"
+#include "alloc_tracker.h"
+#include "quality_governor.h"
+#include "render_commands.h"
+#include "soft_raster.h"
+#include "frame_capture.h"
+#include "profiler_overlay.h"
+#include "autopilot.h"
+#include "input_latency.h"
+#include "asset_pack.h"
+#include "score_store.h"
+#include "io_service.h"
+#include "snake_replay.h"
+#include "leaderboard_client.h"
+#include "level.h"
+#include "startup_stages.h"
+#include <fstream>
 
 const int windowWidth = 800;
 const int windowHeight = 600;
 const int gridSize = 20;
-const int initialSnakeLength = 4;
-const float snakeSpeed = 0.1f;  // Seconds per grid move
-const int initialObstacleCount = 5;
 const int countdownTime = 3;
 const int maxHighScores = 10;
 
 enum Direction { Up, Down, Left, Right };
 
+// The window holds the classic board (level.h), the one the leaderboard server replays rounds on
+static_assert(windowWidth / gridSize == SnakeRules::columns && windowHeight / gridSize == SnakeRules::rows, "board size");
+
+// Turns pressed since the last tick, applied one per tick. Each press is checked against the
+// turn queued before it rather than the current direction, so Up then Left inside one tick
+// makes both turns, and a quick double press can't fold the snake back into its neck.
+struct TurnQueue {
+    enum PushResult { Queued, Ignored, Full };
+    static const int capacity = 3;
+
+    Direction turns[capacity];
+    int count = 0;
+
+    static bool opposite(Direction a, Direction b) {
+        return (a == Up && b == Down) || (a == Down && b == Up) || (a == Left && b == Right) || (a == Right && b == Left);
+    }
+
+    PushResult push(Direction d, Direction current) {
+        Direction last = count ? turns[count - 1] : current;
+        if (d == last || opposite(d, last)) return Ignored;
+        if (count == capacity) return Full;
+        turns[count++] = d;
+        return Queued;
+    }
+
+    bool pop(Direction& d) {
+        if (!count) return false;
+        d = turns[0];
+        for (int i = 1; i < count; ++i) turns[i - 1] = turns[i];
+        count--;
+        return true;
+    }
+
+    void clear() { count = 0; }
+};
+
 // Forward declaration for Emscripten callback
 void mainLoop(void* arg);
 
@@ -81,27 +133,37 @@ struct Particle {
 class SnakeGame {
 public:
     SnakeGame() : direction(Right), score(0), gameOver(false), countdown(countdownTime),
-                  obstacleCount(initialObstacleCount), inputActive(false),
+                  obstacleCount(level.initialObstacles), inputActive(false),
                   timeSinceLastMove(0.0f), interp(0.0f)
     {
         SDL_Init(SDL_INIT_VIDEO);
-        TTF_Init();
         window = SDL_CreateWindow("Snake Game", SDL_WINDOWPOS_CENTERED, SDL_WINDOWPOS_CENTERED, windowWidth, windowHeight, SDL_WINDOW_SHOWN);
         renderer = SDL_CreateRenderer(window, -1, SDL_RENDERER_ACCELERATED | SDL_RENDERER_PRESENTVSYNC);
-        font = TTF_OpenFont("arial.ttf", 24);
-        if (!font) {
-            std::cerr << "Failed to load font\n";
-            exit(EXIT_FAILURE);
+        if (!renderer) {
+            // Headless drivers (SDL_VIDEODRIVER=dummy) only offer the software renderer
+            renderer = SDL_CreateRenderer(window, -1, 0);
         }
+        font = nullptr;
+        TraceRecorder::instance().setThreadName("main");
+        IoService::instance();  // Started before any atexit flush is registered, so it outlives them
         srand((unsigned)time(0));
+        scoreStore.mount();
         loadHighScores();
         resetGame();
+        addStartupStages();  // snake.pak and the font load from the main loop
     }
 
     ~SnakeGame() {
-        saveHighScores();
-        TTF_CloseFont(font);
-        TTF_Quit();
+        backgroundCache.release();
+        if (softTexture) SDL_DestroyTexture(softTexture);
+        delete softRaster;
+        bitmapFont.release();
+#ifndef SNAKE_NO_TTF
+        if (font) {
+            TTF_CloseFont(font);
+            TTF_Quit();
+        }
+#endif
         SDL_DestroyRenderer(renderer);
         SDL_DestroyWindow(window);
         SDL_Quit();
@@ -112,27 +174,195 @@ public:
     }
 
     void mainLoopStep() {
-        static Uint32 lastTick = SDL_GetTicks();
-        Uint32 currentTick = SDL_GetTicks();
+        IoService::instance().poll();
+        if (!startup.done() && !runStartup()) return;
+        if (stress.active()) {
+            stressStep();
+            return;
+        }
+        Profiler::instance().beginFrame();
+        AllocTracker::instance().beginFrame();
+        if (!highScoresLoaded && scoreStore.ready()) loadHighScores();  // The browser's copy arrives asynchronously
+        leaderboard.poll();
+        if (leaderboard.takeTop(serverTable)) {
+            serverTableArrived = true;
+            showHighScores();
+        }
+        static Uint32 lastTick = clockMs();
+        if (fixedStepMs > 0.0) simTimeMs += fixedStepMs;
+        Uint32 currentTick = clockMs();
         float deltaTime = (currentTick - lastTick) / 1000.0f;
         lastTick = currentTick;
+        quality.addFrameTime(deltaTime * 1000.0f);
 
         handleInput();
+        applyScriptedInput();
         update(deltaTime);
         render();
+        frameNumber++;
+        // Gameplay frames past the warm-up, when every buffer has reached its working size
+        playingFrames = !gameOver && countdown <= 0 ? playingFrames + 1 : 0;
+        AllocTracker::instance().endFrame(playingFrames > allocWarmupFrames);
+        Profiler::instance().endFrame();
+        sdlStatsEndFrame();
+    }
+
+    // Loads everything now instead of from the main loop, for tools that draw without it
+    void finishStartup() {
+        while (startup.run()) {}
+    }
+
+    // Quality tier API (see quality_governor.h). Pass -1 to return to automatic control.
+    int qualityTier() const { return quality.tier(); }
+    void forceQualityTier(int tier) { quality.forceTier(tier); }
+
+    // Draw frames with the CPU rasterizer (soft_raster.h) instead of SDL draw calls
+    void useSoftwareRenderer(int threads) {
+        softRaster = new SoftRasterizer(threads);
+        softRaster->setFont(font);  // Until the font stage has run these are unset; it fills them in
+        if (!bitmapFont.faces.empty()) softRaster->setBitmapFont(&bitmapFont, 24);
+        softFrame.resize(windowWidth, windowHeight);
+        softTexture = SDL_CreateTexture(renderer, SDL_PIXELFORMAT_RGBA32, SDL_TEXTUREACCESS_STREAMING, windowWidth, windowHeight);
+    }
+
+    // Print the average cost of executing the frame's render commands every few seconds
+    void enableRenderStats() { reportRenderCost = true; }
+
+    // Frame profiler overlay, also toggled with F3
+    void showProfiler(bool on) { profilerOverlay.setVisible(on); }
+
+    // Trace-event recording (F8 starts, and stops with a flush); also flushed at every game over
+    void recordTrace(bool on, const std::string& path = "snake_trace.json") {
+        traceFile = path;
+        TraceRecorder::instance().setRecording(on);
+    }
+
+    // Heap allocations in steady gameplay frames (builds with -DSNAKE_TRACK_ALLOCS): logged
+    // with their call sites, or fatal when abortOnAlloc is set
+    void checkAllocations(bool abortOnAlloc) {
+        if (!AllocTracker::compiledIn()) std::cerr << "alloc: build with -DSNAKE_TRACK_ALLOCS to track allocations\n";
+        AllocTracker::instance().setCaptureStacks(true);
+        AllocTracker::instance().setSteadyPolicy(abortOnAlloc ? AllocTracker::SteadyAbort : AllocTracker::SteadyLog);
+    }
+
+    // Soak test: the autopilot plays back to back games at an uncapped tick rate, rendering
+    // every renderEvery-th tick (0 = never), with each game topped up to `obstacles` obstacles
+    void startStress(double seconds, int renderEvery, int obstacles, double logSeconds) {
+        stressRenderEvery = renderEvery;
+        stressObstacles = obstacles;
+        countdown = 0;
+        stress.start(seconds, logSeconds);
+    }
+
+    // One CSV row per turn (queue, tick wait, display and total ms), written by flushLatency()
+    void recordLatency(const std::string& path) { inputLatency.recordCsv(path); }
+    void flushLatency() { inputLatency.flushCsv(); }
+
+    // Drained here, written on the I/O thread
+    void flushTrace() {
+        std::string json;
+        size_t events = TraceRecorder::instance().drain(json);
+        std::string file = traceFile;
+        exportFileAsync(file.c_str(), std::move(json), "application/json", [events, file](bool ok) {
+            if (ok) std::cout << "trace: " << events << " events written to " << file << "\n";
+        });
+    }
+
+    // Advance the game clock by exactly stepMs per frame instead of following wall time
+    void useFixedTimeStep(double stepMs) {
+        fixedStepMs = stepMs;
+        simTimeMs = 0.0;
+        startTime = clockMs();  // Restart the countdown on the new clock
+    }
+
+    // Restart the round from a known random seed
+    void reseed(unsigned seed) {
+        srand(seed);
+        resetGame();
+    }
+
+    // Scripted turns, one "<frame> <U|D|L|R>" pair per line
+    bool loadInputScript(const std::string& path) {
+        std::ifstream in(path);
+        if (!in) return false;
+        int frame;
+        char dir;
+        while (in >> frame >> dir) {
+            Direction d = dir == 'U' ? Up : dir == 'D' ? Down : dir == 'L' ? Left : Right;
+            scriptedTurns.push_back({ frame, d });
+        }
+        return true;
+    }
+
+    // Play on a level (level.h, text or compiled), starting a new round; the board has to fit
+    // the window. Everything the rounds need is placed here, so restarting stays instant. The
+    // web build finds its levels in snake.pak, native runs fall back to the file.
+    bool useLevel(const std::string& path) {
+        Level loaded;
+        std::string error;
+        std::vector<Uint8> data;
+        bool packed = (assets.isOpen() || assets.open("snake.pak")) && assets.load(path, data);
+        if (packed ? !loaded.read(data.data(), data.size(), error) : !loaded.load(path.c_str(), error)) {
+            std::cerr << "level: " << path << ": " << error << "\n";
+            return false;
+        }
+        if (loaded.columns * gridSize > windowWidth || loaded.rows * gridSize > windowHeight) {
+            std::cerr << "level: " << path << ": the board is bigger than " << windowWidth / gridSize << "x" << windowHeight / gridSize << "\n";
+            return false;
+        }
+        level = std::move(loaded);
+        boardWidth = level.columns * gridSize;
+        boardHeight = level.rows * gridSize;
+        boardLeft = (windowWidth / gridSize - level.columns) / 2 * gridSize;
+        boardTop = (windowHeight / gridSize - level.rows) / 2 * gridSize;
+        secondsPerMove = level.moveMs / 1000.0f;
+        walls.clear();
+        for (Uint16 cell : level.solidCells()) {
+            walls.emplace_back((float)(boardLeft + cell % level.columns * gridSize), (float)(boardTop + cell / level.columns * gridSize));
+        }
+        autopilot = Autopilot(level.columns, level.rows, gridSize, level.wrap);
+        if (!level.isClassic()) std::cerr << "level: \"" << level.name << "\" isn't the classic rules, so its scores stay local\n";
+        showHighScores();
+        resetGame();
+        return true;
+    }
+
+    // Send finished rounds to leaderboard_server and show its table instead of the local one
+    bool useLeaderboard(const std::string& url) {
+        if (!leaderboard.setServer(url)) return false;
+        leaderboard.requestTop(maxHighScores);
+        return true;
+    }
+
+    // Write every rendered frame to disk, stopping the main loop after maxFrames (0 = never)
+    bool startCapture(const std::string& prefix, CaptureFormat format, int maxFrames) {
+        captureFrameLimit = maxFrames;
+        return capture.open(prefix, format, windowWidth, windowHeight);
     }
 
 private:
     SDL_Window* window;
     SDL_Renderer* renderer;
     TTF_Font* font;
+    AssetPack assets;
+    std::vector<Uint8> fontData;  // TTF reads glyphs from this for as long as the font is open
+    StartupStages startup;
+    bool loadingShown = false;
+    BitmapFont bitmapFont;        // Baked atlas from font_baker, used instead of TTF when present
 
     std::vector<SnakeSegment> snake;
     std::vector<Apple> apples;
     std::vector<Obstacle> obstacles;
     std::vector<Particle> particles;
 
+    // The board and rules (level.h); a smaller board is centred in the window
+    Level level;
+    std::vector<Obstacle> walls;  // The level's fixed layout, placed once when it's loaded
+    int boardLeft = 0, boardTop = 0, boardWidth = windowWidth, boardHeight = windowHeight;
+    float secondsPerMove = level.moveMs / 1000.0f;
+
     Direction direction;
+    TurnQueue turnQueue;
     int score;
     bool gameOver;
     int countdown;
@@ -140,7 +370,16 @@ private:
     int obstacleCount;
     bool inputActive;
     std::string username;
-    std::array<HighScore, maxHighScores> highScores;
+    std::array<HighScore, maxHighScores> highScores;   // The table on screen: the server's or localScores
+    std::array<HighScore, maxHighScores> localScores;  // highscores.bin, for rounds the server doesn't take
+    ScoreStore scoreStore{ "highscores.bin" };
+    bool highScoresLoaded = false;
+    // Rounds are recorded for the leaderboard server, which then owns the classic table when one is set
+    SnakeRandom spawnRandom;
+    SnakeReplay replay;
+    LeaderboardClient leaderboard;
+    std::vector<ScoreRecord> serverTable;
+    bool serverTableArrived = false;
 
     // Timing
     float timeSinceLastMove;
@@ -149,26 +388,192 @@ private:
     // Movement tracking for interpolation
     std::vector<SDL_Point> lastPositions;
 
+    // Adaptive quality
+    QualityGovernor quality;
+    BackgroundCache backgroundCache;
+
+    // Frame command recording; F9 dumps the next frame's commands to frame.rcb
+    RenderCommandBuffer commands;
+    RenderCommandBuffer backgroundCommands;
+    SdlRenderBackend renderBackend;
+    bool dumpNextFrame = false;
+    ProfilerOverlay profilerOverlay;
+    InputLatency inputLatency;  // Key press to presented frame, shown with the profiler overlay
+    std::string traceFile = "snake_trace.json";
+
+    // Optional CPU rendering path and render cost reporting
+    SoftRasterizer* softRaster = nullptr;
+    SoftFramebuffer softFrame;
+    SDL_Texture* softTexture = nullptr;
+    bool reportRenderCost = false;
+    double renderCostMs = 0.0;
+    int renderCostFrames = 0;
+
+    // Deterministic runs: simulated clock, scripted input and frame capture
+    double fixedStepMs = 0.0;
+    double simTimeMs = 0.0;
+    int frameNumber = 0;
+    int playingFrames = 0;
+    // Autopilot soak testing
+    Autopilot autopilot{ windowWidth / gridSize, windowHeight / gridSize, gridSize };
+    StressMonitor stress;
+    int stressRenderEvery = 0;
+    int stressObstacles = 0;
+    static const int allocWarmupFrames = 120;
+    std::vector<std::pair<int, Direction>> scriptedTurns;
+    size_t nextScriptedTurn = 0;
+    FrameCapture capture;
+    int captureFrameLimit = 0;
+
+    // Everything that reads snake.pak, run a few ms per frame after the window is up. Both stages
+    // are critical: nothing but the loading bar can be drawn without the font.
+    void addStartupStages() {
+        startup.add("asset pack", true, [this] {
+            if (!assets.isOpen()) assets.open("snake.pak");  // Native runs from the repository may have none
+            return true;
+        });
+        startup.add("font", true, [this] {
+            if (loadBitmapFont()) {
+                bitmapFont.upload(renderer);
+                renderBackend.useBitmapFont(&bitmapFont, 24);
+            } else {
+                font = openFont(24);
+            }
+            if (!font && bitmapFont.faces.empty()) {
+                std::cerr << "Failed to load font\n";
+                exit(EXIT_FAILURE);
+            }
+            renderBackend.init(renderer, font);
+            if (softRaster) {
+                softRaster->setFont(font);
+                if (!bitmapFont.faces.empty()) softRaster->setBitmapFont(&bitmapFont, 24);
+            }
+            return true;
+        });
+    }
+
+    // This frame's share of the startup stages; false while the loading bar is all there is to draw
+    bool runStartup() {
+        startup.run();
+        if (!startup.criticalReady()) {
+            SDL_Event event;
+            while (SDL_PollEvent(&event)) {
+                if (event.type == SDL_QUIT) emscripten_cancel_main_loop();  // Keys wait for the game
+            }
+            renderLoading();
+            loadingShown = true;
+            return false;
+        }
+        if (loadingShown) startTime = clockMs();  // The countdown starts once the game can be drawn
+        loadingShown = false;
+        return true;
+    }
+
+    // Shown until the font is in: a progress bar, nothing that needs text
+    void renderLoading() {
+        SDL_SetRenderDrawColor(renderer, 0, 0, 0, 255);
+        SDL_RenderClear(renderer);
+        SDL_Rect frame = { windowWidth / 4, windowHeight / 2 - 8, windowWidth / 2, 16 };
+        SDL_Rect bar = { frame.x + 2, frame.y + 2, (int)((frame.w - 4) * startup.progress()), frame.h - 4 };
+        SDL_SetRenderDrawColor(renderer, 0, 200, 255, 255);
+        SDL_RenderDrawRect(renderer, &frame);
+        SDL_RenderFillRect(renderer, &bar);
+        SDL_RenderPresent(renderer);
+    }
+
+    // The baked font comes from snake.pak. Builds without SDL_ttf also take a loose
+    // font.atlas; with TTF available, native runs keep rendering arial.ttf.
+    bool loadBitmapFont() {
+        std::vector<Uint8> data;
+        if ((assets.isOpen() || assets.open("snake.pak")) && assets.load("font.atlas", data)) return bitmapFont.parse(data);
+#ifdef SNAKE_NO_TTF
+        std::ifstream in("font.atlas", std::ios::binary);
+        data.assign(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+        return bitmapFont.parse(data);
+#else
+        return false;
+#endif
+    }
+
+    // The web build ships only snake.pak (built from assets.txt); native runs from the
+    // repository fall back to the loose file
+    TTF_Font* openFont(int size) {
+#ifdef SNAKE_NO_TTF
+        (void)size;
+        return nullptr;
+#else
+        TTF_Init();
+        if (assets.isOpen() || assets.open("snake.pak")) {
+            if (fontData.empty() && !assets.load("arial.ttf", fontData)) fontData.clear();
+            if (!fontData.empty()) return TTF_OpenFontRW(SDL_RWFromConstMem(fontData.data(), (int)fontData.size()), 1, size);
+        }
+        return TTF_OpenFont("arial.ttf", size);
+#endif
+    }
+
+    Uint32 clockMs() const {
+        return fixedStepMs > 0.0 ? (Uint32)simTimeMs : SDL_GetTicks();
+    }
+
+    void applyScriptedInput() {
+        while (nextScriptedTurn < scriptedTurns.size() && scriptedTurns[nextScriptedTurn].first <= frameNumber) {
+            Direction d = scriptedTurns[nextScriptedTurn++].second;
+            if (!gameOver && !TurnQueue::opposite(d, direction)) direction = d;
+        }
+    }
+
     void loadHighScores() {
-        // Initialize high scores with empty entries
+        std::vector<ScoreRecord> records;
+        if (scoreStore.ready()) {
+            scoreStore.load(records);
+            highScoresLoaded = true;
+        }
+        fillHighScores(localScores, records);
+        showHighScores();
+    }
+
+    // The server owns the scores of classic rounds once one is set; other levels keep theirs here
+    bool serverTakesScores() const { return leaderboard.enabled() && level.isClassic(); }
+
+    // Before the server's first table arrives, the local one stays up
+    void showHighScores() {
+        if (serverTakesScores() && serverTableArrived) fillHighScores(highScores, serverTable);
+        else if (!serverTakesScores()) highScores = localScores;
+    }
+
+    // Empty entries, then the records
+    static void fillHighScores(std::array<HighScore, maxHighScores>& table, const std::vector<ScoreRecord>& records) {
         for (int i = 0; i < maxHighScores; ++i) {
-            highScores[i].username = "---";
-            highScores[i].score = 0;
+            table[i].username = "---";
+            table[i].score = 0;
+        }
+        for (size_t i = 0; i < records.size() && i < (size_t)maxHighScores; ++i) {
+            table[i].username = records[i].name;
+            table[i].score = records[i].score;
         }
     }
 
+    // Written as soon as a score goes in, so nothing is lost if the tab or process dies later
     void saveHighScores() {
-        // In a web environment, we can't save to file
-        // This would need to be implemented with localStorage or similar
+        if (!highScoresLoaded) return;  // Don't replace a table we haven't read yet
+        std::vector<ScoreRecord> records;
+        for (const HighScore& hs : localScores) records.push_back({ hs.username, hs.score });
+        scoreStore.saveAsync(records);
     }
 
     void saveHighScore() {
         if (username.empty()) username = "Anonymous";
+        if (serverTakesScores()) {
+            // The server checks the round and sends back the new table
+            replay.name = username;
+            leaderboard.submit(replay);
+            return;
+        }
         
         // Find position to insert new score
         int insertPos = -1;
         for (int i = 0; i < maxHighScores; ++i) {
-            if (score > highScores[i].score) {
+            if (score > localScores[i].score) {
                 insertPos = i;
                 break;
             }
@@ -177,47 +582,80 @@ private:
         if (insertPos != -1) {
             // Shift scores down
             for (int i = maxHighScores - 1; i > insertPos; --i) {
-                highScores[i] = highScores[i - 1];
+                localScores[i] = localScores[i - 1];
             }
             
             // Insert new score
-            highScores[insertPos].username = username;
-            highScores[insertPos].score = score;
+            localScores[insertPos].username = username;
+            localScores[insertPos].score = score;
+            saveHighScores();
+            showHighScores();
         }
     }
 
     void resetGame() {
         snake.clear();
         lastPositions.clear();
-        for (int i = 0; i < initialSnakeLength; ++i) {
-            snake.emplace_back(gridSize * i, 0);
-            lastPositions.push_back({ gridSize * i, 0 });
+        // Obstacles and apples come from a per-round seed so the round can be replayed exactly
+        Uint32 roundSeed = ((Uint32)rand() << 16) ^ (Uint32)rand();
+        spawnRandom.reseed(roundSeed);
+        replay.start(roundSeed);
+        for (int i = 0; i < level.initialLength; ++i) {
+            snake.emplace_back(boardLeft + gridSize * i, boardTop);
+            lastPositions.push_back({ boardLeft + gridSize * i, boardTop });
         }
         direction = Right;
+        turnQueue.clear();
+        inputLatency.clearPending();
         timeSinceLastMove = 0.0f;
         interp = 0.0f;
         score = 0;
         gameOver = false;
         countdown = countdownTime;
-        startTime = SDL_GetTicks();
+        startTime = clockMs();
         apples.clear();
         obstacles.clear();
         particles.clear();
-        obstacleCount = initialObstacleCount;
+        obstacleCount = level.initialObstacles;
         spawnObstacles();
         spawnApple();
     }
 
     void spawnApple() {
+        PROFILE_ZONE("spawn");
         float x, y;
         do {
-            x = (rand() % (windowWidth / gridSize)) * gridSize;
-            y = (rand() % (windowHeight / gridSize)) * gridSize;
+            randomCell(x, y);
         } while (isPositionOccupied(x, y));
         apples.emplace_back(x, y);
     }
 
+    static bool turnFromKey(SDL_Keycode key, Direction& d) {
+        switch (key) {
+            case SDLK_UP: d = Up; return true;
+            case SDLK_DOWN: d = Down; return true;
+            case SDLK_LEFT: d = Left; return true;
+            case SDLK_RIGHT: d = Right; return true;
+            default: return false;
+        }
+    }
+
+    // Column first, then row: the order SnakeSim draws them in
+    void randomCell(float& x, float& y) {
+        x = (float)(boardLeft + spawnRandom.below(level.columns) * gridSize);
+        y = (float)(boardTop + spawnRandom.below(level.rows) * gridSize);
+    }
+
+    int cellAt(float x, float y) const {
+        return ((int)y - boardTop) / gridSize * level.columns + ((int)x - boardLeft) / gridSize;
+    }
+
+    bool onBoard(float x, float y) const {
+        return x >= boardLeft && x < boardLeft + boardWidth && y >= boardTop && y < boardTop + boardHeight;
+    }
+
     bool isPositionOccupied(float x, float y) {
+        if (level.solid(cellAt(x, y))) return true;
         SDL_Rect testRect = { (int)x, (int)y, gridSize, gridSize };
         for (const auto& seg : snake) {
             if (SDL_HasIntersection(&testRect, &seg.rect)) return true;
@@ -235,14 +673,14 @@ private:
         for (int i = 0; i < obstacleCount; ++i) {
             float x, y;
             do {
-                x = (rand() % (windowWidth / gridSize)) * gridSize;
-                y = (rand() % (windowHeight / gridSize)) * gridSize;
+                randomCell(x, y);
             } while (isPositionOccupied(x, y));
             obstacles.emplace_back(x, y);
         }
     }
 
     void handleInput() {
+        PROFILE_ZONE("input");
         SDL_Event event;
         while (SDL_PollEvent(&event)) {
             if (event.type == SDL_QUIT) {
@@ -250,6 +688,22 @@ private:
                 return;
             }
 
+            // Capture the next frame's render commands for offline replay
+            if (event.type == SDL_KEYDOWN && event.key.keysym.sym == SDLK_F9) {
+                dumpNextFrame = true;
+                continue;
+            }
+            if (event.type == SDL_KEYDOWN && event.key.keysym.sym == SDLK_F3) {
+                profilerOverlay.toggle();
+                continue;
+            }
+            if (event.type == SDL_KEYDOWN && event.key.keysym.sym == SDLK_F8) {
+                bool recording = TraceRecorder::instance().isRecording();
+                if (recording) flushTrace();
+                recordTrace(!recording, traceFile);
+                continue;
+            }
+
             if (gameOver) {
                 if (inputActive) {
                     if (event.type == SDL_TEXTINPUT) {
@@ -273,29 +727,39 @@ private:
                         }
                     }
                 }
-            } else {
-                const Uint8* state = SDL_GetKeyboardState(NULL);
-                if (state[SDL_SCANCODE_UP] && direction != Down) direction = Up;
-                else if (state[SDL_SCANCODE_DOWN] && direction != Up) direction = Down;
-                else if (state[SDL_SCANCODE_LEFT] && direction != Right) direction = Left;
-                else if (state[SDL_SCANCODE_RIGHT] && direction != Left) direction = Right;
+            } else if (event.type == SDL_KEYDOWN && !event.key.repeat) {
+                Direction d;
+                if (!turnFromKey(event.key.keysym.sym, d)) continue;
+                if (countdown > 0) {
+                    // Nothing moves yet: just pick the starting heading
+                    if (!TurnQueue::opposite(d, direction)) direction = d;
+                    continue;
+                }
+                inputLatency.keyDown(event.key.timestamp);
+                TurnQueue::PushResult result = turnQueue.push(d, direction);
+                if (result == TurnQueue::Full) inputLatency.dropped();
+                else inputLatency.queued(result == TurnQueue::Queued, turnQueue.count);
             }
         }
     }
 
     void update(float deltaTime) {
+        PROFILE_ZONE("update");
         if (gameOver) return;
 
-        Uint32 now = SDL_GetTicks();
+        Uint32 now = clockMs();
         if (countdown > 0) {
             countdown = countdownTime - (now - startTime) / 1000;
             return;
         }
 
         timeSinceLastMove += deltaTime;
-        interp = timeSinceLastMove / snakeSpeed;
+        interp = timeSinceLastMove / secondsPerMove;
 
-        if (timeSinceLastMove >= snakeSpeed) {
+        if (timeSinceLastMove >= secondsPerMove) {
+            PROFILE_ZONE("tick");
+            if (turnQueue.pop(direction)) inputLatency.tick();
+            replay.tick(direction);
             moveSnake();
             checkCollisions();
             timeSinceLastMove = 0.0f;
@@ -335,11 +799,13 @@ private:
             case Right: snake[0].x += gridSize; break;
         }
 
-        // Wrap around screen
-        if (snake[0].x < 0) snake[0].x = windowWidth - gridSize;
-        else if (snake[0].x >= windowWidth) snake[0].x = 0;
-        if (snake[0].y < 0) snake[0].y = windowHeight - gridSize;
-        else if (snake[0].y >= windowHeight) snake[0].y = 0;
+        // Wrap around the board; on a walled level the head stays off it and checkCollisions ends the round
+        if (level.wrap) {
+            if (snake[0].x < boardLeft) snake[0].x = boardLeft + boardWidth - gridSize;
+            else if (snake[0].x >= boardLeft + boardWidth) snake[0].x = boardLeft;
+            if (snake[0].y < boardTop) snake[0].y = boardTop + boardHeight - gridSize;
+            else if (snake[0].y >= boardTop + boardHeight) snake[0].y = boardTop;
+        }
 
         for (auto& seg : snake) seg.updateRect();
 
@@ -347,12 +813,13 @@ private:
         for (size_t i = 0; i < apples.size(); ++i) {
             if (SDL_HasIntersection(&snake[0].rect, &apples[i].rect)) {
                 score++;
+                TraceRecorder::instance().instant("apple eaten");
                 addParticles(apples[i].x + gridSize/2, apples[i].y + gridSize/2);
                 apples.erase(apples.begin() + i);
                 spawnApple();
                 growSnake();
-                if (score % 5 == 0) {
-                    // Add an obstacle every 5 points
+                if (level.obstacleEvery > 0 && score % level.obstacleEvery == 0) {
+                    // Add an obstacle every few points (5 on the classic level)
                     addObstacle();
                 }
                 break;
@@ -367,16 +834,23 @@ private:
     }
 
     void addObstacle() {
+        PROFILE_ZONE("obstacle");
+        TraceRecorder::instance().instant("obstacle added");
         float x, y;
         do {
-            x = (rand() % (windowWidth / gridSize)) * gridSize;
-            y = (rand() % (windowHeight / gridSize)) * gridSize;
+            randomCell(x, y);
         } while (isPositionOccupied(x, y));
         obstacles.emplace_back(x, y);
         obstacleCount++;
     }
 
     void checkCollisions() {
+        PROFILE_ZONE("collision");
+        if (!onBoard(snake[0].x, snake[0].y)) {
+            triggerGameOver();
+            return;
+        }
+
         // Collide with self (excluding head)
         for (size_t i = 1; i < snake.size(); ++i) {
             if (snake[0].rect.x == snake[i].rect.x && snake[0].rect.y == snake[i].rect.y) {
@@ -385,7 +859,11 @@ private:
             }
         }
 
-        // Collide with obstacles
+        // Collide with obstacles: the level's layout by cell, the random ones one by one
+        if (level.solid(cellAt(snake[0].x, snake[0].y))) {
+            triggerGameOver();
+            return;
+        }
         for (const auto& obs : obstacles) {
             if (SDL_HasIntersection(&snake[0].rect, &obs.rect)) {
                 triggerGameOver();
@@ -396,49 +874,195 @@ private:
 
     void triggerGameOver() {
         gameOver = true;
+        replay.finish(score);
         inputActive = true;
         SDL_StartTextInput();
+        if (TraceRecorder::instance().isRecording()) {
+            TraceRecorder::instance().instant("game over");
+            flushTrace();
+        }
     }
 
     void addParticles(float x, float y) {
-        for (int i = 0; i < 20; ++i) {
+        int maxParticles = quality.settings().maxParticles;
+        for (int i = 0; i < 20 && (int)particles.size() < maxParticles; ++i) {
             particles.emplace_back(x, y);
         }
     }
 
+    void stressStep() {
+        SDL_Event event;
+        while (SDL_PollEvent(&event)) {
+            if (event.type == SDL_QUIT) {
+                stress.stop();
+                emscripten_cancel_main_loop();
+                return;
+            }
+        }
+
+        // A batch of ticks per main-loop call: up to the next rendered frame, or about one
+        // frame's worth of time when not rendering so the browser stays responsive
+        Uint64 batchStart = SDL_GetPerformanceCounter();
+        Uint64 batchTicks = SDL_GetPerformanceFrequency() / 60;
+        for (int i = 0; stressRenderEvery > 0 ? i < stressRenderEvery : SDL_GetPerformanceCounter() - batchStart < batchTicks; ++i) {
+            stressTick();
+        }
+        if (stressRenderEvery > 0) {
+            Uint64 renderStart = SDL_GetPerformanceCounter();
+            render();
+            stress.frameRendered((SDL_GetPerformanceCounter() - renderStart) * 1000.0 / SDL_GetPerformanceFrequency());
+        }
+
+        bool done = stress.finished();
+        if (stress.logDue() || done) {
+            char state[160];
+            snprintf(state, sizeof(state), "length=%zu score=%d obstacles=%zu apples=%zu particles=%zu", snake.size(), score,
+                     obstacles.size(), apples.size(), particles.size());
+            stress.log(state);
+        }
+        if (done) {
+            stress.stop();
+            emscripten_cancel_main_loop();
+        }
+    }
+
+    void stressTick() {
+        stress.beginTick();
+        if (gameOver) {
+            stress.gameEnded((int)snake.size());
+            resetGame();
+            inputActive = false;
+            SDL_StopTextInput();
+        }
+        if (countdown > 0) {
+            countdown = 0;
+            while ((int)obstacles.size() < stressObstacles) addObstacle();
+        }
+
+        // Everything but the tail blocks; the tail moves out of the way this tick
+        autopilot.clear();
+        // The autopilot's grid is the board, so positions are taken relative to its corner
+        for (size_t i = 0; i + 1 < snake.size(); ++i) autopilot.block(snake[i].x - boardLeft, snake[i].y - boardTop);
+        for (const auto& obs : obstacles) autopilot.block(obs.x - boardLeft, obs.y - boardTop);
+        for (const auto& wall : walls) autopilot.block(wall.x - boardLeft, wall.y - boardTop);
+        for (const auto& app : apples) autopilot.target(app.x - boardLeft, app.y - boardTop);
+        int move = autopilot.choose(snake[0].x - boardLeft, snake[0].y - boardTop, (int)snake.size());
+        if (move >= 0) direction = (Direction)move;
+
+        update(secondsPerMove);
+        stress.endTick();
+    }
+
     void render() {
+        PROFILE_ZONE("render");
+        // Record the frame into the command buffer; the backend sorts, batches and submits it
+        commands.clear();
+
         // Background with subtle moving wave pattern
         renderBackground();
 
-        // Render obstacles with pattern and glow
-        for (const auto& obs : obstacles) {
-            renderObstacle(obs);
-        }
+        {
+            PROFILE_ZONE("world");
+            // Render obstacles with pattern and glow
+            commands.setLayer(LayerWorld);
+            renderBoard();
+            for (const auto& obs : obstacles) {
+                renderObstacle(obs);
+            }
 
-        // Render apples with glow and gradient
-        for (const auto& app : apples) {
-            renderApple(app);
-        }
+            // Render apples with glow and gradient
+            for (const auto& app : apples) {
+                renderApple(app);
+            }
 
-        // Render snake smoothly interpolated
-        renderSnakeSmooth();
+            // Render snake smoothly interpolated
+            renderSnakeSmooth();
+        }
 
         // Render particles
+        commands.setLayer(LayerParticles);
         renderParticles();
 
         // Render UI text with glow
+        commands.setLayer(LayerUI);
         renderUI();
+        profilerOverlay.draw(commands, windowWidth - 380, 40);
+        if (profilerOverlay.isVisible()) {
+            inputLatency.draw(commands, windowWidth - 380, windowHeight - InputLatency::panelHeight - 40);
+        }
 
+        if (dumpNextFrame) {
+            IoService::instance().writeFile("frame.rcb", commands.serialize());
+            dumpNextFrame = false;
+        }
+        Uint64 submitStart = SDL_GetPerformanceCounter();
+        if (softRaster) {
+            softRaster->render(commands, softFrame);
+            if (softTexture) {
+                SDL_UpdateTexture(softTexture, nullptr, softFrame.pixels.data(), softFrame.width * 4);
+                SDL_RenderCopy(renderer, softTexture, nullptr, nullptr);
+            }
+        } else {
+            renderBackend.submit(commands);
+        }
+        if (reportRenderCost) trackRenderCost(SDL_GetPerformanceCounter() - submitStart);
+        if (capture.isOpen()) captureFrame();
+        PROFILE_ZONE("present");
         SDL_RenderPresent(renderer);
+        inputLatency.presented();
+    }
+
+    void captureFrame() {
+        if (softRaster) capture.capture(softFrame.pixels.data());
+        else capture.capture(renderer);
+        if (captureFrameLimit > 0 && capture.framesCaptured() >= captureFrameLimit) {
+            capture.close();
+            emscripten_cancel_main_loop();
+        }
+    }
+
+    void trackRenderCost(Uint64 ticks) {
+        renderCostMs += ticks * 1000.0 / SDL_GetPerformanceFrequency();
+        if (++renderCostFrames < 300) return;
+        if (softRaster) {
+            std::cout << "render: soft x" << softRaster->threadCount() << " " << renderCostMs / renderCostFrames << " ms/frame\n";
+        } else {
+            std::cout << "render: sdl " << renderCostMs / renderCostFrames << " ms/frame, "
+                      << renderBackend.lastCallCount() << " SDL calls\n";
+        }
+        renderCostMs = 0.0;
+        renderCostFrames = 0;
     }
 
     void renderBackground() {
+        PROFILE_ZONE("background");
+        // Lower quality tiers redraw the animated grid into a cached texture every few frames.
+        // The CPU rasterizer can't sample SDL textures, so it always draws the grid directly.
+        int interval = softRaster ? 1 : quality.settings().backgroundInterval;
+        if (backgroundCache.begin(renderer, windowWidth, windowHeight, interval)) {
+            if (backgroundCache.cached()) {
+                backgroundCommands.clear();
+                drawBackground(backgroundCommands);
+                renderBackend.submit(backgroundCommands);
+            } else {
+                drawBackground(commands);
+            }
+        }
+        backgroundCache.finish(renderer);
+        if (backgroundCache.cached()) {
+            commands.setLayer(LayerBackground);
+            commands.sprite(backgroundCache.cached(), { 0, 0, windowWidth, windowHeight });
+        }
+    }
+
+    void drawBackground(RenderCommandBuffer& cmd) {
         // Rich dark blue-purple gradient background reminiscent of 80s arcade games
-        SDL_SetRenderDrawColor(renderer, 8, 16, 48, 255);
-        SDL_RenderClear(renderer);
+        cmd.setLayer(LayerBackground);
+        cmd.clearScreen({ 8, 16, 48, 255 });
 
-        // Animated grid with neon glow effect
-        Uint32 time = SDL_GetTicks();
+        // Animated grid with neon glow effect; cells and dots never overlap, so let the backend regroup them
+        cmd.setLayer(LayerBackground, true);
+        Uint32 time = clockMs();
         for (int i = 0; i < windowWidth; i += gridSize) {
             for (int j = 0; j < windowHeight; j += gridSize) {
                 // Complex wave pattern for retro feel
@@ -447,24 +1071,23 @@ private:
                 int intensity = (int)(25 + 15 * wave1 + 10 * wave2);
                 
                 // Bright cyan/magenta retro colors with grid lines
-                SDL_SetRenderDrawColor(renderer, 0, intensity + 40, intensity + 80, 60);
                 SDL_Rect cell = { i, j, gridSize-1, gridSize-1 };
-                SDL_RenderDrawRect(renderer, &cell);
+                cmd.rect(cell, { 0, (Uint8)(intensity + 40), (Uint8)(intensity + 80), 60 });
                 
                 // Add some glowing dots at grid intersections
                 if ((i/gridSize + j/gridSize) % 4 == 0) {
                     int glowIntensity = (int)(100 + 80 * sin(time / 200.0 + i * 0.1 + j * 0.1));
-                    SDL_SetRenderDrawColor(renderer, 0, glowIntensity, 255, 120);
                     SDL_Rect dot = { i + gridSize/2 - 1, j + gridSize/2 - 1, 3, 3 };
-                    SDL_RenderFillRect(renderer, &dot);
+                    cmd.fillRect(dot, { 0, (Uint8)glowIntensity, 255, 120 });
                 }
             }
         }
         
         // Add scanlines for authentic CRT effect
+        if (!quality.settings().scanlines) return;
+        cmd.setLayer(LayerBackgroundOverlay, true);
         for (int y = 0; y < windowHeight; y += 4) {
-            SDL_SetRenderDrawColor(renderer, 0, 20, 40, 30);
-            SDL_RenderDrawLine(renderer, 0, y, windowWidth, y);
+            cmd.line(0, y, windowWidth, y, { 0, 20, 40, 30 });
         }
     }
 
@@ -473,30 +1096,23 @@ private:
         
         // Bright red metallic obstacle with detailed shading
         // Base metallic red color
-        SDL_SetRenderDrawColor(renderer, 200, 40, 40, 255);
-        SDL_RenderFillRect(renderer, &r);
+        commands.fillRect(r, { 200, 40, 40, 255 });
         
         // Top highlight for 3D effect
-        SDL_SetRenderDrawColor(renderer, 255, 120, 120, 255);
-        SDL_Rect highlight = { r.x, r.y, r.w, 3 };
-        SDL_RenderFillRect(renderer, &highlight);
-        SDL_Rect highlight2 = { r.x, r.y, 3, r.h };
-        SDL_RenderFillRect(renderer, &highlight2);
+        SDL_Color highlightColor = { 255, 120, 120, 255 };
+        commands.fillRect({ r.x, r.y, r.w, 3 }, highlightColor);
+        commands.fillRect({ r.x, r.y, 3, r.h }, highlightColor);
         
         // Bottom shadow for depth
-        SDL_SetRenderDrawColor(renderer, 120, 20, 20, 255);
-        SDL_Rect shadow = { r.x, r.y + r.h - 3, r.w, 3 };
-        SDL_RenderFillRect(renderer, &shadow);
-        SDL_Rect shadow2 = { r.x + r.w - 3, r.y, 3, r.h };
-        SDL_RenderFillRect(renderer, &shadow2);
+        SDL_Color shadowColor = { 120, 20, 20, 255 };
+        commands.fillRect({ r.x, r.y + r.h - 3, r.w, 3 }, shadowColor);
+        commands.fillRect({ r.x + r.w - 3, r.y, 3, r.h }, shadowColor);
         
         // Animated diagonal energy patterns
-        Uint32 time = SDL_GetTicks();
-        SDL_SetRenderDrawColor(renderer, 255, 80, 80, 180);
+        Uint32 time = clockMs();
         for (int i = 0; i < r.w; i += 6) {
             int offset = (int)(4 * sin((time + i * 50) / 300.0));
-            SDL_RenderDrawLine(renderer, r.x + i, r.y + offset, 
-                             r.x + i - r.h/2, r.y + r.h + offset);
+            commands.line(r.x + i, r.y + offset, r.x + i - r.h/2, r.y + r.h + offset, { 255, 80, 80, 180 });
         }
         
         // Bright pulsating outer glow
@@ -504,9 +1120,24 @@ private:
         drawGlow(r.x + r.w/2, r.y + r.h/2, glowSize, 80, {255, 60, 60});
     }
 
+    // The level's walls and, where the board doesn't fill the window or its edges kill, its outline.
+    // Walls are flat: a layout can have hundreds of them.
+    void renderBoard() {
+        for (const auto& wall : walls) {
+            SDL_Rect r = wall.rect;
+            commands.fillRect(r, { 90, 70, 150, 255 });
+            commands.fillRect({ r.x, r.y, r.w, 2 }, { 160, 140, 230, 255 });
+            commands.fillRect({ r.x, r.y + r.h - 2, r.w, 2 }, { 50, 35, 90, 255 });
+        }
+        if (level.wrap && boardWidth == windowWidth && boardHeight == windowHeight) return;
+        SDL_Color edge = level.wrap ? SDL_Color{ 0, 200, 255, 160 } : SDL_Color{ 255, 60, 60, 220 };
+        commands.rect({ boardLeft - 2, boardTop - 2, boardWidth + 4, boardHeight + 4 }, edge);
+        commands.rect({ boardLeft - 1, boardTop - 1, boardWidth + 2, boardHeight + 2 }, edge);
+    }
+
     void renderApple(const Apple& app) {
         SDL_Rect r = app.rect;
-        Uint32 time = SDL_GetTicks();
+        Uint32 time = clockMs();
         
         // Multi-layered radial gradient with bright neon colors
         for (int radius = gridSize/2; radius > 0; radius -= 1) {
@@ -518,13 +1149,12 @@ private:
             int green = (int)(60 + 195 * (1.0f - normalizedRadius) * pulse);
             int blue = (int)(255 * (1.0f - normalizedRadius * 0.7f) * pulse);
             
-            SDL_SetRenderDrawColor(renderer, red, green, blue, 255 - radius * 3);
-            fillCircle(r.x + gridSize/2, r.y + gridSize/2, radius);
+            commands.fillCircle(r.x + gridSize/2, r.y + gridSize/2, radius,
+                                { (Uint8)red, (Uint8)green, (Uint8)blue, (Uint8)(255 - radius * 3) });
         }
         
         // Bright white core highlight
-        SDL_SetRenderDrawColor(renderer, 255, 255, 255, 200);
-        fillCircle(r.x + gridSize/2 - 2, r.y + gridSize/2 - 2, 4);
+        commands.fillCircle(r.x + gridSize/2 - 2, r.y + gridSize/2 - 2, 4, { 255, 255, 255, 200 });
         
         // Sparkling effect with rotating particles
         for (int i = 0; i < 8; i++) {
@@ -532,20 +1162,18 @@ private:
             int sparkX = r.x + gridSize/2 + (int)(12 * cos(angle));
             int sparkY = r.y + gridSize/2 + (int)(12 * sin(angle));
             int sparkIntensity = (int)(150 + 105 * sin(time / 120.0 + i));
-            SDL_SetRenderDrawColor(renderer, 255, sparkIntensity, 255, 180);
-            SDL_Rect spark = { sparkX - 1, sparkY - 1, 3, 3 };
-            SDL_RenderFillRect(renderer, &spark);
+            commands.fillRect({ sparkX - 1, sparkY - 1, 3, 3 }, { 255, (Uint8)sparkIntensity, 255, 180 });
         }
         
         // Intense outer glow with color cycling
         int glowR = (int)(255 * (0.7 + 0.3 * sin(time / 180.0)));
         int glowG = (int)(100 + 155 * sin(time / 220.0 + 1.57));
         int glowB = (int)(255 * (0.7 + 0.3 * cos(time / 160.0)));
-        drawGlow(r.x + gridSize/2, r.y + gridSize/2, 35, 120, {glowR, glowG, glowB});
+        drawGlow(r.x + gridSize/2, r.y + gridSize/2, 35, 120, {(Uint8)glowR, (Uint8)glowG, (Uint8)glowB});
     }
 
     void renderSnakeSmooth() {
-        Uint32 time = SDL_GetTicks();
+        Uint32 time = clockMs();
         
         // Interpolate each segment position between last and current
         for (size_t i = 0; i < snake.size(); ++i) {
@@ -568,22 +1196,17 @@ private:
             Uint8 bCol = (Uint8)(50 + 150 * segmentRatio * pulse);
 
             // Main body with gradient effect
-            SDL_SetRenderDrawColor(renderer, rCol, gCol, bCol, 255);
-            SDL_RenderFillRect(renderer, &r);
+            commands.fillRect(r, { rCol, gCol, bCol, 255 });
             
             // Top highlight for 3D effect
-            SDL_SetRenderDrawColor(renderer, rCol + 80, 255, bCol + 80, 255);
-            SDL_Rect highlight = { r.x, r.y, r.w, 3 };
-            SDL_RenderFillRect(renderer, &highlight);
-            SDL_Rect highlight2 = { r.x, r.y, 3, r.h };
-            SDL_RenderFillRect(renderer, &highlight2);
+            SDL_Color highlightColor = { (Uint8)(rCol + 80), 255, (Uint8)(bCol + 80), 255 };
+            commands.fillRect({ r.x, r.y, r.w, 3 }, highlightColor);
+            commands.fillRect({ r.x, r.y, 3, r.h }, highlightColor);
             
             // Bottom shadow
-            SDL_SetRenderDrawColor(renderer, rCol/2, gCol/2, bCol/2, 255);
-            SDL_Rect shadow = { r.x, r.y + r.h - 3, r.w, 3 };
-            SDL_RenderFillRect(renderer, &shadow);
-            SDL_Rect shadow2 = { r.x + r.w - 3, r.y, 3, r.h };
-            SDL_RenderFillRect(renderer, &shadow2);
+            SDL_Color shadowColor = { (Uint8)(rCol/2), (Uint8)(gCol/2), (Uint8)(bCol/2), 255 };
+            commands.fillRect({ r.x, r.y + r.h - 3, r.w, 3 }, shadowColor);
+            commands.fillRect({ r.x + r.w - 3, r.y, 3, r.h }, shadowColor);
 
             // Special effects for the head
             if (i == 0) {
@@ -593,16 +1216,13 @@ private:
                 
                 // Eyes with glowing effect
                 int eyeGlow = (int)(200 + 55 * sin(time / 80.0));
-                SDL_SetRenderDrawColor(renderer, 255, 255, eyeGlow, 255);
-                SDL_Rect eye1 = { (int)x + 4, (int)y + 4, 4, 4 };
-                SDL_Rect eye2 = { (int)x + 12, (int)y + 4, 4, 4 };
-                SDL_RenderFillRect(renderer, &eye1);
-                SDL_RenderFillRect(renderer, &eye2);
+                SDL_Color eyeColor = { 255, 255, (Uint8)eyeGlow, 255 };
+                commands.fillRect({ (int)x + 4, (int)y + 4, 4, 4 }, eyeColor);
+                commands.fillRect({ (int)x + 12, (int)y + 4, 4, 4 }, eyeColor);
                 
                 // Energy trail effect
                 for (int trail = 1; trail < 5 && i + trail < snake.size(); trail++) {
                     int trailAlpha = 100 - trail * 20;
-                    SDL_SetRenderDrawColor(renderer, rCol, gCol, bCol, trailAlpha);
                     drawGlow(x + gridSize/2, y + gridSize/2, 20 + trail * 3, trailAlpha, {rCol, gCol, bCol});
                 }
             } else {
@@ -613,7 +1233,8 @@ private:
     }
 
     void renderParticles() {
-        Uint32 time = SDL_GetTicks();
+        PROFILE_ZONE("particles");
+        Uint32 time = clockMs();
         for (const auto& p : particles) {
             float lifeRatio = p.life / 0.5f;
             
@@ -623,11 +1244,8 @@ private:
             Uint8 blue = (Uint8)(150 + 105 * lifeRatio * sin(time / 60.0 + p.x * 0.05 + p.y * 0.05));
             Uint8 alpha = (Uint8)(255 * lifeRatio);
             
-            SDL_SetRenderDrawColor(renderer, red, green, blue, alpha);
-            
             // Larger, more visible particles with glow
-            SDL_Rect pr = {(int)p.x - 2, (int)p.y - 2, 5, 5};
-            SDL_RenderFillRect(renderer, &pr);
+            commands.fillRect({ (int)p.x - 2, (int)p.y - 2, 5, 5 }, { red, green, blue, alpha });
             
             // Add small glow around each particle
             if (lifeRatio > 0.3f) {
@@ -636,15 +1254,17 @@ private:
         }
     }
 
+    // Formatted into a stack buffer: gameplay frames must not allocate (--alloc-check)
     void renderUI() {
-        std::stringstream ss;
-        Uint32 time = SDL_GetTicks();
+        PROFILE_ZONE("ui");
+        char line[64];
+        Uint32 time = clockMs();
         
         if (countdown > 0) {
             // Bright pulsating countdown text
             int pulseIntensity = (int)(200 + 55 * sin(time / 100.0));
-            ss << "GET READY: " << countdown + 1;
-            drawTextCentered(ss.str(), windowWidth / 2, windowHeight / 2, {255, pulseIntensity, 255});
+            snprintf(line, sizeof(line), "GET READY: %d", countdown + 1);
+            drawTextCentered(line, windowWidth / 2, windowHeight / 2, {255, pulseIntensity, 255});
             return;
         }
 
@@ -654,7 +1274,8 @@ private:
             drawTextCentered("GAME OVER", windowWidth / 2, windowHeight / 3, {255, flashIntensity, flashIntensity});
             
             // Bright cyan score display
-            drawTextCentered("FINAL SCORE: " + std::to_string(score), windowWidth / 2, windowHeight / 3 + 50, {0, 255, 255});
+            snprintf(line, sizeof(line), "FINAL SCORE: %d", score);
+            drawTextCentered(line, windowWidth / 2, windowHeight / 3 + 50, {0, 255, 255});
             
             if (inputActive) {
                 // Bright yellow input prompt with cursor animation
@@ -671,21 +1292,24 @@ private:
         }
 
         // Bright neon UI elements during gameplay
-        ss << "SCORE: " << score;
-        drawText(ss.str(), 10, 10, {0, 255, 0});
+        snprintf(line, sizeof(line), "SCORE: %d", score);
+        drawText(line, 10, 10, {0, 255, 0});
 
         // Add level indicator
-        int level = score / 5 + 1;
-        std::stringstream levelSS;
-        levelSS << "LEVEL: " << level;
-        drawText(levelSS.str(), 10, 40, {255, 255, 0});
+        int speedLevel = score / 5 + 1;
+        snprintf(line, sizeof(line), "LEVEL: %d", speedLevel);
+        drawText(line, 10, 40, {255, 255, 0});
+
+        // Current quality tier, marked when pinned
+        snprintf(line, sizeof(line), "QUALITY: %s%s", quality.settings().name, quality.isForced() ? "*" : "");
+        drawText(line, windowWidth - 200, 10, {180, 180, 255});
 
         // Bright instruction text
         drawText("USE ARROW KEYS TO MOVE", 10, windowHeight - 30, {0, 200, 255});
     }
 
     void renderHighScores() {
-        Uint32 time = SDL_GetTicks();
+        Uint32 time = clockMs();
         
         // Bright magenta header with pulsing effect
         int headerPulse = (int)(200 + 55 * sin(time / 180.0));
@@ -706,115 +1330,30 @@ private:
         }
     }
 
-    void drawText(const std::string& text, int x, int y, SDL_Color color) {
-        SDL_Surface* surface = TTF_RenderText_Blended(font, text.c_str(), color);
-        if (!surface) return;
-        SDL_Texture* texture = SDL_CreateTextureFromSurface(renderer, surface);
-        SDL_Rect destRect = { x, y, surface->w, surface->h };
+    void drawText(const std::string& text, int x, int y, SDL_Color color) { drawText(text.c_str(), x, y, color); }
+    void drawTextCentered(const std::string& text, int cx, int cy, SDL_Color color) { drawTextCentered(text.c_str(), cx, cy, color); }
 
-        // Draw shadow/glow
-        SDL_Color shadow = { 0, 0, 0, 160 };
-        SDL_Surface* shadowSurface = TTF_RenderText_Blended(font, text.c_str(), shadow);
-        if (shadowSurface) {
-            SDL_Texture* shadowTexture = SDL_CreateTextureFromSurface(renderer, shadowSurface);
-            SDL_Rect shadowRect = { x + 2, y + 2, shadowSurface->w, shadowSurface->h };
-            SDL_RenderCopy(renderer, shadowTexture, NULL, &shadowRect);
-            SDL_DestroyTexture(shadowTexture);
-            SDL_FreeSurface(shadowSurface);
-        }
-
-        SDL_RenderCopy(renderer, texture, NULL, &destRect);
-        SDL_DestroyTexture(texture);
-        SDL_FreeSurface(surface);
+    void drawText(const char* text, int x, int y, SDL_Color color) {
+        // Drop shadow is skipped at the lowest quality tier
+        Uint8 flags = quality.settings().textGlowLayers > 0 ? TextShadow : 0;
+        commands.text(text, strlen(text), x, y, color, flags);
     }
 
-    void drawTextCentered(const std::string& text, int cx, int cy, SDL_Color color) {
-        SDL_Surface* surface = TTF_RenderText_Blended(font, text.c_str(), color);
-        if (!surface) return;
-        SDL_Texture* texture = SDL_CreateTextureFromSurface(renderer, surface);
-        SDL_Rect destRect = { cx - surface->w / 2, cy - surface->h / 2, surface->w, surface->h };
-
-        // Draw shadow/glow
-        SDL_Color shadow = { 0, 0, 0, 160 };
-        SDL_Surface* shadowSurface = TTF_RenderText_Blended(font, text.c_str(), shadow);
-        if (shadowSurface) {
-            SDL_Texture* shadowTexture = SDL_CreateTextureFromSurface(renderer, shadowSurface);
-            SDL_Rect shadowRect = { destRect.x + 2, destRect.y + 2, shadowSurface->w, shadowSurface->h };
-            SDL_RenderCopy(renderer, shadowTexture, NULL, &shadowRect);
-            SDL_DestroyTexture(shadowTexture);
-            SDL_FreeSurface(shadowSurface);
-        }
-
-        SDL_RenderCopy(renderer, texture, NULL, &destRect);
-        SDL_DestroyTexture(texture);
-        SDL_FreeSurface(surface);
+    void drawTextCentered(const char* text, int cx, int cy, SDL_Color color) {
+        Uint8 flags = quality.settings().textGlowLayers > 0 ? TextShadow : 0;
+        commands.text(text, strlen(text), cx, cy, color, flags | TextCentered);
     }
 
     void drawGlow(int cx, int cy, int radius, int alpha, SDL_Color color) {
-        // Enhanced multi-layered glow with color mixing for more realistic lighting
-        for (int r = radius; r > 0; --r) {
-            float intensity = (float)r / radius;
-            Uint8 a = (Uint8)((float)alpha * intensity * intensity); // Quadratic falloff for more realistic glow
-            
-            // Color mixing for more realistic glow effect
-            Uint8 mixedR = (Uint8)(color.r * (0.8 + 0.2 * intensity));
-            Uint8 mixedG = (Uint8)(color.g * (0.8 + 0.2 * intensity));
-            Uint8 mixedB = (Uint8)(color.b * (0.8 + 0.2 * intensity));
-            
-            SDL_SetRenderDrawColor(renderer, mixedR, mixedG, mixedB, a);
-            drawCircle(cx, cy, r);
-            
-            // Add inner bright core for more intensity
-            if (r < radius / 3) {
-                SDL_SetRenderDrawColor(renderer, 255, 255, 255, a / 2);
-                drawCircle(cx, cy, r);
-            }
-        }
-    }
-
-    // Midpoint circle algorithm for outline
-    void drawCircle(int cx, int cy, int radius) {
-        int x = radius - 1;
-        int y = 0;
-        int dx = 1;
-        int dy = 1;
-        int err = dx - (radius << 1);
-
-        while (x >= y) {
-            SDL_RenderDrawPoint(renderer, cx + x, cy + y);
-            SDL_RenderDrawPoint(renderer, cx + y, cy + x);
-            SDL_RenderDrawPoint(renderer, cx - y, cy + x);
-            SDL_RenderDrawPoint(renderer, cx - x, cy + y);
-            SDL_RenderDrawPoint(renderer, cx - x, cy - y);
-            SDL_RenderDrawPoint(renderer, cx - y, cy - x);
-            SDL_RenderDrawPoint(renderer, cx + y, cy - x);
-            SDL_RenderDrawPoint(renderer, cx + x, cy - y);
-
-            if (err <= 0) {
-                y++;
-                err += dy;
-                dy += 2;
-            }
-            if (err > 0) {
-                x--;
-                dx += 2;
-                err += dx - (radius << 1);
-            }
-        }
-    }
-
-    void fillCircle(int cx, int cy, int radius) {
-        for (int y = -radius; y <= radius; y++) {
-            for (int x = -radius; x <= radius; x++) {
-                if (x*x + y*y <= radius*radius) {
-                    SDL_RenderDrawPoint(renderer, cx + x, cy + y);
-                }
-            }
-        }
+        // Enhanced multi-layered glow with color mixing, expanded into rings by the render backend
+        const QualitySettings& qs = quality.settings();
+        commands.glow(cx, cy, (int)(radius * qs.glowScale), qs.glowStep, alpha, color);
     }
 
     // Make mainLoop a friend function or static member accessible to C callback
     friend void ::mainLoop(void* arg);
+    friend struct SimBench;     // sim_bench.cpp drives the simulation methods directly
+    friend struct RenderBench;  // render_bench.cpp times the draw primitives
 };
 
 // Global instance for Emscripten callback
@@ -825,8 +1364,145 @@ void mainLoop(void* arg) {
     game->mainLoopStep();
 }
 
+// Quality tier API for the page: -1 before the game exists, 0 (ULTRA) .. 3 (LOW) otherwise
+extern "C" EMSCRIPTEN_KEEPALIVE int getQualityTier() {
+    return gameInstance ? gameInstance->qualityTier() : -1;
+}
+
+// Pin a quality tier from the page, or pass -1 to hand control back to the governor
+extern "C" EMSCRIPTEN_KEEPALIVE void setQualityTier(int tier) {
+    if (gameInstance) gameInstance->forceQualityTier(tier);
+}
+
+// Start (1) or stop (0) trace-event recording from the page
+extern "C" EMSCRIPTEN_KEEPALIVE void setTraceRecording(int on) {
+    if (gameInstance) gameInstance->recordTrace(on != 0);
+}
+
+// Download everything recorded so far as snake_trace.json
+extern "C" EMSCRIPTEN_KEEPALIVE void flushTrace() {
+    if (gameInstance) gameInstance->flushTrace();
+}
+
+// Start collecting per-frame SDL call counts; downloadSdlStats() then saves them as CSV
+extern "C" EMSCRIPTEN_KEEPALIVE void recordSdlStats() {
+    SdlStats::instance().recordCsv("sdl_stats.csv");
+}
+
+extern "C" EMSCRIPTEN_KEEPALIVE void downloadSdlStats() {
+    SdlStats::instance().flushCsv();
+}
+
+// Start collecting per-turn input latency; downloadInputLatency() then saves it as CSV
+extern "C" EMSCRIPTEN_KEEPALIVE void recordInputLatency() {
+    if (gameInstance) gameInstance->recordLatency("input_latency.csv");
+}
+
+extern "C" EMSCRIPTEN_KEEPALIVE void downloadInputLatency() {
+    if (gameInstance) gameInstance->flushLatency();
+}
+
+// Heap allocations made by the last frame (0 unless built with -DSNAKE_TRACK_ALLOCS)
+extern "C" EMSCRIPTEN_KEEPALIVE int getFrameAllocations() {
+    return (int)AllocTracker::instance().lastFrame().allocations;
+}
+
+// Start an autopilot soak test from the page; progress is logged to the console
+extern "C" EMSCRIPTEN_KEEPALIVE void startStress(double seconds, int renderEvery, int obstacles) {
+    if (gameInstance) gameInstance->startStress(seconds, renderEvery, obstacles, 10.0);
+}
+
+// Submit rounds to a leaderboard_server at url (e.g. "http://127.0.0.1:8765") and show its table
+extern "C" EMSCRIPTEN_KEEPALIVE void setLeaderboardServer(const char* url) {
+    if (gameInstance) gameInstance->useLeaderboard(url);
+}
+
+// Switch to a level file in the page's file system; 0 if it can't be used
+extern "C" EMSCRIPTEN_KEEPALIVE int loadLevel(const char* path) {
+    return gameInstance && gameInstance->useLevel(path) ? 1 : 0;
+}
+
+// Show or hide the frame profiler overlay from the page
+extern "C" EMSCRIPTEN_KEEPALIVE void setProfilerOverlay(int visible) {
+    if (gameInstance) gameInstance->showProfiler(visible != 0);
+}
+
+// Tools that include this file for its SnakeGame (sim_bench.cpp, render_bench.cpp) define SNAKE_NO_MAIN
+#ifndef SNAKE_NO_MAIN
 int main(int argc, char* argv[]) {
+    struct { std::string prefix; CaptureFormat format = CapturePNG; int frames = 600; } captureArgs;
+    struct { bool enabled = false; double seconds = 0.0; int renderEvery = 0; int obstacles = 0; double logSeconds = 10.0; } stressArgs;
     gameInstance = new SnakeGame();
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg.compare(0, 6, "--soft") == 0) {
+            // --soft or --soft=THREADS (0 = one per core)
+            gameInstance->useSoftwareRenderer(arg.size() > 7 ? atoi(arg.c_str() + 7) : 0);
+            gameInstance->enableRenderStats();
+        } else if (arg == "--render-stats") {
+            gameInstance->enableRenderStats();
+        } else if (arg == "--profile") {
+            gameInstance->showProfiler(true);
+        } else if (arg == "--trace" && i + 1 < argc) {
+            // Native runs end by exiting from the main loop, so flush on the way out
+            gameInstance->recordTrace(true, argv[++i]);
+            atexit([] {
+                gameInstance->flushTrace();
+                IoService::instance().flush();
+            });
+        } else if (arg == "--sdl-stats" && i + 1 < argc) {
+            // One CSV row of SDL call counts per frame, written on exit
+            SdlStats::instance().recordCsv(argv[++i]);
+            atexit([] { SdlStats::instance().flushCsv(); });
+        } else if (arg == "--latency-csv" && i + 1 < argc) {
+            // Per-turn input latency, written on exit
+            gameInstance->recordLatency(argv[++i]);
+            atexit([] { gameInstance->flushLatency(); });
+        } else if (arg == "--alloc-check") {
+            gameInstance->checkAllocations(true);
+        } else if (arg == "--alloc-log") {
+            gameInstance->checkAllocations(false);
+        } else if (arg == "--stress" && i + 1 < argc) {
+            // --stress SECONDS (0 = until closed) [--stress-render N] [--stress-obstacles N] [--stress-log SECONDS]
+            stressArgs.seconds = atof(argv[++i]);
+            stressArgs.enabled = true;
+        } else if (arg == "--stress-render" && i + 1 < argc) {
+            stressArgs.renderEvery = atoi(argv[++i]);
+        } else if (arg == "--stress-obstacles" && i + 1 < argc) {
+            stressArgs.obstacles = atoi(argv[++i]);
+        } else if (arg == "--stress-log" && i + 1 < argc) {
+            stressArgs.logSeconds = atof(argv[++i]);
+        } else if (arg == "--leaderboard" && i + 1 < argc) {
+            // --leaderboard http://127.0.0.1:8765 (see leaderboard_server.cpp)
+            if (!gameInstance->useLeaderboard(argv[++i])) std::cerr << "Failed to set leaderboard server\n";
+        } else if (arg == "--level" && i + 1 < argc) {
+            // --level FILE: levels/*.txt, or compiled with level_compiler
+            if (!gameInstance->useLevel(argv[++i])) std::cerr << "Failed to load level\n";
+        } else if (arg == "--seed" && i + 1 < argc) {
+            gameInstance->reseed((unsigned)atol(argv[++i]));
+        } else if (arg == "--fixed-step" && i + 1 < argc) {
+            gameInstance->useFixedTimeStep(atof(argv[++i]));
+        } else if (arg == "--input" && i + 1 < argc) {
+            if (!gameInstance->loadInputScript(argv[++i])) std::cerr << "Failed to load input script\n";
+        } else if (arg == "--capture" && i + 1 < argc) {
+            // --capture PREFIX [--capture-raw] [--capture-frames N]; implies a 60 Hz fixed step
+            captureArgs.prefix = argv[++i];
+        } else if (arg == "--capture-raw") {
+            captureArgs.format = CaptureRaw;
+        } else if (arg == "--capture-frames" && i + 1 < argc) {
+            captureArgs.frames = atoi(argv[++i]);
+        }
+    }
+    if (!captureArgs.prefix.empty()) {
+        gameInstance->useFixedTimeStep(1000.0 / 60.0);
+        if (!gameInstance->startCapture(captureArgs.prefix, captureArgs.format, captureArgs.frames)) {
+            std::cerr << "Failed to start capture\n";
+        }
+    }
+    if (stressArgs.enabled) {
+        gameInstance->startStress(stressArgs.seconds, stressArgs.renderEvery, stressArgs.obstacles, stressArgs.logSeconds);
+    }
     gameInstance->run();
     return 0;
-}
\ No newline at end of file
+}
+#endif
@@ -0,0 +1,413 @@
+#pragma once
+#include <SDL2/SDL.h>
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <algorithm>
+#include <cmath>
+#include "render_commands.h"
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+// CPU rendering backend. Executes the same RenderCommandBuffer as SdlRenderBackend into a
+// plain RGBA framebuffer, so frames can be drawn and timed on machines without a GPU or
+// browser. The screen is cut into tiles and worker threads rasterize tiles in parallel;
+// each worker replays the whole (sorted) command list clipped to its tile, so draw order
+// is preserved without any locking.
+
+// Pixels are stored as SDL_PIXELFORMAT_RGBA32: bytes R, G, B, A in memory order
+struct SoftFramebuffer {
+    int width = 0;
+    int height = 0;
+    std::vector<Uint32> pixels;
+
+    void resize(int w, int h) {
+        width = w;
+        height = h;
+        pixels.assign((size_t)w * h, 0);
+    }
+    Uint32* row(int y) { return pixels.data() + (size_t)y * width; }
+};
+
+inline Uint32 packRGBA(SDL_Color c) {
+    return (Uint32)c.r | ((Uint32)c.g << 8) | ((Uint32)c.b << 16) | ((Uint32)c.a << 24);
+}
+
+// Span primitives. fillSpan overwrites (SDL_BLENDMODE_NONE), blendSpan composites
+// a constant colour over the destination (SDL_BLENDMODE_BLEND).
+inline void fillSpan(Uint32* dst, int count, Uint32 color) {
+    int i = 0;
+#if defined(__SSE2__)
+    __m128i c = _mm_set1_epi32((int)color);
+    for (; i + 4 <= count; i += 4) _mm_storeu_si128((__m128i*)(dst + i), c);
+#endif
+    for (; i < count; ++i) dst[i] = color;
+}
+
+inline Uint32 blendPixel(Uint32 d, Uint32 s, Uint32 a) {
+    // RGB: (s * a + d * (255 - a) + 128) >> 8, alpha: a + da * (255 - a) / 256
+    Uint32 inv = 255 - a;
+    Uint32 rb = (((s & 0x00FF00FFu) * a + (d & 0x00FF00FFu) * inv + 0x00800080u) >> 8) & 0x00FF00FFu;
+    Uint32 g = ((((s >> 8) & 0xFFu) * a + ((d >> 8) & 0xFFu) * inv + 0x80u) >> 8) & 0xFFu;
+    Uint32 outA = ((a << 8) + (d >> 24) * inv + 0x80u) >> 8;
+    return rb | (g << 8) | (outA << 24);
+}
+
+inline void blendSpan(Uint32* dst, int count, Uint32 color) {
+    Uint32 a = color >> 24;
+    if (a == 0) return;
+    if (a == 255) {
+        fillSpan(dst, count, color);
+        return;
+    }
+    int i = 0;
+#if defined(__SSE2__)
+    // Two pixels per 16-bit register, same arithmetic as blendPixel. Every lane stays below 65536.
+    __m128i zero = _mm_setzero_si128();
+    __m128i src = _mm_unpacklo_epi8(_mm_set1_epi32((int)color), zero);
+    __m128i mult = _mm_set_epi16(256, (short)a, (short)a, (short)a, 256, (short)a, (short)a, (short)a);
+    __m128i inv = _mm_set1_epi16((short)(255 - a));
+    __m128i srcTerm = _mm_add_epi16(_mm_mullo_epi16(src, mult), _mm_set1_epi16(128));
+    for (; i + 4 <= count; i += 4) {
+        __m128i d = _mm_loadu_si128((const __m128i*)(dst + i));
+        __m128i lo = _mm_srli_epi16(_mm_add_epi16(srcTerm, _mm_mullo_epi16(_mm_unpacklo_epi8(d, zero), inv)), 8);
+        __m128i hi = _mm_srli_epi16(_mm_add_epi16(srcTerm, _mm_mullo_epi16(_mm_unpackhi_epi8(d, zero), inv)), 8);
+        _mm_storeu_si128((__m128i*)(dst + i), _mm_packus_epi16(lo, hi));
+    }
+#endif
+    for (; i < count; ++i) dst[i] = blendPixel(dst[i], color, a);
+}
+
+class SoftRasterizer {
+public:
+    static const int tileSize = 64;
+
+    explicit SoftRasterizer(int threadCount = 0) : font(nullptr), blendPrimitives(false), stopping(false), generation(0),
+                                                   pendingWorkers(0), frameCommands(nullptr), target(nullptr) {
+        if (threadCount <= 0) threadCount = (int)std::thread::hardware_concurrency();
+        if (threadCount < 1) threadCount = 1;
+        // The calling thread works too, so start one fewer helper
+        for (int i = 1; i < threadCount; ++i) workers.emplace_back([this] { workerLoop(); });
+    }
+
+    ~SoftRasterizer() {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stopping = true;
+        }
+        wake.notify_all();
+        for (auto& t : workers) t.join();
+        releaseText();
+    }
+
+    void setFont(TTF_Font* f) { font = f; }
+
+    // Text from a baked atlas instead of the TTF font
+    void setBitmapFont(const BitmapFont* f, int pixelSize) {
+        bitmapFont = f;
+        bitmapFace = f ? f->face(pixelSize) : nullptr;
+    }
+
+    // SDL's default draw blend mode is NONE, so by default primitives overwrite like the
+    // SDL path does. Text and sprites always alpha blend, matching SDL textures.
+    void setBlendPrimitives(bool enabled) { blendPrimitives = enabled; }
+
+    // CPU images standing in for SDL textures referenced by sprite commands
+    void registerImage(SDL_Texture* key, const SoftFramebuffer* image) {
+        for (auto& img : images) {
+            if (img.first == key) {
+                img.second = image;
+                return;
+            }
+        }
+        images.push_back({ key, image });
+    }
+
+    int threadCount() const { return (int)workers.size() + 1; }
+
+    void render(RenderCommandBuffer& buffer, SoftFramebuffer& fb) {
+        PROFILE_ZONE("raster");
+        buffer.sort();
+        prepareText(buffer);
+
+        frameCommands = &buffer.all();
+        target = &fb;
+        tilesX = (fb.width + tileSize - 1) / tileSize;
+        tilesY = (fb.height + tileSize - 1) / tileSize;
+        nextTile.store(0);
+
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            pendingWorkers = (int)workers.size();
+            generation++;
+        }
+        wake.notify_all();
+        rasterizeTiles();
+
+        std::unique_lock<std::mutex> lock(mutex);
+        done.wait(lock, [this] { return pendingWorkers == 0; });
+        frameCommands = nullptr;
+    }
+
+private:
+    struct TextImage {
+        SDL_Surface* surface;
+        SDL_Surface* shadow;
+        int x, y;
+    };
+
+    TTF_Font* font;
+    const BitmapFont* bitmapFont = nullptr;
+    const BitmapFont::Face* bitmapFace = nullptr;
+    bool blendPrimitives;
+    std::vector<std::pair<SDL_Texture*, const SoftFramebuffer*>> images;
+    std::vector<TextImage> textImages;  // One per command, null surface for non-text
+
+    std::vector<std::thread> workers;
+    std::mutex mutex;
+    std::condition_variable wake;
+    std::condition_variable done;
+    bool stopping;
+    unsigned generation;
+    int pendingWorkers;
+
+    const std::vector<RenderCommand>* frameCommands;
+    SoftFramebuffer* target;
+    int tilesX, tilesY;
+    std::atomic<int> nextTile;
+
+    void workerLoop() {
+        unsigned seen = 0;
+        for (;;) {
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                wake.wait(lock, [&] { return stopping || generation != seen; });
+                if (stopping) return;
+                seen = generation;
+            }
+            rasterizeTiles();
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                pendingWorkers--;
+            }
+            done.notify_one();
+        }
+    }
+
+    void rasterizeTiles() {
+        int total = tilesX * tilesY;
+        for (int t = nextTile.fetch_add(1); t < total; t = nextTile.fetch_add(1)) {
+            SDL_Rect clip = { (t % tilesX) * tileSize, (t / tilesX) * tileSize, tileSize, tileSize };
+            if (clip.x + clip.w > target->width) clip.w = target->width - clip.x;
+            if (clip.y + clip.h > target->height) clip.h = target->height - clip.y;
+            const std::vector<RenderCommand>& cmds = *frameCommands;
+            for (size_t i = 0; i < cmds.size(); ++i) execute(cmds[i], i, clip);
+        }
+    }
+
+    // TTF isn't thread safe, so text is rasterized up front on the calling thread
+    void prepareText(const RenderCommandBuffer& buffer) {
+        releaseText();
+        const std::vector<RenderCommand>& cmds = buffer.all();
+        textImages.assign(cmds.size(), { nullptr, nullptr, 0, 0 });
+        if (!font && !bitmapFace) return;
+        for (size_t i = 0; i < cmds.size(); ++i) {
+            if (cmds[i].type != CmdText) continue;
+            SDL_Surface* surface = rasterizeText(buffer.textAt(cmds[i]), cmds[i].color);
+            if (!surface) continue;
+            SDL_Surface* shadow = (cmds[i].flags & TextShadow) ? rasterizeText(buffer.textAt(cmds[i]), { 0, 0, 0, 160 }) : nullptr;
+            int x = cmds[i].x, y = cmds[i].y;
+            if (cmds[i].flags & TextCentered) {
+                x -= surface->w / 2;
+                y -= surface->h / 2;
+            }
+            textImages[i] = { surface, shadow, x, y };
+        }
+    }
+
+    SDL_Surface* rasterizeText(const char* text, SDL_Color color) {
+        if (bitmapFace) return bitmapFont->rasterize(*bitmapFace, text, color);
+#ifdef SNAKE_NO_TTF
+        return nullptr;
+#else
+        SDL_Surface* raw = TTF_RenderText_Blended(font, text, color);
+        if (!raw) return nullptr;
+        SDL_Surface* surface = SDL_ConvertSurfaceFormat(raw, SDL_PIXELFORMAT_RGBA32, 0);
+        SDL_FreeSurface(raw);
+        return surface;
+#endif
+    }
+
+    void releaseText() {
+        for (auto& t : textImages) {
+            if (t.surface) SDL_FreeSurface(t.surface);
+            if (t.shadow) SDL_FreeSurface(t.shadow);
+        }
+        textImages.clear();
+    }
+
+    void span(int x0, int x1, int y, Uint32 color, const SDL_Rect& clip, bool blend) {
+        if (y < clip.y || y >= clip.y + clip.h) return;
+        if (x0 < clip.x) x0 = clip.x;
+        if (x1 > clip.x + clip.w) x1 = clip.x + clip.w;
+        if (x1 <= x0) return;
+        Uint32* dst = target->row(y) + x0;
+        if (blend) blendSpan(dst, x1 - x0, color);
+        else fillSpan(dst, x1 - x0, color);
+    }
+
+    void plot(int x, int y, Uint32 color, const SDL_Rect& clip, bool blend) {
+        if (x < clip.x || y < clip.y || x >= clip.x + clip.w || y >= clip.y + clip.h) return;
+        Uint32* dst = target->row(y) + x;
+        *dst = blend ? blendPixel(*dst, color, color >> 24) : color;
+    }
+
+    static bool overlaps(int x, int y, int w, int h, const SDL_Rect& clip) {
+        return x < clip.x + clip.w && x + w > clip.x && y < clip.y + clip.h && y + h > clip.y;
+    }
+
+    void execute(const RenderCommand& cmd, size_t index, const SDL_Rect& clip) {
+        Uint32 color = packRGBA(cmd.color);
+        bool blend = blendPrimitives;
+        switch (cmd.type) {
+            case CmdClear:
+                for (int y = clip.y; y < clip.y + clip.h; ++y) fillSpan(target->row(y) + clip.x, clip.w, color);
+                break;
+            case CmdFillRect:
+                if (!overlaps(cmd.x, cmd.y, cmd.w, cmd.h, clip)) break;
+                for (int y = cmd.y; y < cmd.y + cmd.h; ++y) span(cmd.x, cmd.x + cmd.w, y, color, clip, blend);
+                break;
+            case CmdRect:
+                if (!overlaps(cmd.x, cmd.y, cmd.w, cmd.h, clip) || cmd.w <= 0 || cmd.h <= 0) break;
+                span(cmd.x, cmd.x + cmd.w, cmd.y, color, clip, blend);
+                if (cmd.h > 1) span(cmd.x, cmd.x + cmd.w, cmd.y + cmd.h - 1, color, clip, blend);
+                for (int y = cmd.y + 1; y < cmd.y + cmd.h - 1; ++y) {
+                    plot(cmd.x, y, color, clip, blend);
+                    if (cmd.w > 1) plot(cmd.x + cmd.w - 1, y, color, clip, blend);
+                }
+                break;
+            case CmdLine:
+                drawLine(cmd.x, cmd.y, cmd.w, cmd.h, color, clip, blend);
+                break;
+            case CmdPoint:
+                plot(cmd.x, cmd.y, color, clip, blend);
+                break;
+            case CmdCircle:
+                if (overlaps(cmd.x - cmd.w, cmd.y - cmd.w, cmd.w * 2 + 1, cmd.w * 2 + 1, clip))
+                    drawCircle(cmd.x, cmd.y, cmd.w, color, color, false, clip, blend);
+                break;
+            case CmdFillCircle:
+                if (!overlaps(cmd.x - cmd.w, cmd.y - cmd.w, cmd.w * 2 + 1, cmd.w * 2 + 1, clip)) break;
+                for (int y = -cmd.w; y <= cmd.w; ++y) {
+                    int half = (int)std::sqrt((double)(cmd.w * cmd.w - y * y));
+                    span(cmd.x - half, cmd.x + half + 1, cmd.y + y, color, clip, blend);
+                }
+                break;
+            case CmdGlow:
+                drawGlow(cmd, clip, blend);
+                break;
+            case CmdText:
+                if (index < textImages.size() && textImages[index].surface) {
+                    const TextImage& t = textImages[index];
+                    if (t.shadow) {
+                        blitImage((const Uint32*)t.shadow->pixels, t.shadow->pitch / 4, t.shadow->w, t.shadow->h,
+                                  t.x + 2, t.y + 2, clip);
+                    }
+                    blitImage((const Uint32*)t.surface->pixels, t.surface->pitch / 4, t.surface->w, t.surface->h,
+                              t.x, t.y, clip);
+                }
+                break;
+            case CmdSprite: {
+                const SoftFramebuffer* image = nullptr;
+                for (auto& img : images) {
+                    if (img.first == cmd.texture) image = img.second;
+                }
+                if (image && image->width == cmd.w && image->height == cmd.h) {
+                    blitImage(image->pixels.data(), image->width, image->width, image->height, cmd.x, cmd.y, clip);
+                }
+                break;
+            }
+        }
+    }
+
+    void blitImage(const Uint32* src, int srcStride, int w, int h, int x, int y, const SDL_Rect& clip) {
+        if (!overlaps(x, y, w, h, clip)) return;
+        int y0 = std::max(y, clip.y), y1 = std::min(y + h, clip.y + clip.h);
+        int x0 = std::max(x, clip.x), x1 = std::min(x + w, clip.x + clip.w);
+        for (int py = y0; py < y1; ++py) {
+            const Uint32* s = src + (size_t)(py - y) * srcStride + (x0 - x);
+            Uint32* d = target->row(py) + x0;
+            for (int px = x0; px < x1; ++px, ++s, ++d) {
+                Uint32 a = *s >> 24;
+                if (a == 255) *d = *s;
+                else if (a) *d = blendPixel(*d, *s, a);
+            }
+        }
+    }
+
+    void drawLine(int x0, int y0, int x1, int y1, Uint32 color, const SDL_Rect& clip, bool blend) {
+        if (!overlaps(std::min(x0, x1), std::min(y0, y1), std::abs(x1 - x0) + 1, std::abs(y1 - y0) + 1, clip)) return;
+        if (y0 == y1) {
+            span(std::min(x0, x1), std::max(x0, x1) + 1, y0, color, clip, blend);
+            return;
+        }
+        int dx = std::abs(x1 - x0), sx = x0 < x1 ? 1 : -1;
+        int dy = -std::abs(y1 - y0), sy = y0 < y1 ? 1 : -1;
+        int err = dx + dy;
+        for (;;) {
+            plot(x0, y0, color, clip, blend);
+            if (x0 == x1 && y0 == y1) break;
+            int e2 = 2 * err;
+            if (e2 >= dy) { err += dy; x0 += sx; }
+            if (e2 <= dx) { err += dx; y0 += sy; }
+        }
+    }
+
+    // Midpoint circle, optionally plotting a second colour on top (the glow's white core)
+    void drawCircle(int cx, int cy, int radius, Uint32 color, Uint32 core, bool withCore, const SDL_Rect& clip, bool blend) {
+        int x = radius - 1;
+        int y = 0;
+        int dx = 1;
+        int dy = 1;
+        int err = dx - (radius << 1);
+
+        while (x >= y) {
+            const int px[8] = { cx + x, cx + y, cx - y, cx - x, cx - x, cx - y, cx + y, cx + x };
+            const int py[8] = { cy + y, cy + x, cy + x, cy + y, cy - y, cy - x, cy - x, cy - y };
+            for (int k = 0; k < 8; ++k) {
+                plot(px[k], py[k], color, clip, blend);
+                if (withCore) plot(px[k], py[k], core, clip, blend);
+            }
+
+            if (err <= 0) {
+                y++;
+                err += dy;
+                dy += 2;
+            }
+            if (err > 0) {
+                x--;
+                dx += 2;
+                err += dx - (radius << 1);
+            }
+        }
+    }
+
+    void drawGlow(const RenderCommand& cmd, const SDL_Rect& clip, bool blend) {
+        int radius = cmd.w;
+        if (!overlaps(cmd.x - radius, cmd.y - radius, radius * 2 + 1, radius * 2 + 1, clip)) return;
+        int alpha = cmd.color.a;
+        for (int r = radius; r > 0; r -= cmd.h) {
+            float intensity = (float)r / radius;
+            Uint8 a = (Uint8)((float)alpha * intensity * intensity);
+            SDL_Color mixed = { (Uint8)(cmd.color.r * (0.8 + 0.2 * intensity)),
+                                (Uint8)(cmd.color.g * (0.8 + 0.2 * intensity)),
+                                (Uint8)(cmd.color.b * (0.8 + 0.2 * intensity)), a };
+            Uint32 core = packRGBA({ 255, 255, 255, (Uint8)(a / 2) });
+            drawCircle(cmd.x, cmd.y, r, packRGBA(mixed), core, r < radius / 3, clip, blend);
+        }
+    }
+};
@@ -0,0 +1,99 @@
+#include <SDL2/SDL.h>
+#include <SDL2/SDL_ttf.h>
+#include <vector>
+#include <string>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <thread>
+#include "soft_raster.h"
+
+// Headless render benchmark: replays frame dumps (frame.rcb, written by pressing F9 in
+// snakev11) through the CPU rasterizer at increasing thread counts. No window, GPU or
+// browser is needed, so the numbers are reproducible on CI boxes.
+//
+//   soft_raster_bench [--iterations N] [--font arial.ttf] [--ppm out.ppm] frame.rcb...
+
+const int frameWidth = 800;
+const int frameHeight = 600;
+
+bool writePPM(const char* path, const SoftFramebuffer& fb) {
+    FILE* f = fopen(path, "wb");
+    if (!f) return false;
+    fprintf(f, "P6\n%d %d\n255\n", fb.width, fb.height);
+    for (Uint32 p : fb.pixels) {
+        unsigned char rgb[3] = { (unsigned char)(p & 0xFF), (unsigned char)((p >> 8) & 0xFF), (unsigned char)((p >> 16) & 0xFF) };
+        fwrite(rgb, 3, 1, f);
+    }
+    fclose(f);
+    return true;
+}
+
+int main(int argc, char* argv[]) {
+    int iterations = 200;
+    const char* fontPath = nullptr;
+    const char* ppmPath = nullptr;
+    std::vector<std::string> frames;
+
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--iterations" && i + 1 < argc) iterations = atoi(argv[++i]);
+        else if (arg == "--font" && i + 1 < argc) fontPath = argv[++i];
+        else if (arg == "--ppm" && i + 1 < argc) ppmPath = argv[++i];
+        else frames.push_back(arg);
+    }
+    if (frames.empty()) {
+        std::cerr << "usage: soft_raster_bench [--iterations N] [--font arial.ttf] [--ppm out.ppm] frame.rcb...\n";
+        return EXIT_FAILURE;
+    }
+
+    // Text needs SDL_ttf; without a font the text commands are skipped
+    TTF_Font* font = nullptr;
+    if (fontPath) {
+        TTF_Init();
+        font = TTF_OpenFont(fontPath, 24);
+        if (!font) std::cerr << "Failed to load font, text will be skipped\n";
+    }
+
+    std::vector<RenderCommandBuffer> buffers(frames.size());
+    for (size_t i = 0; i < frames.size(); ++i) {
+        if (!buffers[i].load(frames[i].c_str())) {
+            std::cerr << "Failed to load " << frames[i] << "\n";
+            return EXIT_FAILURE;
+        }
+    }
+
+    SoftFramebuffer fb;
+    fb.resize(frameWidth, frameHeight);
+    int maxThreads = (int)std::thread::hardware_concurrency();
+    if (maxThreads < 1) maxThreads = 1;
+
+    // Powers of two below the core count, then always all cores
+    std::vector<int> threadCounts;
+    for (int threads = 1; threads < maxThreads; threads *= 2) threadCounts.push_back(threads);
+    threadCounts.push_back(maxThreads);
+
+    printf("%-8s %12s %12s\n", "threads", "ms/frame", "commands");
+    for (int threads : threadCounts) {
+        SoftRasterizer raster(threads);
+        raster.setFont(font);
+        size_t commandCount = 0;
+        raster.render(buffers[0], fb); // Warm up caches and worker threads
+
+        Uint64 start = SDL_GetPerformanceCounter();
+        for (int it = 0; it < iterations; ++it) {
+            RenderCommandBuffer& buffer = buffers[it % buffers.size()];
+            raster.render(buffer, fb);
+            commandCount += buffer.size();
+        }
+        double ms = (SDL_GetPerformanceCounter() - start) * 1000.0 / SDL_GetPerformanceFrequency();
+        printf("%-8d %12.3f %12zu\n", threads, ms / iterations, commandCount / iterations);
+    }
+
+    if (ppmPath && !writePPM(ppmPath, fb)) std::cerr << "Failed to write " << ppmPath << "\n";
+    if (font) {
+        TTF_CloseFont(font);
+        TTF_Quit();
+    }
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,98 @@
+#pragma once
+#include <SDL2/SDL.h>
+#include <vector>
+#include <functional>
+#include <cstdio>
+
+// Staged startup. Instead of loading everything in the constructor before the main loop starts,
+// a game registers its loading work as stages and the main loop runs them a few milliseconds
+// per frame, drawing a loading frame meanwhile. The window shows something on the very first
+// frame; gameplay (and its countdown) starts as soon as the critical stages are done, and the
+// rest keeps loading behind it.
+//
+// A stage returns true when it has finished; one that returns false is called again next frame,
+// so long jobs can be split into slices. At least one stage runs every frame however slow it is.
+//
+//   startup.add("font", true, [this] { return loadFont(); });
+//   startup.add("high scores", false, [this] { loadHighScores(); return true; });
+//   ...
+//   startup.run();  // once per frame until done()
+
+class StartupStages {
+public:
+    explicit StartupStages(float frameBudgetMs = 8.0f) : budgetMs(frameBudgetMs), created(SDL_GetPerformanceCounter()) {}
+
+    bool quiet = false;  // No per-stage report when loading finishes, for tools whose output is data
+
+    // Critical stages run before the rest, in the order they were added
+    void add(const char* name, bool critical, std::function<bool()> work) {
+        Stage s = { name, critical, std::move(work), 0.0f, 0 };
+        auto it = stages.begin();
+        if (critical) {
+            while (it != stages.end() && it->critical) ++it;
+        } else {
+            it = stages.end();
+        }
+        stages.insert(it, std::move(s));
+    }
+
+    // Runs stages until this frame's budget is spent; true while anything is left
+    bool run() {
+        frames++;
+        Uint64 frameStart = SDL_GetPerformanceCounter();
+        while (next < stages.size()) {
+            Stage& s = stages[next];
+            Uint64 start = SDL_GetPerformanceCounter();
+            bool finished = s.work();
+            Uint64 end = SDL_GetPerformanceCounter();
+            s.ms += toMs(end - start);
+            if (finished) {
+                s.frame = frames;
+                next++;
+                if (criticalReady() && criticalMs < 0.0f) criticalMs = toMs(end - created);
+                if (done()) {
+                    doneMs = toMs(end - created);
+                    if (!quiet) report();
+                }
+            }
+            if (toMs(end - frameStart) >= budgetMs) break;
+        }
+        return !done();
+    }
+
+    bool done() const { return next == stages.size(); }
+
+    bool criticalReady() const { return next == stages.size() || !stages[next].critical; }
+
+    // Share of the stages finished, for a progress bar
+    float progress() const { return stages.empty() ? 1.0f : (float)next / stages.size(); }
+
+    // Name of the stage being worked on, nullptr when done
+    const char* current() const { return done() ? nullptr : stages[next].name; }
+
+private:
+    struct Stage {
+        const char* name;
+        bool critical;
+        std::function<bool()> work;
+        float ms;   // Time spent in the stage over all its frames
+        int frame;  // Frame it finished on
+    };
+
+    std::vector<Stage> stages;
+    size_t next = 0;
+    int frames = 0;
+    float budgetMs;
+    Uint64 created;
+    float criticalMs = -1.0f;
+    float doneMs = -1.0f;
+
+    static float toMs(Uint64 ticks) { return (float)(ticks * 1000.0 / (double)SDL_GetPerformanceFrequency()); }
+
+    void report() const {
+        printf("startup: playable after %.1f ms, loaded after %.1f ms over %d frames\n", criticalMs, doneMs, frames);
+        for (const Stage& s : stages) {
+            printf("  %-14s %7.2f ms  frame %d%s\n", s.name, s.ms, s.frame, s.critical ? "  critical" : "");
+        }
+    }
+};
@@ -0,0 +1,158 @@
+#pragma once
+#include <SDL2/SDL.h>
+#include <vector>
+#include <string>
+#include <atomic>
+#include <mutex>
+#include <cstdio>
+#include "file_export.h"
+
+// Chrome trace-event recorder (load the output in chrome://tracing or ui.perfetto.dev).
+// Each thread appends to its own single-producer ring, so recording never takes a lock;
+// flush() drains every ring into one JSON document, either to a file or, in the browser,
+// to a downloaded blob. Event names must be string literals or otherwise outlive the flush.
+
+class TraceRecorder {
+public:
+    static const Uint32 ringSize = 1 << 18;  // Events per thread (8 MB) between flushes
+
+    static TraceRecorder& instance() {
+        static TraceRecorder recorder;
+        return recorder;
+    }
+
+    void setRecording(bool on) {
+        if (on && !origin) origin = SDL_GetPerformanceCounter();
+        recording = on;
+    }
+    bool isRecording() const { return recording; }
+
+    // Name the calling thread in the viewer
+    void setThreadName(const char* name) { threadBuffer().name = name; }
+
+    // A finished span, in SDL performance-counter ticks
+    void complete(const char* name, Uint64 start, Uint64 end) {
+        if (recording) push({ name, start, end - start, 'X', 0 });
+    }
+
+    // A span that isn't tied to one thread's call stack (it may start before a frame and end
+    // several frames later); spans with the same name and id are drawn on their own track
+    void async(const char* name, Uint32 id, Uint64 start, Uint64 end) {
+        if (recording) push({ name, start, end - start, 'A', id });
+    }
+
+    // A point-in-time marker such as "apple eaten"
+    void instant(const char* name) {
+        if (recording) push({ name, SDL_GetPerformanceCounter(), 0, 'i', 0 });
+    }
+
+    // Drain every thread's events and write them out. Returns the number of events written.
+    size_t flush(const char* fileName) {
+        std::string json;
+        size_t written = drain(json);
+        exportFile(fileName, json, "application/json");
+        return written;
+    }
+
+    // Drain every thread's events into one JSON document, for callers that write it themselves
+    size_t drain(std::string& json) {
+        json = "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+        size_t written = 0;
+        double toMicros = 1000000.0 / (double)SDL_GetPerformanceFrequency();
+        char line[256];
+        std::lock_guard<std::mutex> lock(threadsMutex);
+        for (size_t t = 0; t < threads.size(); ++t) {
+            ThreadBuffer& buffer = *threads[t];
+            int tid = (int)t + 1;
+            if (buffer.name) {
+                snprintf(line, sizeof(line), "{\"ph\":\"M\",\"name\":\"thread_name\",\"pid\":1,\"tid\":%d,\"args\":{\"name\":\"%s\"}},\n",
+                         tid, buffer.name);
+                json += line;
+            }
+            Uint32 read = buffer.readIndex.load(std::memory_order_relaxed);
+            Uint32 write = buffer.writeIndex.load(std::memory_order_acquire);
+            for (; read != write; ++read) {
+                const Event& e = buffer.events[read & (ringSize - 1)];
+                double ts = e.start >= origin ? (e.start - origin) * toMicros : 0.0;
+                if (e.phase == 'X') {
+                    snprintf(line, sizeof(line), "{\"ph\":\"X\",\"name\":\"%s\",\"pid\":1,\"tid\":%d,\"ts\":%.3f,\"dur\":%.3f},\n",
+                             e.name, tid, ts, e.duration * toMicros);
+                } else if (e.phase == 'A') {
+                    snprintf(line, sizeof(line),
+                             "{\"ph\":\"b\",\"cat\":\"latency\",\"id\":%u,\"name\":\"%s\",\"pid\":1,\"tid\":%d,\"ts\":%.3f},\n"
+                             "{\"ph\":\"e\",\"cat\":\"latency\",\"id\":%u,\"name\":\"%s\",\"pid\":1,\"tid\":%d,\"ts\":%.3f},\n",
+                             e.id, e.name, tid, ts, e.id, e.name, tid, ts + e.duration * toMicros);
+                } else {
+                    snprintf(line, sizeof(line), "{\"ph\":\"i\",\"s\":\"g\",\"name\":\"%s\",\"pid\":1,\"tid\":%d,\"ts\":%.3f},\n",
+                             e.name, tid, ts);
+                }
+                json += line;
+                written++;
+            }
+            buffer.readIndex.store(read, std::memory_order_release);
+            if (buffer.dropped.load(std::memory_order_relaxed)) {
+                fprintf(stderr, "trace: thread %d dropped %u events (ring full)\n", tid, buffer.dropped.exchange(0));
+            }
+        }
+        if (json.size() > 2 && json[json.size() - 2] == ',') json.erase(json.size() - 2, 1);
+        json += "]}\n";
+        return written;
+    }
+
+private:
+    struct Event {
+        const char* name;
+        Uint64 start;
+        Uint64 duration;
+        char phase;
+        Uint32 id;  // Async spans only
+    };
+
+    struct ThreadBuffer {
+        std::vector<Event> events;  // Empty until the thread's first event
+        std::atomic<Uint32> writeIndex{ 0 };
+        std::atomic<Uint32> readIndex{ 0 };
+        std::atomic<Uint32> dropped{ 0 };
+        const char* name = nullptr;
+    };
+
+    std::atomic<bool> recording{ false };
+    Uint64 origin = 0;
+    std::vector<ThreadBuffer*> threads;  // Never freed; a thread's events can outlive it
+    std::mutex threadsMutex;             // Only taken on a thread's first event and by flush()
+
+    ThreadBuffer& threadBuffer() {
+        thread_local ThreadBuffer* buffer = nullptr;
+        if (!buffer) {
+            buffer = new ThreadBuffer();
+            std::lock_guard<std::mutex> lock(threadsMutex);
+            threads.push_back(buffer);
+        }
+        return *buffer;
+    }
+
+    void push(const Event& e) {
+        ThreadBuffer& buffer = threadBuffer();
+        // The ring is allocated by the first event, so threads that never record don't pay for it;
+        // drain() only reads it after seeing that event's writeIndex
+        if (buffer.events.empty()) buffer.events.resize(ringSize);
+        Uint32 write = buffer.writeIndex.load(std::memory_order_relaxed);
+        if (write - buffer.readIndex.load(std::memory_order_acquire) >= ringSize) {
+            buffer.dropped.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+        buffer.events[write & (ringSize - 1)] = e;
+        buffer.writeIndex.store(write + 1, std::memory_order_release);
+    }
+};
+
+// Times a scope on any thread straight into the trace, without going through the Profiler
+class TraceScope {
+public:
+    explicit TraceScope(const char* traceName) : name(traceName), start(SDL_GetPerformanceCounter()) {}
+    ~TraceScope() { TraceRecorder::instance().complete(name, start, SDL_GetPerformanceCounter()); }
+
+private:
+    const char* name;
+    Uint64 start;
+};